@@ -4,7 +4,14 @@
 
 pushd build
 @for %%i in (*.*) do if not "%%i"=="SDL2.dll" if not "%%i"=="clear.bat"  if not "%%i"=="baran_logo.bmp"  if not "%%i"=="libfreetype-6.dll"  if not "%%i"=="SDL2_ttf.dll" if not "%%i"=="zlib1.dll" del /q "%%i"
-@cl -Zi /Febuild.exe %~dp0source\main.c /I %~dp0include /link /LIBPATH:%~dp0lib SDL2_ttf.lib SDL2.lib SDL2main.lib Shell32.lib /SUBSYSTEM:CONSOLE
+@cl -O2 -Zi /c %~dp0source\tetris_platform.c %~dp0source\tetris_board.c %~dp0source\tetris_rotation.c %~dp0source\tetris_random.c %~dp0source\tetris_core.c %~dp0source\tetris_batch.c %~dp0source\tetris_moves.c %~dp0source\tetris_perft.c %~dp0source\tetris_runner.c %~dp0source\tetris_replay.c %~dp0source\tetris_archive.c %~dp0source\tetris_verify.c %~dp0source\tetris_differential.c %~dp0source\tetris_render.c
+@lib /OUT:tetris_core.lib tetris_platform.obj tetris_board.obj tetris_rotation.obj tetris_random.obj tetris_core.obj tetris_batch.obj tetris_moves.obj tetris_perft.obj tetris_runner.obj tetris_replay.obj tetris_archive.obj tetris_verify.obj tetris_differential.obj tetris_render.obj
+@cl -Zi /Febuild.exe %~dp0source\main.c /I %~dp0include /link tetris_core.lib /LIBPATH:%~dp0lib SDL2_ttf.lib SDL2.lib SDL2main.lib Shell32.lib /SUBSYSTEM:CONSOLE
+@cl -O2 /Febenchmark.exe %~dp0source\benchmark.c tetris_core.lib
+@cl -O2 /Feheadless.exe %~dp0source\headless.c tetris_core.lib
+@cl -O2 /Feperft.exe %~dp0source\perft.c tetris_core.lib
+@cl -O2 /Fereplay.exe %~dp0source\replay.c tetris_core.lib
+@cl -O2 /Fedifferential.exe %~dp0source\differential.c tetris_core.lib
 start "" build.exe
 popd
 
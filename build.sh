@@ -0,0 +1,28 @@
+#!/bin/sh
+# Builds the SDL-free core library and the headless tools (Linux, MacOS).
+# The game itself still needs SDL2 and SDL_TTF, see build.bat for Windows.
+set -e
+
+cd "$(dirname "$0")"
+
+CC=${CC:-cc}
+# -march=native turns on the AVX2 kernels of the batch engine where the CPU has them:
+CFLAGS=${CFLAGS:-"-O2 -march=native -std=gnu11 -Wall"}
+CORE_SOURCES="tetris_platform tetris_board tetris_rotation tetris_random tetris_core tetris_batch tetris_moves tetris_perft tetris_runner tetris_replay tetris_archive tetris_verify tetris_differential tetris_render"
+
+mkdir -p build
+CORE_OBJECTS=""
+
+for source in $CORE_SOURCES
+do
+	$CC $CFLAGS -c source/$source.c -o build/$source.o
+	CORE_OBJECTS="$CORE_OBJECTS build/$source.o"
+done
+
+ar rcs build/libtetris_core.a $CORE_OBJECTS
+
+$CC $CFLAGS -o build/benchmark source/benchmark.c build/libtetris_core.a -lm -pthread
+$CC $CFLAGS -o build/headless source/headless.c build/libtetris_core.a -lm -pthread
+$CC $CFLAGS -o build/perft source/perft.c build/libtetris_core.a -lm -pthread
+$CC $CFLAGS -o build/replay source/replay.c build/libtetris_core.a -lm -pthread
+$CC $CFLAGS -o build/differential source/differential.c build/libtetris_core.a -lm -pthread
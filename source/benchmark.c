@@ -0,0 +1,1193 @@
+/* ISMET BARAN SURUCU -- github.com/baransrc */
+#include "tetris_util.h"
+#include "tetris_board.h"
+#include "tetris_core.h"
+#include "tetris_batch.h"
+#include "tetris_runner.h"
+#include "tetris_moves.h"
+#include "tetris_platform.h"
+#include "tetris_render.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define BENCHMARK_BOARD_COUNT 64
+#define BENCHMARK_QUERY_COUNT 4096
+#define BENCHMARK_COLLISION_ROUNDS 2000
+#define BENCHMARK_LINE_CLEAR_ROUNDS 200000
+#define BENCHMARK_SHAPE_ROUNDS 2000
+#define BENCHMARK_LANDING_ROUNDS 500
+#define BENCHMARK_FEATURE_ROUNDS 20000
+#define BENCHMARK_FEATURE_PIECES 40
+#define BENCHMARK_ROTATION_ROUNDS 500
+#define BENCHMARK_GRAVITY_TICKS (1 << 21)
+#define BENCHMARK_PIECE_COUNT (1 << 24)
+#define BENCHMARK_SNAPSHOT_TICKS 600
+#define BENCHMARK_SNAPSHOT_ROUNDS (1 << 20)
+#define BENCHMARK_REPLAY_ROUNDS 2000
+#define BENCHMARK_POSITION_COUNT 256
+#define BENCHMARK_MOVE_ROUNDS 40
+#define BENCHMARK_MAX_PATH_LENGTH 256
+#define BENCHMARK_BATCH_LANE_TICKS (1 << 23)
+#define BENCHMARK_INPUT_COUNT (1 << 16)
+#define BENCHMARK_BATCH_WARMUP_STEPS 4096
+#define BENCHMARK_BATCH_MIN_STEPS 1024
+#define BENCHMARK_RUNNER_GAME_COUNT 20000
+#define BENCHMARK_RUNNER_SEED 1234
+#define BENCHMARK_RENDER_FRAMES 4096
+
+// Utils ------------------------
+void fill_random_board(Board*, int, int);
+Tetromino random_tetromino(void);
+void print_result(const char*, double, double, uint64_t);
+void put_tetromino_cells_by_definition(Board*, Tetromino, uint8_t);
+Extents find_extents_by_definition(Tetromino);
+uint32_t evaluate_board_by_cells(const Board*);
+uint32_t evaluate_board_by_features(const Board*);
+// ------------------------------
+
+// Benchmarks -------------------
+void benchmark_collision(void);
+void benchmark_line_clear(void);
+void benchmark_shape_table(void);
+void benchmark_landing(void);
+void benchmark_board_features(void);
+void benchmark_rotation(void);
+void benchmark_gravity(void);
+void benchmark_piece_generation(void);
+void benchmark_snapshot(void);
+void benchmark_move_generation(void);
+void benchmark_batch_engine(void);
+void benchmark_runner_scaling(void);
+void benchmark_render_commands(void);
+// ------------------------------
+
+int main(int argc, char* args[])
+{
+	// Fixed seed so every run measures the same boards:
+	srand(1234);
+
+	initialize_tetromino_shapes();
+
+	benchmark_collision();
+	benchmark_line_clear();
+	benchmark_shape_table();
+	benchmark_landing();
+	benchmark_board_features();
+	benchmark_rotation();
+	benchmark_gravity();
+	benchmark_piece_generation();
+	benchmark_snapshot();
+	benchmark_move_generation();
+	benchmark_batch_engine();
+	benchmark_runner_scaling();
+	benchmark_render_commands();
+
+	return 0;
+}
+
+void fill_random_board(Board* board, int filled_height, int fill_percentage)
+{
+	clear_board(board);
+
+	for (int j = 0; j < filled_height; ++j)
+	{
+		for (int i = 0; i < BOARD_WIDTH; ++i)
+		{
+			if ((rand() % 100) < fill_percentage)
+			{
+				set_board_cell(board, i, j, (uint8_t)(rand() % TETROMINO_TYPE_COUNT));
+			}
+		}
+	}
+}
+
+Tetromino random_tetromino(void)
+{
+	// Positions go one cell beyond the walls, as input does before clamping:
+	Tetromino tetromino = {
+		.pivot_position = {.x = (int16_t)(rand() % (BOARD_WIDTH + 2)) - 1, .y = (int16_t)(rand() % BOARD_HEIGHT)},
+		.rotation = (uint8_t)(rand() % TETROMINO_ROTATION_COUNT),
+		.type = (enum Tetromino_Type)(rand() % TETROMINO_TYPE_COUNT),
+	};
+
+	return tetromino;
+}
+
+void print_result(const char* name, double seconds, double baseline_seconds, uint64_t operations)
+{
+	printf("%-28s %10.2f ns/op %8.2fx\n", name, (seconds * 1e9) / (double)operations, baseline_seconds / seconds);
+}
+
+void put_tetromino_cells_by_definition(Board* board, Tetromino tetromino, uint8_t value)
+{
+	// How tetrominoes were written before shape tables, walking the whole 5x5 definition:
+	for (size_t i = 0; i < MAX_TETROMINO_WIDTH; ++i)
+	{
+		for (size_t j = 0; j < MAX_TETROMINO_HEIGHT; ++j)
+		{
+			if (TETROMINOES[tetromino.type][tetromino.rotation][j][i] == 0)
+			{
+				continue;
+			}
+
+			int board_x = tetromino.pivot_position.x + (int)i - TETROMINO_PIVOT_X;
+			int board_y = tetromino.pivot_position.y - ((int)j - TETROMINO_PIVOT_Y);
+
+			set_board_cell(board, board_x, board_y, value);
+		}
+	}
+}
+
+Extents find_extents_by_definition(Tetromino tetromino)
+{
+	Extents extents = {.min_x = 0, .min_y = 0, .max_x = 0, .max_y = 0};
+
+	for (size_t i = 0; i < MAX_TETROMINO_WIDTH; ++i)
+	{
+		for (size_t j = 0; j < MAX_TETROMINO_HEIGHT; ++j)
+		{
+			if (TETROMINOES[tetromino.type][tetromino.rotation][j][i] == 0)
+			{
+				continue;
+			}
+
+			int16_t offset_x = (int16_t)i - TETROMINO_PIVOT_X;
+			int16_t offset_y = (int16_t)j - TETROMINO_PIVOT_Y;
+
+			extents.max_x = max(offset_x, extents.max_x);
+			extents.min_x = min(offset_x, extents.min_x);
+			extents.max_y = max(offset_y, extents.max_y);
+			extents.min_y = min(offset_y, extents.min_y);
+		}
+	}
+
+	return extents;
+}
+
+uint32_t evaluate_board_by_cells(const Board* board)
+{
+	// What an evaluator had to do before boards kept their features, walk every cell:
+	uint32_t heights[BOARD_WIDTH];
+	uint32_t value = 0;
+
+	for (int i = 0; i < BOARD_WIDTH; ++i)
+	{
+		uint32_t holes = 0;
+
+		heights[i] = 0;
+
+		for (int j = BOARD_HEIGHT - 1; j >= 0; --j)
+		{
+			bool is_empty = get_board_cell(board, i, j) == EMPTY_CELL_TYPE;
+
+			if (!is_empty && heights[i] == 0)
+			{
+				heights[i] = j + 1;
+			}
+			else if (is_empty && heights[i] != 0)
+			{
+				holes++;
+			}
+		}
+
+		value += heights[i] + 32 * holes;
+	}
+
+	for (int i = 0; i < BOARD_WIDTH; ++i)
+	{
+		int left = (i > 0) ? (int)heights[i - 1] : BOARD_HEIGHT;
+		int right = (i < BOARD_WIDTH - 1) ? (int)heights[i + 1] : BOARD_HEIGHT;
+
+		value += 1024 * (uint32_t)max(min(left, right) - (int)heights[i], 0);
+	}
+
+	for (int j = 0; j < BOARD_HEIGHT; ++j)
+	{
+		uint32_t count = 0;
+
+		for (int i = 0; i < BOARD_WIDTH; ++i)
+		{
+			count += get_board_cell(board, i, j) != EMPTY_CELL_TYPE;
+		}
+
+		value += count * (j + 1) * 65536;
+	}
+
+	return value;
+}
+
+uint32_t evaluate_board_by_features(const Board* board)
+{
+	uint32_t value = 32 * board->hole_count;
+
+	for (int i = 0; i < BOARD_WIDTH; ++i)
+	{
+		value += board->column_heights[i] + 1024 * board->well_depths[i];
+	}
+
+	for (int j = 0; j < BOARD_HEIGHT; ++j)
+	{
+		value += board->row_counts[j] * (j + 1) * 65536;
+	}
+
+	return value;
+}
+
+void benchmark_collision(void)
+{
+	static Board boards[BENCHMARK_BOARD_COUNT];
+	static Tetromino queries[BENCHMARK_QUERY_COUNT];
+	uint64_t operations = (uint64_t)BENCHMARK_COLLISION_ROUNDS * BENCHMARK_QUERY_COUNT;
+	uint64_t reference_collisions = 0;
+	uint64_t bitboard_collisions = 0;
+
+	for (size_t i = 0; i < BENCHMARK_BOARD_COUNT; ++i)
+	{
+		fill_random_board(&boards[i], 4 + rand() % 12, 70);
+	}
+
+	for (size_t i = 0; i < BENCHMARK_QUERY_COUNT; ++i)
+	{
+		queries[i] = random_tetromino();
+	}
+
+	double time_start = get_time_in_seconds();
+
+	for (size_t round = 0; round < BENCHMARK_COLLISION_ROUNDS; ++round)
+	{
+		for (size_t i = 0; i < BENCHMARK_QUERY_COUNT; ++i)
+		{
+			reference_collisions += does_tetromino_collide_reference(&boards[i % BENCHMARK_BOARD_COUNT], queries[i]);
+		}
+	}
+
+	double reference_seconds = get_time_in_seconds() - time_start;
+
+	time_start = get_time_in_seconds();
+
+	for (size_t round = 0; round < BENCHMARK_COLLISION_ROUNDS; ++round)
+	{
+		for (size_t i = 0; i < BENCHMARK_QUERY_COUNT; ++i)
+		{
+			bitboard_collisions += does_tetromino_collide(&boards[i % BENCHMARK_BOARD_COUNT], queries[i]);
+		}
+	}
+
+	double bitboard_seconds = get_time_in_seconds() - time_start;
+
+	printf("--- Collision (%llu queries) ---\n", (unsigned long long)operations);
+	print_result("cell scan", reference_seconds, reference_seconds, operations);
+	print_result("row bitmask", bitboard_seconds, reference_seconds, operations);
+
+	if (reference_collisions != bitboard_collisions)
+	{
+		printf("MISMATCH: cell scan found %llu collisions, row bitmask found %llu\n", (unsigned long long)reference_collisions, (unsigned long long)bitboard_collisions);
+	}
+}
+
+void benchmark_line_clear(void)
+{
+	static Board boards[BENCHMARK_BOARD_COUNT];
+	uint64_t operations = BENCHMARK_LINE_CLEAR_ROUNDS;
+	uint64_t reference_rows = 0;
+	uint64_t bitboard_rows = 0;
+	Board board;
+
+	// Boards with a few full rows mixed into a dense stack:
+	for (size_t i = 0; i < BENCHMARK_BOARD_COUNT; ++i)
+	{
+		fill_random_board(&boards[i], 12, 80);
+
+		for (int line = 0; line < 4; ++line)
+		{
+			int y = rand() % 12;
+
+			for (int x = 0; x < BOARD_WIDTH; ++x)
+			{
+				set_board_cell(&boards[i], x, y, TETROMINO_TYPE_I);
+			}
+		}
+	}
+
+	double time_start = get_time_in_seconds();
+
+	for (size_t round = 0; round < BENCHMARK_LINE_CLEAR_ROUNDS; ++round)
+	{
+		board = boards[round % BENCHMARK_BOARD_COUNT];
+		reference_rows += clear_full_board_rows_reference(&board);
+	}
+
+	double reference_seconds = get_time_in_seconds() - time_start;
+
+	time_start = get_time_in_seconds();
+
+	for (size_t round = 0; round < BENCHMARK_LINE_CLEAR_ROUNDS; ++round)
+	{
+		board = boards[round % BENCHMARK_BOARD_COUNT];
+		bitboard_rows += clear_full_board_rows(&board);
+	}
+
+	double bitboard_seconds = get_time_in_seconds() - time_start;
+
+	printf("--- Line clear (%llu boards) ---\n", (unsigned long long)operations);
+	print_result("cell scan", reference_seconds, reference_seconds, operations);
+	print_result("row bitmask", bitboard_seconds, reference_seconds, operations);
+
+	if (reference_rows != bitboard_rows)
+	{
+		printf("MISMATCH: cell scan and row bitmask cleared different rows\n");
+	}
+}
+
+void benchmark_shape_table(void)
+{
+	static Tetromino queries[BENCHMARK_QUERY_COUNT];
+	uint64_t operations = (uint64_t)BENCHMARK_SHAPE_ROUNDS * BENCHMARK_QUERY_COUNT;
+	int64_t definition_checksum = 0;
+	int64_t table_checksum = 0;
+	Board board;
+
+	clear_board(&board);
+
+	// Only states that fit on the board, so they can be written:
+	for (size_t i = 0; i < BENCHMARK_QUERY_COUNT; ++i)
+	{
+		do
+		{
+			queries[i] = random_tetromino();
+		} while (does_tetromino_collide(&board, queries[i]));
+	}
+
+	double time_start = get_time_in_seconds();
+
+	for (size_t round = 0; round < BENCHMARK_SHAPE_ROUNDS; ++round)
+	{
+		for (size_t i = 0; i < BENCHMARK_QUERY_COUNT; ++i)
+		{
+			put_tetromino_cells_by_definition(&board, queries[i], queries[i].type);
+			put_tetromino_cells_by_definition(&board, queries[i], EMPTY_CELL_TYPE);
+		}
+	}
+
+	double definition_put_seconds = get_time_in_seconds() - time_start;
+
+	time_start = get_time_in_seconds();
+
+	for (size_t round = 0; round < BENCHMARK_SHAPE_ROUNDS; ++round)
+	{
+		for (size_t i = 0; i < BENCHMARK_QUERY_COUNT; ++i)
+		{
+			put_tetromino_cells(&board, queries[i]);
+			delete_tetromino_cells(&board, queries[i]);
+		}
+	}
+
+	double table_put_seconds = get_time_in_seconds() - time_start;
+
+	time_start = get_time_in_seconds();
+
+	for (size_t round = 0; round < BENCHMARK_SHAPE_ROUNDS; ++round)
+	{
+		for (size_t i = 0; i < BENCHMARK_QUERY_COUNT; ++i)
+		{
+			Extents extents = find_extents_by_definition(queries[i]);
+			definition_checksum += extents.min_x + 3 * extents.max_x + 5 * extents.min_y + 7 * extents.max_y;
+		}
+	}
+
+	double definition_extents_seconds = get_time_in_seconds() - time_start;
+
+	time_start = get_time_in_seconds();
+
+	for (size_t round = 0; round < BENCHMARK_SHAPE_ROUNDS; ++round)
+	{
+		for (size_t i = 0; i < BENCHMARK_QUERY_COUNT; ++i)
+		{
+			Extents extents = get_tetromino_shape(queries[i])->extents;
+			table_checksum += extents.min_x + 3 * extents.max_x + 5 * extents.min_y + 7 * extents.max_y;
+		}
+	}
+
+	double table_extents_seconds = get_time_in_seconds() - time_start;
+
+	printf("--- Put and delete tetromino (%llu pairs) ---\n", (unsigned long long)operations);
+	print_result("5x5 definition", definition_put_seconds, definition_put_seconds, operations);
+	print_result("shape table", table_put_seconds, definition_put_seconds, operations);
+
+	printf("--- Tetromino extents (%llu queries) ---\n", (unsigned long long)operations);
+	print_result("5x5 definition", definition_extents_seconds, definition_extents_seconds, operations);
+	print_result("shape table", table_extents_seconds, definition_extents_seconds, operations);
+
+	if (definition_checksum != table_checksum)
+	{
+		printf("MISMATCH: 5x5 definition and shape table extents differ\n");
+	}
+}
+
+void benchmark_landing(void)
+{
+	static Board boards[BENCHMARK_BOARD_COUNT];
+	static Tetromino queries[BENCHMARK_QUERY_COUNT];
+	uint64_t operations = (uint64_t)BENCHMARK_LANDING_ROUNDS * BENCHMARK_QUERY_COUNT;
+	uint64_t loop_checksum = 0;
+	uint64_t column_checksum = 0;
+
+	for (size_t i = 0; i < BENCHMARK_BOARD_COUNT; ++i)
+	{
+		fill_random_board(&boards[i], 4 + rand() % 12, 70);
+	}
+
+	// Only tetrominoes that fit where they are, like a falling one:
+	for (size_t i = 0; i < BENCHMARK_QUERY_COUNT; ++i)
+	{
+		do
+		{
+			queries[i] = random_tetromino();
+		}
+		while (does_tetromino_collide(&boards[i % BENCHMARK_BOARD_COUNT], queries[i]));
+	}
+
+	double time_start = get_time_in_seconds();
+
+	for (size_t round = 0; round < BENCHMARK_LANDING_ROUNDS; ++round)
+	{
+		for (size_t i = 0; i < BENCHMARK_QUERY_COUNT; ++i)
+		{
+			// How determine_current_destination used to do it, one row per collision test:
+			Tetromino tetromino = queries[i];
+
+			while (!does_tetromino_collide(&boards[i % BENCHMARK_BOARD_COUNT], tetromino))
+			{
+				tetromino.pivot_position.y--;
+			}
+
+			loop_checksum += tetromino.pivot_position.y + 1;
+		}
+	}
+
+	double loop_seconds = get_time_in_seconds() - time_start;
+
+	time_start = get_time_in_seconds();
+
+	for (size_t round = 0; round < BENCHMARK_LANDING_ROUNDS; ++round)
+	{
+		for (size_t i = 0; i < BENCHMARK_QUERY_COUNT; ++i)
+		{
+			column_checksum += find_landing_y(&boards[i % BENCHMARK_BOARD_COUNT], queries[i]);
+		}
+	}
+
+	double column_seconds = get_time_in_seconds() - time_start;
+
+	printf("--- Landing row (%llu queries) ---\n", (unsigned long long)operations);
+	print_result("collision per row", loop_seconds, loop_seconds, operations);
+	print_result("column bits", column_seconds, loop_seconds, operations);
+
+	if (loop_checksum != column_checksum)
+	{
+		printf("MISMATCH: landing rows differ between collision loop and column bits\n");
+	}
+}
+
+void benchmark_board_features(void)
+{
+	static Board boards[BENCHMARK_BOARD_COUNT];
+	uint64_t operations = (uint64_t)BENCHMARK_FEATURE_ROUNDS * BENCHMARK_BOARD_COUNT;
+	uint64_t cell_checksum = 0;
+	uint64_t feature_checksum = 0;
+	uint32_t mismatch_count = 0;
+
+	// Stacks built by dropping pieces and clearing lines, so features are only ever updated incrementally:
+	for (size_t i = 0; i < BENCHMARK_BOARD_COUNT; ++i)
+	{
+		clear_board(&boards[i]);
+
+		for (int piece = 0; piece < BENCHMARK_FEATURE_PIECES; ++piece)
+		{
+			Tetromino tetromino = random_tetromino();
+
+			tetromino.pivot_position.y = BOARD_HEIGHT - 3;
+
+			if (does_tetromino_collide(&boards[i], tetromino))
+			{
+				continue;
+			}
+
+			tetromino.pivot_position.y = find_landing_y(&boards[i], tetromino);
+			put_tetromino_cells(&boards[i], tetromino);
+
+			Extents extents = get_tetromino_shape(tetromino)->extents;
+			clear_full_board_rows_between(&boards[i], tetromino.pivot_position.y - extents.max_y, tetromino.pivot_position.y - extents.min_y);
+		}
+
+		mismatch_count += evaluate_board_by_cells(&boards[i]) != evaluate_board_by_features(&boards[i]);
+	}
+
+	double time_start = get_time_in_seconds();
+
+	for (size_t round = 0; round < BENCHMARK_FEATURE_ROUNDS; ++round)
+	{
+		for (size_t i = 0; i < BENCHMARK_BOARD_COUNT; ++i)
+		{
+			cell_checksum += evaluate_board_by_cells(&boards[i]);
+		}
+	}
+
+	double cell_seconds = get_time_in_seconds() - time_start;
+
+	time_start = get_time_in_seconds();
+
+	for (size_t round = 0; round < BENCHMARK_FEATURE_ROUNDS; ++round)
+	{
+		for (size_t i = 0; i < BENCHMARK_BOARD_COUNT; ++i)
+		{
+			feature_checksum += evaluate_board_by_features(&boards[i]);
+		}
+	}
+
+	double feature_seconds = get_time_in_seconds() - time_start;
+
+	printf("--- Board features (%llu evaluations) ---\n", (unsigned long long)operations);
+	print_result("cell scan", cell_seconds, cell_seconds, operations);
+	print_result("kept features", feature_seconds, cell_seconds, operations);
+
+	if (mismatch_count != 0 || cell_checksum != feature_checksum)
+	{
+		printf("MISMATCH: kept features differ from a cell scan on %u boards\n", mismatch_count);
+	}
+}
+
+void benchmark_rotation(void)
+{
+	static Board boards[BENCHMARK_BOARD_COUNT];
+	static Tetromino queries[BENCHMARK_QUERY_COUNT];
+	uint64_t operations = (uint64_t)BENCHMARK_ROTATION_ROUNDS * BENCHMARK_QUERY_COUNT;
+	uint64_t definition_checksum = 0;
+	uint64_t rotation_checksums[ROTATION_SYSTEM_COUNT] = {0};
+	double rotation_seconds[ROTATION_SYSTEM_COUNT];
+	static const char* rotation_names[ROTATION_SYSTEM_COUNT] = {"simple kick table", "srs kick table"};
+
+	for (size_t i = 0; i < BENCHMARK_BOARD_COUNT; ++i)
+	{
+		fill_random_board(&boards[i], 4 + rand() % 12, 70);
+	}
+
+	// Tetrominoes that fit, about to be turned clockwise:
+	for (size_t i = 0; i < BENCHMARK_QUERY_COUNT; ++i)
+	{
+		do
+		{
+			queries[i] = random_tetromino();
+		}
+		while (does_tetromino_collide(&boards[i % BENCHMARK_BOARD_COUNT], queries[i]));
+	}
+
+	double time_start = get_time_in_seconds();
+
+	for (size_t round = 0; round < BENCHMARK_ROTATION_ROUNDS; ++round)
+	{
+		for (size_t i = 0; i < BENCHMARK_QUERY_COUNT; ++i)
+		{
+			// How move_tetromino_for_rotation used to do it, overflow from the extents of the 5x5 definition:
+			const Board* board = &boards[i % BENCHMARK_BOARD_COUNT];
+			Tetromino tetromino = queries[i];
+
+			tetromino.rotation = (tetromino.rotation + 1) % TETROMINO_ROTATION_COUNT;
+
+			if (does_tetromino_collide(board, tetromino))
+			{
+				Extents extents = find_extents_by_definition(tetromino);
+				int higher_max_x = max(tetromino.pivot_position.x + extents.max_x - (BOARD_WIDTH - 1), 0);
+				int lower_min_x = min(tetromino.pivot_position.x + extents.min_x, 0);
+
+				tetromino.pivot_position.x -= (higher_max_x > 0) ? higher_max_x : lower_min_x;
+			}
+
+			if (!does_tetromino_collide(board, tetromino))
+			{
+				definition_checksum += tetromino.pivot_position.x * 64 + tetromino.pivot_position.y + 1;
+			}
+		}
+	}
+
+	double definition_seconds = get_time_in_seconds() - time_start;
+
+	for (size_t rotation_system = 0; rotation_system < ROTATION_SYSTEM_COUNT; ++rotation_system)
+	{
+		time_start = get_time_in_seconds();
+
+		for (size_t round = 0; round < BENCHMARK_ROTATION_ROUNDS; ++round)
+		{
+			for (size_t i = 0; i < BENCHMARK_QUERY_COUNT; ++i)
+			{
+				const Board* board = &boards[i % BENCHMARK_BOARD_COUNT];
+				Tetromino tetromino = queries[i];
+
+				tetromino.rotation = (tetromino.rotation + 1) % TETROMINO_ROTATION_COUNT;
+
+				if (kick_rotated_tetromino(board, &tetromino, (enum Rotation_System)rotation_system))
+				{
+					rotation_checksums[rotation_system] += tetromino.pivot_position.x * 64 + tetromino.pivot_position.y + 1;
+				}
+			}
+		}
+
+		rotation_seconds[rotation_system] = get_time_in_seconds() - time_start;
+	}
+
+	printf("--- Rotate with kicks (%llu rotations) ---\n", (unsigned long long)operations);
+	print_result("5x5 definition push", definition_seconds, definition_seconds, operations);
+
+	for (size_t rotation_system = 0; rotation_system < ROTATION_SYSTEM_COUNT; ++rotation_system)
+	{
+		print_result(rotation_names[rotation_system], rotation_seconds[rotation_system], definition_seconds, operations);
+	}
+
+	if (definition_checksum != rotation_checksums[ROTATION_SYSTEM_SIMPLE])
+	{
+		printf("MISMATCH: simple kick table and 5x5 definition push rotate differently\n");
+	}
+}
+
+void benchmark_gravity(void)
+{
+	static uint8_t inputs[BENCHMARK_INPUT_COUNT];
+	static const char* names[] = {"level 0", "level 29", "20G"};
+	uint32_t gravities[] = {get_gravity(0), get_gravity(LEVEL_COUNT - 1), GRAVITY_20G};
+	double level_seconds = 0.0;
+
+	// Sideways moves and rotations only, gravity alone brings pieces down:
+	for (size_t i = 0; i < BENCHMARK_INPUT_COUNT; ++i)
+	{
+		int key = rand() % 8;
+		inputs[i] = (key == 0) ? INPUT_FLAG_LEFT : (key == 1) ? INPUT_FLAG_RIGHT : (key == 2) ? INPUT_FLAG_UP : 0;
+	}
+
+	printf("--- Gravity (%d ticks per run) ---\n", BENCHMARK_GRAVITY_TICKS);
+
+	for (size_t i = 0; i < sizeof(gravities) / sizeof(gravities[0]); ++i)
+	{
+		Game_State game_state;
+		Input_State input_state;
+		uint64_t seed = 1;
+		uint64_t piece_count = 0;
+
+		initialize_game_state(&game_state, seed, PIECE_RANDOMIZER_UNIFORM);
+		game_state.fixed_gravity = gravities[i];
+
+		double time_start = get_time_in_seconds();
+
+		for (size_t tick = 0; tick < BENCHMARK_GRAVITY_TICKS; ++tick)
+		{
+			set_input_flags(&input_state, inputs[tick % BENCHMARK_INPUT_COUNT]);
+			step_game(&game_state, &input_state);
+
+			piece_count += game_state.should_spawn_tetromino;
+
+			if (game_state.game_phase == GAME_PHASE_GAMEOVER)
+			{
+				initialize_game_state(&game_state, ++seed, PIECE_RANDOMIZER_UNIFORM);
+				game_state.fixed_gravity = gravities[i];
+			}
+		}
+
+		double seconds = get_time_in_seconds() - time_start;
+
+		if (i == 0)
+		{
+			level_seconds = seconds;
+		}
+
+		printf("%-28s %10.2f ns/tick %8.2fx %8.1f ticks/piece\n", names[i], (seconds * 1e9) / BENCHMARK_GRAVITY_TICKS, level_seconds / seconds, (double)BENCHMARK_GRAVITY_TICKS / (double)max(piece_count, 1));
+	}
+}
+
+void benchmark_piece_generation(void)
+{
+	uint64_t rand_checksum = 0;
+	uint64_t per_piece_checksum = 0;
+	uint64_t queue_checksum = 0;
+	uint64_t bag_checksum = 0;
+	Random_State random;
+	Piece_Queue piece_queue;
+
+	printf("--- Piece generation (%d pieces) ---\n", BENCHMARK_PIECE_COUNT);
+
+	double time_start = get_time_in_seconds();
+
+	for (size_t i = 0; i < BENCHMARK_PIECE_COUNT; ++i)
+	{
+		rand_checksum += rand() % TETROMINO_TYPE_COUNT;
+	}
+
+	double rand_seconds = get_time_in_seconds() - time_start;
+
+	seed_random(&random, 1);
+	time_start = get_time_in_seconds();
+
+	for (size_t i = 0; i < BENCHMARK_PIECE_COUNT; ++i)
+	{
+		per_piece_checksum += random_below(&random, TETROMINO_TYPE_COUNT);
+	}
+
+	double per_piece_seconds = get_time_in_seconds() - time_start;
+
+	seed_piece_queue(&piece_queue, 1, PIECE_RANDOMIZER_UNIFORM);
+	time_start = get_time_in_seconds();
+
+	for (size_t i = 0; i < BENCHMARK_PIECE_COUNT; ++i)
+	{
+		queue_checksum += next_piece(&piece_queue);
+	}
+
+	double queue_seconds = get_time_in_seconds() - time_start;
+
+	seed_piece_queue(&piece_queue, 1, PIECE_RANDOMIZER_BAG);
+	time_start = get_time_in_seconds();
+
+	for (size_t i = 0; i < BENCHMARK_PIECE_COUNT; ++i)
+	{
+		bag_checksum += next_piece(&piece_queue);
+	}
+
+	double bag_seconds = get_time_in_seconds() - time_start;
+
+	print_result("rand() % 7", rand_seconds, rand_seconds, BENCHMARK_PIECE_COUNT);
+	print_result("xoshiro per piece", per_piece_seconds, rand_seconds, BENCHMARK_PIECE_COUNT);
+	print_result("piece queue uniform", queue_seconds, rand_seconds, BENCHMARK_PIECE_COUNT);
+	print_result("piece queue 7-bag", bag_seconds, rand_seconds, BENCHMARK_PIECE_COUNT);
+
+	// Every type is equally likely, so all means should be close to 3:
+	printf("mean piece: rand %.3f, per piece %.3f, uniform %.3f, 7-bag %.3f\n", (double)rand_checksum / BENCHMARK_PIECE_COUNT, (double)per_piece_checksum / BENCHMARK_PIECE_COUNT, (double)queue_checksum / BENCHMARK_PIECE_COUNT, (double)bag_checksum / BENCHMARK_PIECE_COUNT);
+}
+
+void benchmark_snapshot(void)
+{
+	Game_State game_state;
+	Game_State fork;
+	Game_Snapshot snapshot;
+	Input_State input_state;
+	uint64_t checksum = 0;
+
+	reset_input_state(&input_state);
+
+	printf("--- Snapshot (game at tick %d, %d bytes) ---\n", BENCHMARK_SNAPSHOT_TICKS, (int)sizeof(Game_Snapshot));
+
+	// Without snapshots, getting back to a position means playing the game again from its seed:
+	double time_start = get_time_in_seconds();
+
+	for (size_t round = 0; round < BENCHMARK_REPLAY_ROUNDS; ++round)
+	{
+		initialize_game_state(&game_state, 1, PIECE_RANDOMIZER_UNIFORM);
+
+		for (size_t tick = 0; tick < BENCHMARK_SNAPSHOT_TICKS; ++tick)
+		{
+			step_game(&game_state, &input_state);
+		}
+
+		checksum += game_state.score + game_state.current_tetromino.pivot_position.y;
+	}
+
+	double replay_seconds = get_time_in_seconds() - time_start;
+
+	time_start = get_time_in_seconds();
+
+	for (size_t round = 0; round < BENCHMARK_SNAPSHOT_ROUNDS; ++round)
+	{
+		save_game_snapshot(&game_state, &snapshot);
+		checksum += snapshot.board.rows[round % BOARD_HEIGHT];
+	}
+
+	double save_seconds = get_time_in_seconds() - time_start;
+
+	time_start = get_time_in_seconds();
+
+	for (size_t round = 0; round < BENCHMARK_SNAPSHOT_ROUNDS; ++round)
+	{
+		restore_game_snapshot(&fork, &snapshot);
+		checksum += fork.board.rows[round % BOARD_HEIGHT];
+	}
+
+	double restore_seconds = get_time_in_seconds() - time_start;
+
+	time_start = get_time_in_seconds();
+
+	for (size_t round = 0; round < BENCHMARK_SNAPSHOT_ROUNDS; ++round)
+	{
+		fork_game_state(&fork, &game_state);
+		checksum += fork.board.rows[round % BOARD_HEIGHT];
+	}
+
+	double fork_seconds = get_time_in_seconds() - time_start;
+
+	print_result("replay from seed", replay_seconds, replay_seconds, BENCHMARK_REPLAY_ROUNDS);
+	print_result("save snapshot", save_seconds, replay_seconds * BENCHMARK_SNAPSHOT_ROUNDS / BENCHMARK_REPLAY_ROUNDS, BENCHMARK_SNAPSHOT_ROUNDS);
+	print_result("restore snapshot", restore_seconds, replay_seconds * BENCHMARK_SNAPSHOT_ROUNDS / BENCHMARK_REPLAY_ROUNDS, BENCHMARK_SNAPSHOT_ROUNDS);
+	print_result("fork game state", fork_seconds, replay_seconds * BENCHMARK_SNAPSHOT_ROUNDS / BENCHMARK_REPLAY_ROUNDS, BENCHMARK_SNAPSHOT_ROUNDS);
+
+	// A restored game has to play on exactly like the original:
+	restore_game_snapshot(&fork, &snapshot);
+
+	for (size_t tick = 0; tick < BENCHMARK_SNAPSHOT_TICKS; ++tick)
+	{
+		step_game(&game_state, &input_state);
+		step_game(&fork, &input_state);
+	}
+
+	if (memcmp(&fork.board, &game_state.board, sizeof(Board)) != 0 || fork.score != game_state.score || fork.tick_count != game_state.tick_count)
+	{
+		printf("MISMATCH: restored game played differently (checksum %llu)\n", (unsigned long long)checksum);
+	}
+}
+
+void benchmark_move_generation(void)
+{
+	static Game_State positions[BENCHMARK_POSITION_COUNT];
+	static Move_Generator generator;
+	uint8_t path[BENCHMARK_MAX_PATH_LENGTH];
+	Game_State game_state;
+	Input_State input_state;
+	uint64_t placement_count = 0;
+	uint64_t state_count = 0;
+	uint64_t seed = 1;
+
+	// Positions from real games, taken while a tetromino is falling. Games are kept
+	// below the top of the board, so there is still room to move:
+	initialize_game_state(&game_state, seed, PIECE_RANDOMIZER_UNIFORM);
+
+	for (size_t i = 0; i < BENCHMARK_POSITION_COUNT; )
+	{
+		set_input_flags(&input_state, (rand() % 4 == 0) ? (uint8_t)(1 << (rand() % 4)) : 0);
+		step_game(&game_state, &input_state);
+
+		if (game_state.game_phase == GAME_PHASE_GAMEOVER || !is_board_row_empty(&game_state.board, BOARD_HEIGHT_RENDERED - 6))
+		{
+			initialize_game_state(&game_state, ++seed, PIECE_RANDOMIZER_UNIFORM);
+			continue;
+		}
+
+		if (!game_state.should_spawn_tetromino && rand() % 64 == 0)
+		{
+			fork_game_state(&positions[i++], &game_state);
+		}
+	}
+
+	printf("--- Move generation (%d positions) ---\n", BENCHMARK_POSITION_COUNT);
+
+	double time_start = get_time_in_seconds();
+
+	for (size_t round = 0; round < BENCHMARK_MOVE_ROUNDS; ++round)
+	{
+		for (size_t i = 0; i < BENCHMARK_POSITION_COUNT; ++i)
+		{
+			placement_count += generate_game_placements(&generator, &positions[i]);
+			state_count += generator.state_count;
+		}
+	}
+
+	double seconds = get_time_in_seconds() - time_start;
+	uint64_t generation_count = (uint64_t)BENCHMARK_MOVE_ROUNDS * BENCHMARK_POSITION_COUNT;
+
+	printf("%-28s %10.2f ns/op %12.0f placements/s\n", "generate placements", (seconds * 1e9) / generation_count, placement_count / seconds);
+	printf("%.1f placements and %.1f searched states per position\n", (double)placement_count / generation_count, (double)state_count / generation_count);
+
+	// Play every path in the engine, it has to end on its placement. Kicks change paths, so every rotation system is played:
+	uint64_t path_count = 0;
+	uint64_t failed_count = 0;
+
+	for (size_t k = 0; k < BENCHMARK_POSITION_COUNT * ROTATION_SYSTEM_COUNT; ++k)
+	{
+		size_t i = k % BENCHMARK_POSITION_COUNT;
+
+		positions[i].rotation_system = (uint8_t)(k / BENCHMARK_POSITION_COUNT);
+
+		uint32_t count = generate_game_placements(&generator, &positions[i]);
+
+		for (uint32_t j = 0; j < count; ++j)
+		{
+			uint32_t length = get_placement_path(&generator, j, path, BENCHMARK_MAX_PATH_LENGTH);
+			Tetromino placement = get_placement(&generator, j);
+
+			if (length > BENCHMARK_MAX_PATH_LENGTH)
+			{
+				continue;
+			}
+
+			fork_game_state(&game_state, &positions[i]);
+
+			for (uint32_t k = 0; k < length; ++k)
+			{
+				// Paths leave gravity out, so hold it off:
+				game_state.fall_progress = 0;
+				set_input_flags(&input_state, path[k]);
+				step_game(&game_state, &input_state);
+			}
+
+			Tetromino reached = game_state.current_tetromino;
+
+			path_count++;
+			failed_count += (reached.pivot_position.x != placement.pivot_position.x || reached.pivot_position.y != placement.pivot_position.y || reached.rotation != placement.rotation);
+		}
+	}
+
+	printf("%llu paths played in the engine\n", (unsigned long long)path_count);
+
+	if (failed_count > 0)
+	{
+		printf("MISMATCH: %llu of %llu paths did not reach their placement\n", (unsigned long long)failed_count, (unsigned long long)path_count);
+	}
+}
+
+void benchmark_batch_engine(void)
+{
+	static uint8_t inputs[BENCHMARK_INPUT_COUNT];
+	static const uint32_t lane_counts[] = {1, 8, 64, 512, 4096};
+
+	// Busy random player, mostly pushing down so games end quickly:
+	for (size_t i = 0; i < BENCHMARK_INPUT_COUNT; ++i)
+	{
+		int key = rand() % 8;
+		inputs[i] = (key == 0) ? INPUT_FLAG_LEFT : (key == 1) ? INPUT_FLAG_RIGHT : (key == 2) ? INPUT_FLAG_UP : (key < 5) ? INPUT_FLAG_DOWN : 0;
+	}
+
+	printf("--- Batch engine (%d lane ticks per run) ---\n", BENCHMARK_BATCH_LANE_TICKS);
+
+	// Game_State stepped one game at a time, the baseline:
+	{
+		Game_State game_state;
+		Input_State input_state;
+		uint64_t game_count = 0;
+
+		initialize_game_state(&game_state, 1, PIECE_RANDOMIZER_UNIFORM);
+
+		double time_start = get_time_in_seconds();
+
+		for (size_t tick = 0; tick < BENCHMARK_BATCH_LANE_TICKS; ++tick)
+		{
+			set_input_flags(&input_state, inputs[tick % BENCHMARK_INPUT_COUNT]);
+			step_game(&game_state, &input_state);
+
+			if (game_state.game_phase == GAME_PHASE_GAMEOVER)
+			{
+				game_count++;
+				initialize_game_state(&game_state, game_count + 1, PIECE_RANDOMIZER_UNIFORM);
+			}
+		}
+
+		double seconds = get_time_in_seconds() - time_start;
+
+		printf("%-16s %8s %12.0f games/s %14.0f ticks/s\n", "game state", "", game_count / seconds, BENCHMARK_BATCH_LANE_TICKS / seconds);
+	}
+
+	for (size_t i = 0; i < sizeof(lane_counts) / sizeof(lane_counts[0]); ++i)
+	{
+		for (int use_simd = 0; use_simd <= 1; ++use_simd)
+		{
+			Batch_Engine batch;
+			uint32_t lane_count = lane_counts[i];
+			uint32_t step_count = max(BENCHMARK_BATCH_LANE_TICKS / lane_count, BENCHMARK_BATCH_MIN_STEPS);
+			uint8_t* step_inputs = malloc(lane_count);
+			uint64_t game_count = 0;
+			uint64_t score = 0;
+
+			if (step_inputs == NULL || !create_batch_engine(&batch, lane_count))
+			{
+				printf("Could not allocate batch of %u lanes\n", lane_count);
+				free(step_inputs);
+				return;
+			}
+
+			batch.use_simd = use_simd;
+
+			// Untimed warmup so lanes are spread over every stage of a game, like a long running batch:
+			for (uint32_t step = 0; step < BENCHMARK_BATCH_WARMUP_STEPS; ++step)
+			{
+				for (uint32_t lane = 0; lane < lane_count; ++lane)
+				{
+					step_inputs[lane] = inputs[(step * 7 + lane * 13) % BENCHMARK_INPUT_COUNT];
+				}
+
+				step_batch_engine(&batch, step_inputs);
+				restart_finished_batch_lanes(&batch, step * lane_count);
+			}
+
+			double time_start = get_time_in_seconds();
+
+			for (uint32_t step = 0; step < step_count; ++step)
+			{
+				for (uint32_t lane = 0; lane < lane_count; ++lane)
+				{
+					step_inputs[lane] = inputs[(step * 7 + lane * 13) % BENCHMARK_INPUT_COUNT];
+				}
+
+				step_batch_engine(&batch, step_inputs);
+
+				for (uint32_t lane = 0; lane < lane_count; ++lane)
+				{
+					score += (batch.game_phase[lane] == GAME_PHASE_GAMEOVER) ? batch.score[lane] : 0;
+				}
+
+				game_count += restart_finished_batch_lanes(&batch, step * lane_count);
+			}
+
+			double seconds = get_time_in_seconds() - time_start;
+
+			printf("%-16s %8u %12.0f games/s %14.0f ticks/s (score %llu)\n", use_simd ? "batch simd" : "batch scalar", lane_count, game_count / seconds, ((double)step_count * lane_count) / seconds, (unsigned long long)score);
+
+			destroy_batch_engine(&batch);
+			free(step_inputs);
+		}
+	}
+}
+
+void benchmark_runner_scaling(void)
+{
+	uint32_t cpu_count = get_cpu_count();
+	Runner_Result baseline = {0};
+
+	printf("--- Runner scaling (%d games, %d lanes per thread, %u cpus) ---\n", BENCHMARK_RUNNER_GAME_COUNT, RUNNER_DEFAULT_LANE_COUNT, cpu_count);
+
+	for (uint32_t thread_count = 1; thread_count <= cpu_count; ++thread_count)
+	{
+		Runner_Config config = {0};
+		Runner_Result result;
+
+		config.game_count = BENCHMARK_RUNNER_GAME_COUNT;
+		config.seed = BENCHMARK_RUNNER_SEED;
+		config.thread_count = thread_count;
+		config.lane_count = RUNNER_DEFAULT_LANE_COUNT;
+		config.pin_threads = true;
+
+		if (!run_games(&config, &result))
+		{
+			printf("Could not start %u threads\n", thread_count);
+			return;
+		}
+
+		if (thread_count == 1)
+		{
+			baseline = result;
+		}
+
+		printf("%-16s %8u %12.0f games/s %14.0f ticks/s %6.2fx (steals %llu)\n", "runner", thread_count, result.game_count / result.seconds, result.tick_count / result.seconds, baseline.seconds / result.seconds, (unsigned long long)result.steal_count);
+
+		// Games are seeded by index, the totals must not depend on the thread count:
+		if (result.tick_count != baseline.tick_count || result.score != baseline.score)
+		{
+			printf("MISMATCH: %u threads played different games than 1 thread\n", thread_count);
+		}
+	}
+}
+
+void benchmark_render_commands(void)
+{
+	Game_State* game_states = malloc(BENCHMARK_RENDER_FRAMES * sizeof(Game_State));
+	Render_Command_Buffer* buffer = malloc(sizeof(Render_Command_Buffer));
+	Render_Command_Buffer* cached_buffer = malloc(sizeof(Render_Command_Buffer));
+	uint32_t* pixels = malloc(SCREEN_WIDTH * SCREEN_HEIGHT * sizeof(uint32_t));
+	Software_Renderer* software_renderer = malloc(sizeof(Software_Renderer));
+	Game_State game_state;
+	Input_State input_state;
+	Render_Stats null_stats = {0};
+	Render_Stats software_stats = {0};
+	uint64_t checksum = 0;
+	uint64_t built_command_count = 0;
+	uint32_t cached_build_count = 0;
+
+	if (game_states == NULL || buffer == NULL || cached_buffer == NULL || pixels == NULL || software_renderer == NULL)
+	{
+		printf("Could not allocate render benchmark\n");
+		free(game_states);
+		free(buffer);
+		free(cached_buffer);
+		free(pixels);
+		free(software_renderer);
+		return;
+	}
+
+	printf("--- Render commands (%d frames, %d bytes per command) ---\n", BENCHMARK_RENDER_FRAMES, (int)sizeof(Render_Command));
+
+	// Frames of a game with random input, game over screens included:
+	initialize_game_state(&game_state, 1, PIECE_RANDOMIZER_UNIFORM);
+
+	for (size_t frame = 0; frame < BENCHMARK_RENDER_FRAMES; ++frame)
+	{
+		set_input_flags(&input_state, (uint8_t)(rand() & 0x1f));
+		step_game(&game_state, &input_state);
+		game_states[frame] = game_state;
+	}
+
+	initialize_software_renderer(software_renderer, pixels, SCREEN_WIDTH, SCREEN_HEIGHT);
+
+	// As the game does it, the board is built again only when it changed:
+	reset_render_commands(cached_buffer);
+
+	double time_start = get_time_in_seconds();
+
+	for (size_t frame = 0; frame < BENCHMARK_RENDER_FRAMES; ++frame)
+	{
+		bool cached_built = build_game_cached_render_commands(&game_states[frame], cached_buffer);
+
+		build_game_render_commands(&game_states[frame], buffer);
+		cached_build_count += cached_built;
+		built_command_count += buffer->command_count + (cached_built ? cached_buffer->command_count : 0);
+		checksum += buffer->command_count + cached_buffer->command_count;
+	}
+
+	double build_seconds = get_time_in_seconds() - time_start;
+
+	time_start = get_time_in_seconds();
+
+	for (size_t frame = 0; frame < BENCHMARK_RENDER_FRAMES; ++frame)
+	{
+		build_game_cached_render_commands(&game_states[frame], cached_buffer);
+		build_game_render_commands(&game_states[frame], buffer);
+		sort_render_commands(buffer);
+		checksum += buffer->commands[0].layer;
+	}
+
+	double sort_seconds = get_time_in_seconds() - time_start;
+
+	time_start = get_time_in_seconds();
+
+	for (size_t frame = 0; frame < BENCHMARK_RENDER_FRAMES; ++frame)
+	{
+		build_game_cached_render_commands(&game_states[frame], cached_buffer);
+		build_game_render_commands(&game_states[frame], buffer);
+		sort_render_commands(buffer);
+		submit_render_commands_null(cached_buffer, &null_stats);
+		submit_render_commands_null(buffer, &null_stats);
+	}
+
+	double null_seconds = get_time_in_seconds() - time_start;
+
+	time_start = get_time_in_seconds();
+
+	for (size_t frame = 0; frame < BENCHMARK_RENDER_FRAMES; ++frame)
+	{
+		build_game_cached_render_commands(&game_states[frame], cached_buffer);
+		build_game_render_commands(&game_states[frame], buffer);
+		sort_render_commands(buffer);
+		submit_render_commands_software(software_renderer, cached_buffer, &software_stats);
+		submit_render_commands_software(software_renderer, buffer, &software_stats);
+		checksum += pixels[frame % (SCREEN_WIDTH * SCREEN_HEIGHT)];
+	}
+
+	double software_seconds = get_time_in_seconds() - time_start;
+
+	// Each stage includes the ones before it, so they compare to building alone:
+	print_result("build commands", build_seconds, build_seconds, BENCHMARK_RENDER_FRAMES);
+	print_result("build and sort", sort_seconds, build_seconds, BENCHMARK_RENDER_FRAMES);
+	print_result("submit to null backend", null_seconds, build_seconds, BENCHMARK_RENDER_FRAMES);
+	print_result("submit to software backend", software_seconds, build_seconds, BENCHMARK_RENDER_FRAMES);
+	printf("%.1f commands and %.1f draw calls per frame (checksum %llu)\n", (double)null_stats.command_count / BENCHMARK_RENDER_FRAMES, (double)null_stats.draw_call_count / BENCHMARK_RENDER_FRAMES, (unsigned long long)checksum);
+	printf("%.1f commands built per frame, the board on %u of %d frames\n", (double)built_command_count / BENCHMARK_RENDER_FRAMES, cached_build_count, BENCHMARK_RENDER_FRAMES);
+
+	free(game_states);
+	free(buffer);
+	free(cached_buffer);
+	free(pixels);
+	free(software_renderer);
+}
@@ -0,0 +1,70 @@
+/* ISMET BARAN SURUCU -- github.com/baransrc */
+#include "tetris_util.h"
+#include "tetris_differential.h"
+#include "tetris_platform.h"
+#include <stdlib.h>
+#include <stdio.h>
+
+#define DIFFERENTIAL_DEFAULT_GAME_COUNT 2000
+#define DIFFERENTIAL_DEFAULT_SEED 1
+
+static const char* ROTATION_SYSTEM_NAMES[ROTATION_SYSTEM_COUNT] = {"simple", "srs"};
+
+int main(int argc, char* args[])
+{
+	Differential_Config config;
+	Differential_Result result;
+
+	config.game_count = (argc > 1) ? strtoull(args[1], NULL, 10) : DIFFERENTIAL_DEFAULT_GAME_COUNT;
+	config.seed = (argc > 2) ? strtoull(args[2], NULL, 10) : DIFFERENTIAL_DEFAULT_SEED;
+	config.thread_count = (argc > 3) ? (uint32_t)strtoul(args[3], NULL, 10) : get_cpu_count();
+	config.lane_count = DIFFERENTIAL_DEFAULT_LANE_COUNT;
+
+	// Every engine shares the rotation code, so it is checked on its own: a kick must not depend on
+	// gravity, a row per tick or 20G where gravity fires on every tick:
+	for (int check = 0; check < ROTATION_SYSTEM_COUNT * 2; ++check)
+	{
+		int rotation_system = check / 2;
+		uint32_t gravity = (check & 1) ? GRAVITY_20G : GRAVITY_ONE_ROW;
+		uint32_t kick_count = 0;
+		uint32_t mismatch_count = check_kicks_under_gravity((enum Rotation_System)rotation_system, gravity, &kick_count);
+
+		printf("kicks with %s rotations at %s: %u kicked, %u lost when gravity fires\n", ROTATION_SYSTEM_NAMES[rotation_system], (check & 1) ? "20G" : "1 row per tick", kick_count, mismatch_count);
+
+		if (mismatch_count > 0 || kick_count == 0)
+		{
+			printf("MISMATCH: rotations against the walls turn differently on ticks with gravity\n");
+			return 1;
+		}
+	}
+
+	printf("games: %llu seed: %llu threads: %u\n", (unsigned long long)config.game_count, (unsigned long long)config.seed, max(config.thread_count, 1));
+
+	if (!run_differential_check(&config, &result))
+	{
+		printf("Could not run the differential check\n");
+		return 1;
+	}
+
+	printf("games: %llu ticks: %llu lines: %llu level ups: %llu %8.3fs %12.0f ticks/s\n", (unsigned long long)result.game_count, (unsigned long long)result.tick_count,
+		   (unsigned long long)result.line_count, (unsigned long long)result.level_up_count, result.seconds, result.tick_count / result.seconds);
+
+	if (result.mismatch_count > 0)
+	{
+		printf("MISMATCH in %llu games, first in game %llu at tick %llu: %s differs from the reference in %s\n",
+			   (unsigned long long)result.mismatch_count, (unsigned long long)result.mismatch_game, (unsigned long long)result.mismatch_tick,
+			   result.mismatch_engine, result.mismatch_field);
+		return 1;
+	}
+
+	// Games that clear nothing leave line clears, scoring and levels unchecked:
+	if (result.game_count > 0 && result.line_count == 0)
+	{
+		printf("NO LINES cleared, line clears were not checked\n");
+		return 1;
+	}
+
+	printf("ok\n");
+
+	return 0;
+}
@@ -0,0 +1,40 @@
+/* ISMET BARAN SURUCU -- github.com/baransrc */
+#include "tetris_util.h"
+#include "tetris_runner.h"
+#include "tetris_platform.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <time.h>
+
+#define HEADLESS_DEFAULT_GAME_COUNT 1000
+
+int main(int argc, char* args[])
+{
+	Runner_Config config = {0};
+	Runner_Result result;
+
+	config.game_count = (argc > 1) ? strtoull(args[1], NULL, 10) : HEADLESS_DEFAULT_GAME_COUNT;
+	config.seed = (argc > 2) ? strtoull(args[2], NULL, 10) : (uint64_t)time(NULL);
+	config.thread_count = (argc > 3) ? (uint32_t)strtoul(args[3], NULL, 10) : get_cpu_count();
+	config.lane_count = (argc > 4) ? (uint32_t)strtoul(args[4], NULL, 10) : RUNNER_DEFAULT_LANE_COUNT;
+	config.pin_threads = (argc > 5) && (atoi(args[5]) != 0);
+
+	if (config.game_count > UINT32_MAX)
+	{
+		printf("At most %u games per run\n", UINT32_MAX);
+		return 1;
+	}
+
+	if (!run_games(&config, &result))
+	{
+		printf("Could not start the runner\n");
+		return 1;
+	}
+
+	printf("seed: %llu threads: %u lanes: %u\n", (unsigned long long)config.seed, max(config.thread_count, 1), max(config.lane_count, 1));
+	printf("games: %llu ticks: %llu lines: %llu score: %llu steals: %llu\n", (unsigned long long)result.game_count, (unsigned long long)result.tick_count, (unsigned long long)result.line_count, (unsigned long long)result.score, (unsigned long long)result.steal_count);
+	printf("time: %.3fs -- %.0f games/s, %.0f ticks/s, %.0f games/hour\n", result.seconds, result.game_count / result.seconds, result.tick_count / result.seconds, (result.game_count / result.seconds) * 3600.0);
+
+	return 0;
+}
@@ -1,35 +1,34 @@
 /* ISMET BARAN SURUCU -- github.com/baransrc */
 #include "tetris_util.h"
+#include "tetris_board.h"
+#include "tetris_core.h"
+#include "tetris_replay.h"
+#include "tetris_render.h"
 #include <stdlib.h>  
 #include <stdio.h>
 #include <stdbool.h>
+#include <string.h>
 #include "../include/SDL.h"
 #include "../include/SDL_ttf.h"
 #include <time.h>
 
 #define FRAME_PER_SECOND_CAP 60
-#define SCREEN_WIDTH 384
-#define SCREEN_HEIGHT 768	
-#define BOARD_WIDTH 10
-#define BOARD_HEIGHT 22
-#define BOARD_HEIGHT_RENDERED 20
-#define TETROMINO_SIZE 32
-#define BOARD_OFFSET_X 32
-#define BOARD_OFFSET_Y 32
-#define BOARD_SIZE BOARD_HEIGHT*BOARD_WIDTH
-#define MAX_TETROMINO_WIDTH 5
-#define MAX_TETROMINO_HEIGHT 5
-#define MAX_TETROMINO_ARRAY_SIZE MAX_TETROMINO_WIDTH*MAX_TETROMINO_HEIGHT
-#define TETROMINO_TYPE_COUNT 7
-#define TETROMINO_ROTATION_COUNT 4
-#define EMPTY_CELL_TYPE 255
-#define TETROMINO_PIVOT_X 2
-#define TETROMINO_PIVOT_Y 2
-#define TEXT_BUFFER_SIZE 1024
+#define TEXT_BUFFER_SIZE 64
+// Glyph atlases hold printable ASCII, every character the game writes:
+#define GLYPH_FIRST ' '
+#define GLYPH_COUNT ('~' - GLYPH_FIRST + 1)
+#define GLYPH_ATLAS_WIDTH 512
+// Turbo checks the frame deadline once per this many ticks:
+#define TURBO_TICKS_PER_CHECK 256
+// Left and right arrows jump this far while a replay plays:
+#define REPLAY_SEEK_TICKS (10 * TICKS_PER_SECOND)
 
 static const char* FILE_PATH_SPLASH_SCREEN = "..\\assets\\images\\baran_logo.bmp";
 static const char* FILE_PATH_MAIN_FONT = "..\\assets\\fonts\\Montserrat-Semibold.ttf";
-static const float_t DURATION_LINE_ANIMATION = 0.2f;
+// Every session is recorded, and saved here on quit:
+static const char* FILE_PATH_LAST_REPLAY = "last_game.trp";
+// Texts that show the value of their command, NULL for texts that never change:
+static const char* TEXT_FORMATS[RENDER_TEXT_COUNT] = {"SCORE: %u", "LINES: %u", "LEVEL: %u", NULL, NULL};
 
 enum Text_Alignment
 {
@@ -38,93 +37,63 @@ enum Text_Alignment
 	TEXT_ALIGNMENT_RIGHT,
 };
 
-enum Text_Render_Mode
+// Every glyph of a font rasterized once, in white so a color modulation tints it:
+typedef struct Glyph_Atlas
 {
-	TEXT_RENDER_MODE_SOLID,
-	TEXT_RENDER_MODE_SHADED,
-	TEXT_RENDER_MODE_BLENDED,
-};
-
-enum Tetromino_Type
-{
-	TETROMINO_TYPE_I, 
-	TETROMINO_TYPE_O, 
-	TETROMINO_TYPE_T, 
-	TETROMINO_TYPE_J, 
-	TETROMINO_TYPE_L, 
-	TETROMINO_TYPE_S, 
-	TETROMINO_TYPE_Z
-};
-
-enum Game_Phase
-{	
-	GAME_PHASE_PLAYING,
-	GAME_PHASE_GAMEOVER,
-};
-
-typedef struct Vector2
-{
-	int16_t x;
-	int16_t y;
-} Vector2;
-
-typedef struct Extents
-{
-	int16_t min_x;
-	int16_t min_y;
-	int16_t max_x;
-	int16_t max_y;
-} Extents;
-
-typedef struct Tetromino
-{
-	Vector2 pivot_position;
-	uint8_t rotation; 
-	enum Tetromino_Type type;
-} Tetromino;
-
-typedef struct Input_State
-{
-	bool pressed_left;
-	bool pressed_right;
-	bool pressed_up;
-	bool pressed_down; 
-	bool pressed_space;
-} Input_State;
-
-typedef struct Game_State
-{
-	uint8_t board[BOARD_SIZE];
-	uint8_t previous_tetromino_rotation;
-	double delta_time;
-	float_t fall_clock;	 
-	enum Game_Phase game_phase;
-	bool should_spawn_tetromino;
-	Vector2 current_destination;
-	Vector2 previous_tetromino_position;
-	Tetromino current_tetromino;
-	uint32_t line_count;
-	uint32_t score;
-	uint8_t current_level;
-	float tetromino_lines[BOARD_HEIGHT_RENDERED];
-} Game_State;
+	TTF_Font* font;
+	SDL_Texture* texture;
+	// Glyphs are a full line high, so they line up without their own offsets:
+	SDL_Rect glyphs[GLYPH_COUNT];
+	int advances[GLYPH_COUNT];
+} Glyph_Atlas;
 
+// Text laid out into glyph quads, laid out again only when it changes:
 typedef struct Text
 {
+	const Glyph_Atlas* atlas;
 	char buffer[TEXT_BUFFER_SIZE];
 	enum Text_Alignment alignment;
 	Vector2 position;
+	Color color;
+	// Number shown by set_text_value, -1 until it shows one:
+	int64_t value;
+	int glyph_count;
+	SDL_Rect sources[TEXT_BUFFER_SIZE];
+	SDL_Rect destinations[TEXT_BUFFER_SIZE];
 } Text;
 
 typedef struct Text_State
 {
-	Text score_text;
-	Text line_text;
-	Text level_text;
+	Glyph_Atlas atlas_24pt;
+	Glyph_Atlas atlas_16pt;
+	// By enum Render_Text, what text commands refer to:
+	Text texts[RENDER_TEXT_COUNT];
 } Text_State;
 
+// Draws render commands with SDL. Layers with a key are kept in render targets and drawn again
+// only when their key changes:
+typedef struct Render_Backend
+{
+	SDL_Renderer* renderer;
+	// Every cell style drawn once at startup, TILE_COUNT tiles in a row:
+	SDL_Texture* tile_atlas;
+	Text_State* text_state;
+	// Draws the renderer submits, counted until the caller resets it. Each copy of a tile, glyph
+	// or layer counts, and each list of rectangles filled at once:
+	uint32_t draw_call_count;
+	// Off when the renderer has no render targets, layers with a key are then drawn every frame:
+	bool use_layer_cache;
+	// Screen sized and created the first time their layer has a key:
+	SDL_Texture* layer_textures[RENDER_LAYER_COUNT];
+	uint64_t layer_keys[RENDER_LAYER_COUNT];
+	// Bit per layer whose texture holds what its key says:
+	uint32_t valid_layers;
+	// Rectangles of the fill run being drawn:
+	SDL_Rect rects[RENDER_COMMAND_CAPACITY];
+} Render_Backend;
+
 // SDL --------------------------
-void update_window_name(SDL_Window*, int, double);
+void update_window_name(SDL_Window*, int, double, double, uint32_t);
 bool initialize_window(SDL_Window**,  SDL_Surface**, int, int);
 bool initialize_renderer(SDL_Window*, SDL_Renderer**);
 bool load_bmp_image(SDL_Surface**, char*);
@@ -132,62 +101,34 @@ bool load_bmp_image(SDL_Surface**, char*);
 
 // Utils ------------------------
 inline SDL_Color color_to_sdl_color(Color);
-void draw_text(SDL_Renderer*, TTF_Font*, char*, Vector2, enum Text_Alignment, enum Text_Render_Mode, Color);
-void draw_filled_rectangle(SDL_Renderer*, int, int, int, int, Color);
-int random_range(int, int);
-inline void set_2d_array_element(uint8_t*, int, int, int, uint8_t);
-inline uint8_t get_2d_array_element(uint8_t*, int, int, int);
-inline int16_t get_x_extent_relative_to_board(int16_t, int16_t);
-inline int16_t get_y_extent_relative_to_board(int16_t, int16_t);
-Extents find_extents_of_tetromino(Tetromino);
+bool create_glyph_atlas(SDL_Renderer*, TTF_Font*, Glyph_Atlas*);
+void destroy_glyph_atlas(Glyph_Atlas*);
+void initialize_text(Text*, const Glyph_Atlas*, Vector2, enum Text_Alignment, Color);
+void set_text(Text*, const char*);
+void set_text_value(Text*, const char*, uint32_t);
+void draw_text(Render_Backend*, const Text*);
 // ------------------------------
 
 // Gameplay ---------------------
-bool is_possible_movement(Game_State*, bool);
-void clamp_movement(Game_State*);
-void put_tetromino_to_board(Game_State*, bool);
-void delete_tetromino_from_board(Game_State*, enum Tetromino_Type, uint16_t, uint16_t, uint8_t);
-void move_tetromino_for_rotation(Game_State*);
-inline void level_up(Game_State*);
-inline void add_score(Game_State*, uint8_t);
-inline double get_current_fall_time(Game_State*);
-bool recycle_current_tetromino(Game_State*);
-inline bool will_fall_this_turn(Game_State*);
-bool tetromino_fall(Game_State*);
-void determine_current_destination(Game_State*);
-void check_game_over(Game_State*);
-void destroy_lines(Game_State*);
-void update_line_data(Game_State*);
-void update_game_text(Game_State*, Text_State*);
-void update_game_playing_phase(Game_State*, Input_State*);
-void update_game_gameover_phase(Game_State*, Input_State*);
-void update_game(Game_State*, Input_State*);
-void initialize_game_state(Game_State*);
-void initialize_game(Game_State*, Input_State*, Text_State*);
-void reset_input_state(Input_State*);
-void parse_input_state_playing_phase(Game_State*, Input_State*);
+bool initialize_text_state(Text_State*, SDL_Renderer*, TTF_Font*, TTF_Font*);
+void destroy_text_state(Text_State*);
+void initialize_game(Game_State*, Input_State*, uint64_t);
 // ------------------------------
 
 // Rendering --------------------
-void render_game_text_playing_phase(Game_State*, Text_State*, SDL_Renderer*, TTF_Font*, TTF_Font*);
-void render_game_text_gameover_phase(Game_State*, Text_State*, SDL_Renderer*, TTF_Font*, TTF_Font*);
-void render_game_text(Game_State*, Text_State*, SDL_Renderer*, TTF_Font*, TTF_Font*);
-void draw_tetromino_unit(SDL_Renderer*, int, int, enum Tetromino_Type);
-void draw_empty_cell(SDL_Renderer*, int, int);
-void draw_current_destination(Game_State*, SDL_Renderer*);
-void draw_tetrominoes(Game_State*, SDL_Renderer*);
-void draw_board_cells(Game_State*, SDL_Renderer*);
-void draw_lines(Game_State* game_state, SDL_Renderer* renderer);
-void render_game_playing_phase(Game_State*, SDL_Renderer*);
-void render_game_gameover_phase(Game_State*, SDL_Renderer*);
-void render_game(Game_State*, SDL_Renderer*);
+SDL_Texture* create_tile_atlas(SDL_Renderer*);
+Render_Backend* create_render_backend(SDL_Renderer*, Text_State*);
+void destroy_render_backend(Render_Backend*);
+void invalidate_render_layers(Render_Backend*);
+void draw_render_commands(Render_Backend*, const Render_Command*, uint32_t);
+void submit_render_commands(Render_Backend*, const Render_Command_Buffer*);
 // ------------------------------
 
 
 int main( int argc, char* args[] )
 {
-	// Set the seed for random number generator:
-	srand(time(NULL)); 
+	// Seed of the first game, later games are seeded from the game before:
+	uint64_t seed = (uint64_t)time(NULL);
 
 	// The window that will be rendered to:
 	SDL_Window* window = NULL;
@@ -234,8 +175,19 @@ int main( int argc, char* args[] )
 		TTF_Font* font_24pt = TTF_OpenFont(FILE_PATH_MAIN_FONT, 24);
 		TTF_Font* font_16pt = TTF_OpenFont(FILE_PATH_MAIN_FONT, 16);
 
-		if (renderer_initialization_success)
+		// Glyphs of both fonts are rasterized here once, text is drawn from them from then on:
+		Text_State text_state;
+		bool text_initialization_success = renderer_initialization_success && initialize_text_state(&text_state, renderer, font_24pt, font_16pt);
+		// The game turns every frame into render commands, the SDL backend draws them. The empty
+		// grid and locked cells have a buffer of their own, filled again only when they change:
+		Render_Backend* render_backend = text_initialization_success ? create_render_backend(renderer, &text_state) : NULL;
+		Render_Command_Buffer* render_commands = malloc(sizeof(Render_Command_Buffer));
+		Render_Command_Buffer* cached_render_commands = malloc(sizeof(Render_Command_Buffer));
+
+		if (render_backend != NULL && render_commands != NULL && cached_render_commands != NULL)
 		{	
+			reset_render_commands(cached_render_commands);
+
 			bool user_quit = false;
 			
 			// SDL_Event holds event data which will be parsed by Input_State:
@@ -247,14 +199,43 @@ int main( int argc, char* args[] )
 			int64_t time_last = SDL_GetTicks();
 			double delta_time = 0;
 			double delta_time_ms = time_now - time_last;
+			uint32_t draw_call_count = 0;
+
+			// Gameplay runs in whole ticks, the clock turns frame time into ticks:
+			Game_Clock game_clock;
+			reset_game_clock(&game_clock);
+			uint32_t ticks_this_frame = 0;
 
 			// Game related
 			Game_State game_state;
 			Input_State input_state;
-			Text_State text_state;
 
-			// Initialize game_state, input_state and text_state:
-			initialize_game(&game_state, &input_state, &text_state);
+			// Initialize game_state and input_state:
+			initialize_game(&game_state, &input_state, seed);
+
+			// Plays the replay given as the first argument in turbo, otherwise records this session:
+			Replay replay;
+			Replay_Reader replay_reader;
+			bool replay_playing = (argc > 1) && load_replay(&replay, args[1]);
+			bool replay_recording = false;
+			bool replay_paused = false;
+			uint8_t pending_events = 0;
+
+			if (replay_playing)
+			{
+				start_replay_game(&game_state, &replay.header);
+				start_replay_reader(&replay_reader, replay.events, replay.event_size, replay.header.tick_count);
+				game_clock.turbo = true;
+			}
+			else
+			{
+				if (argc > 1)
+				{
+					printf("Could not read replay %s\n", args[1]);
+				}
+
+				replay_recording = initialize_replay(&replay, &game_state, seed, REPLAY_DEFAULT_KEYFRAME_INTERVAL);
+			}
 
 			while (!user_quit)
 			{
@@ -265,6 +246,38 @@ int main( int argc, char* args[] )
 					{
 						user_quit = true;
 					}
+					else if (event_container.type == SDL_RENDER_TARGETS_RESET || event_container.type == SDL_RENDER_DEVICE_RESET)
+					{
+						// Render targets lost what was drawn to them, draw the board to them again:
+						invalidate_render_layers(render_backend);
+					}
+					else if (event_container.type == SDL_KEYDOWN && replay_playing)
+					{
+						// Left and right jump through the replay, space pauses it:
+						uint64_t tick = replay_reader.tick;
+
+						switch (event_container.key.keysym.sym)
+						{
+							case SDLK_LEFT:
+							seek_replay(&game_state, &replay_reader, &replay, (tick > REPLAY_SEEK_TICKS) ? tick - REPLAY_SEEK_TICKS : 0);
+							break;
+
+							case SDLK_RIGHT:
+							seek_replay(&game_state, &replay_reader, &replay, tick + REPLAY_SEEK_TICKS);
+							break;
+
+							case SDLK_SPACE:
+							replay_paused = !replay_paused;
+							break;
+
+							case SDLK_t:
+							game_clock.turbo = !game_clock.turbo;
+							break;
+
+							default:
+							break;
+						}
+					}
 					else if (event_container.type == SDL_KEYDOWN)
 					{
 						switch( event_container.key.keysym.sym )
@@ -289,6 +302,15 @@ int main( int argc, char* args[] )
 							input_state.pressed_space = true;
 							break;
 
+							case SDLK_t:
+							game_clock.turbo = !game_clock.turbo;
+							break;
+
+							case SDLK_r:
+							// Applied by the next tick, so replays see it at the same tick:
+							pending_events |= REPLAY_EVENT_SWITCH_ROTATION_SYSTEM;
+							break;
+
                             default:
                             break;
                         }
@@ -314,30 +336,69 @@ int main( int argc, char* args[] )
 				// // Calculate the time passed last frame:
 				delta_time = delta_time_ms * 0.001;
 
-				game_state.delta_time = delta_time;
-
 				if (refresh_frame_rate == 0)
 				{
-					update_window_name(window, ((int)(1.0/delta_time)), delta_time*1000);
+					update_window_name(window, ((int)(1.0/delta_time)), delta_time*1000, ticks_this_frame / (delta_time * TICKS_PER_SECOND), draw_call_count);
 				}
 
 				// Clear screen to black:
 				SDL_SetRenderDrawColor(renderer, 0x00, 0x00, 0x00, 0x00);
 				SDL_RenderClear(renderer);
 				
-				// Update game logic:
-				update_game(&game_state, &input_state);
-				// Update text fields such as score, lines and level:
-				update_game_text(&game_state, &text_state);
+				// Update game logic, as many ticks as the clock allows (in turbo, until this frame's time is used up):
+				uint32_t tick_budget = advance_game_clock(&game_clock, delta_time);
+				uint64_t turbo_deadline = SDL_GetPerformanceCounter() + SDL_GetPerformanceFrequency() / FRAME_PER_SECOND_CAP;
+
+				for (ticks_this_frame = 0; ticks_this_frame < tick_budget; ++ticks_this_frame)
+				{
+					if (game_clock.turbo && (ticks_this_frame % TURBO_TICKS_PER_CHECK) == 0 && ticks_this_frame > 0 && 
+						SDL_GetPerformanceCounter() >= turbo_deadline)
+					{
+						break;
+					}
+
+					uint8_t tick_event;
+
+					if (replay_playing)
+					{
+						if (replay_paused || replay_reader.tick >= replay_reader.tick_count)
+						{
+							break;
+						}
+
+						tick_event = read_replay_tick(&replay_reader);
+					}
+					else
+					{
+						tick_event = get_input_flags(&input_state) | pending_events;
+					}
+
+					if (replay_recording && !record_replay_tick(&replay, &game_state, tick_event))
+					{
+						printf("Could not grow the replay, recording stopped\n");
+						free_replay(&replay);
+						replay_recording = false;
+					}
+
+					play_replay_event(&game_state, tick_event);
+
+					// Key presses count for one tick only, if no tick ran they wait for the next frame:
+					reset_input_state(&input_state);
+					pending_events = 0;
+				}
+
+				// Build the commands of this frame, tetrominoes, lines and texts by layer. The board
+				// is built again only after it changed:
+				build_game_cached_render_commands(&game_state, cached_render_commands);
+				build_game_render_commands(&game_state, render_commands);
+				sort_render_commands(render_commands);
 				
-				// Render game according to it's phase:
-				render_game(&game_state, renderer);
-				// Render any text that needs to be rendered on screen:
-				render_game_text(&game_state, &text_state, renderer, font_24pt, font_16pt);
+				// Render them, layers that did not change are copied from render targets:
+				render_backend->draw_call_count = 0;
+				submit_render_commands(render_backend, cached_render_commands);
+				submit_render_commands(render_backend, render_commands);
+				draw_call_count = render_backend->draw_call_count;
 				
-				// Set all input flags to false:
-				reset_input_state(&input_state);
-
 				// Update Screen:
 				SDL_RenderPresent(renderer);
 
@@ -348,13 +409,45 @@ int main( int argc, char* args[] )
 				refresh_frame_rate = (refresh_frame_rate + 1) % FRAME_PER_SECOND_CAP; 
 			}
 
-			// Deallocate fonts:
-			TTF_CloseFont(font_24pt);
-			font_24pt = NULL;
-			TTF_CloseFont(font_16pt);
-			font_16pt = NULL;
+			if (replay_recording && !save_replay(&replay, FILE_PATH_LAST_REPLAY))
+			{
+				printf("Could not save replay %s\n", FILE_PATH_LAST_REPLAY);
+			}
+
+			if (replay_recording || replay_playing)
+			{
+				free_replay(&replay);
+			}
+
+		}
+
+		// Deallocate render commands, the backend and its textures:
+		free(render_commands);
+		render_commands = NULL;
+		free(cached_render_commands);
+		cached_render_commands = NULL;
+
+		if (render_backend != NULL)
+		{
+			destroy_render_backend(render_backend);
+			render_backend = NULL;
+		}
+
+		// Deallocate glyph atlases:
+		if (text_initialization_success)
+		{
+			destroy_text_state(&text_state);
+		}
 
-			// Deallocate renderer:
+		// Deallocate fonts:
+		TTF_CloseFont(font_24pt);
+		font_24pt = NULL;
+		TTF_CloseFont(font_16pt);
+		font_16pt = NULL;
+
+		// Deallocate renderer:
+		if (renderer != NULL)
+		{
 			SDL_DestroyRenderer(renderer);
 			renderer = NULL;
 		}
@@ -374,12 +467,12 @@ int main( int argc, char* args[] )
 	return 0;
 }
 
-void update_window_name(SDL_Window* window, int fps, double ms)
+void update_window_name(SDL_Window* window, int fps, double ms, double speed, uint32_t draw_call_count)
 {
-	char window_name[64];
+	char window_name[96];
 	
-	// Write title with fps to window_name buffer:
-	snprintf(window_name, sizeof(window_name), "TETRIS - FPS: %i (%.2fms)", fps, ms);
+	// Write title with fps, game speed relative to real time and draw calls of a frame to window_name buffer:
+	snprintf(window_name, sizeof(window_name), "TETRIS - FPS: %i (%.2fms) - %.0fx - %u draw calls", fps, ms, speed, draw_call_count);
 	// Set window name to the window_name:
 	SDL_SetWindowTitle(window, window_name);
 }
@@ -420,6 +513,10 @@ bool initialize_renderer(SDL_Window* window, SDL_Renderer** renderer)
 {
 	bool success_flag = false;
 
+	// Draws are queued and sent when the frame is presented, not one by one. Each copy is still a
+	// draw of its own:
+	SDL_SetHint(SDL_HINT_RENDER_BATCHING, "1");
+
 	// Creating the renderer:
 	*renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
 
@@ -464,899 +561,462 @@ inline SDL_Color color_to_sdl_color(Color color)
 	return (SDL_Color){color.r, color.g, color.b, color.a};
 }
 
-void draw_text(SDL_Renderer *renderer, TTF_Font* font, char* text, Vector2 text_position, enum Text_Alignment text_alignment, enum Text_Render_Mode render_mode, Color text_color)
+bool create_glyph_atlas(SDL_Renderer* renderer, TTF_Font* font, Glyph_Atlas* atlas)
 {
-	// Create surface :
-	SDL_Surface* text_surface = NULL;
-	switch (render_mode)
-	{
-	case TEXT_RENDER_MODE_SOLID:
-		text_surface = TTF_RenderText_Solid(font, text, color_to_sdl_color(text_color));
-		break;
-	case TEXT_RENDER_MODE_SHADED:
-		text_surface = TTF_RenderText_Shaded(font, text, color_to_sdl_color(text_color), color_to_sdl_color(TRANSPARENT_COLOR));
-		break;
-	case TEXT_RENDER_MODE_BLENDED:
-		text_surface = TTF_RenderText_Blended(font, text, color_to_sdl_color(text_color));
-		break;
-	default:
-		break;
-	}
+	SDL_Surface* glyph_surfaces[GLYPH_COUNT] = {0};
+	int x = 0;
+	int y = 0;
 
-	SDL_Texture* text_texture = SDL_CreateTextureFromSurface(renderer, text_surface);
+	memset(atlas, 0, sizeof(*atlas));
+	atlas->font = font;
 
-	// Create the rect that texture will be rendered on:
-	SDL_Rect text_rect = {.y = text_position.y, .w = text_surface->w, .h = text_surface->h};
-
-	switch (text_alignment)
+	if (font == NULL)
 	{
-	case TEXT_ALIGNMENT_LEFT:
-		text_rect.x = text_position.x;
-		break;
-	
-	case TEXT_ALIGNMENT_CENTER:
-		text_rect.x = text_position.x - (text_surface->w / 2);
-		break;
-	
-	case TEXT_ALIGNMENT_RIGHT:
-		text_rect.x = text_position.x - text_surface->w;
-		break;
+		printf("Glyph atlas needs a font!\n");
+		return false;
 	}
 
-	// Copy texture created with text_texture and text_rect to the renderer:
-	SDL_RenderCopy(renderer, text_texture, NULL, &text_rect);
-	
-	// Deallocate text_surface:
-	SDL_FreeSurface(text_surface);
-	text_surface = NULL;
-
-	// Deallocate text_texture:
-	SDL_DestroyTexture(text_texture);
-	text_texture = NULL;
-}
+	int line_height = TTF_FontHeight(font);
 
-void draw_filled_rectangle(SDL_Renderer* renderer, int x_position, int y_position, int width, int height, Color color)
-{
-	SDL_Rect rectangle = 
+	// Rasterize every glyph alone, a full line high, and place it in rows of the atlas:
+	for (int i = 0; i < GLYPH_COUNT; ++i)
 	{
-		.x = x_position,
-		.y = y_position,
-		.w = width,
-		.h = height
-	};
-
-	SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
-	SDL_RenderFillRect(renderer, &rectangle);
-}
+		char character[2] = {(char)(GLYPH_FIRST + i), '\0'};
+		int advance = 0;
 
-int random_range(int min_n, int max_n)
-{
-    return rand() % (max_n - min_n + 1) + min_n;
-}
-
-inline void set_2d_array_element(uint8_t* array, int height, int row, int column, uint8_t value)
-{
-	array[(height * column) + row] = value;
-}
+		TTF_GlyphMetrics(font, (Uint16)character[0], NULL, NULL, NULL, NULL, &advance);
+		atlas->advances[i] = advance;
 
-inline uint8_t get_2d_array_element(uint8_t* array, int height, int row, int column)
-{
-	return array[(height * column) + row];
-}
-
-inline int16_t get_x_extent_relative_to_board(int16_t x_position, int16_t x_extent)
-{
-	return x_position + x_extent;
-}
-
-inline int16_t get_y_extent_relative_to_board(int16_t y_position, int16_t y_extent)
-{
-	return y_position - y_extent;
-}
-
-Extents find_extents_of_tetromino(Tetromino tetromino)
-{
-	// Finds extents of tetromino relative to matrix pivot position of tetromino (not board).
-
-	Extents extents = {
-		.max_x = 0, 
-		.min_x = 0, 
-		.max_y = 0, 
-		.min_y = 0
-	};
-
-	for (size_t i = 0; i < MAX_TETROMINO_WIDTH; ++i)
-	{
-		for (size_t j = 0; j < MAX_TETROMINO_HEIGHT; ++j)
+		// Space has no pixels, only an advance:
+		if (character[0] == ' ')
 		{
-			uint8_t cell_value = TETROMINOES[tetromino.type][tetromino.rotation][j][i];
+			continue;
+		}
 
-			if (cell_value == 0)
-			{
-				continue;
-			}
+		glyph_surfaces[i] = TTF_RenderText_Blended(font, character, (SDL_Color){0xff, 0xff, 0xff, 0xff});
 
-			int16_t offset_x = i - TETROMINO_PIVOT_X;
-			int16_t offset_y = j - TETROMINO_PIVOT_Y;
-			
-			extents.max_x = max(offset_x, extents.max_x);
-			extents.min_x = min(offset_x, extents.min_x);
-			extents.max_y = max(offset_y, extents.max_y);
-			extents.min_y = min(offset_y, extents.min_y);
+		if (glyph_surfaces[i] == NULL)
+		{
+			continue;
 		}
-	}
-}
 
-bool is_possible_movement(Game_State* game_state, bool force_update)
-{
-	Tetromino* tetromino = &(game_state->current_tetromino);
-	Vector2 center = tetromino->pivot_position;
-	uint8_t current_rotation = tetromino->rotation;
-	enum Tetromino_Type type = tetromino->type;
-	int final_x_offset = 0;
-
-	if (center.x != game_state->previous_tetromino_position.x || 
-	    center.y != game_state->previous_tetromino_position.y ||
-		current_rotation != game_state->previous_tetromino_rotation || 
-		force_update)
-	{
-		// Check if this will be a valid move:	
-		for (size_t i = 0; i < MAX_TETROMINO_WIDTH; ++i)
+		if (x + glyph_surfaces[i]->w > GLYPH_ATLAS_WIDTH)
 		{
-			for (size_t j = 0; j < MAX_TETROMINO_HEIGHT; ++j)
-			{
-				uint8_t cell_value = TETROMINOES[type][current_rotation][j][i];
-
-				if (cell_value == 0)
-				{
-					continue;
-				}
-
-				int offset_x = i - TETROMINO_PIVOT_X;
-				int offset_y = j - TETROMINO_PIVOT_Y;
-				int board_x = center.x + offset_x;
-				int board_y = center.y - offset_y;
-
-				// Is this cell overflowing from right:
-				if (board_x >= BOARD_WIDTH )
-				{	
-					return false;
-				}
-
-				// Is this cell overflowing from left:
-				if (board_x < 0)
-				{
-					return false;
-				}
-
-				// Is this cell overflowing from top:
-				if (board_y >= BOARD_HEIGHT)
-				{	
-					return false;
-				}
-
-				// Is this cell overflowing from bottom:
-				if (board_y < 0)
-				{
-					return false;
-				}
-
-				// Is this cell already occupied by another tetromino:
-				if (get_2d_array_element(game_state->board, BOARD_WIDTH, board_x, board_y) != EMPTY_CELL_TYPE)
-				{
-					return false;
-				}
-			}
+			x = 0;
+			y += line_height;
 		}
+
+		atlas->glyphs[i] = (SDL_Rect){.x = x, .y = y, .w = glyph_surfaces[i]->w, .h = glyph_surfaces[i]->h};
+		x += glyph_surfaces[i]->w;
 	}
 
-	return true;
-}
+	SDL_Surface* atlas_surface = SDL_CreateRGBSurfaceWithFormat(0, GLYPH_ATLAS_WIDTH, y + line_height, 32, SDL_PIXELFORMAT_ARGB8888);
 
-void clamp_movement(Game_State* game_state)
-{
-	if (!is_possible_movement(game_state, game_state->should_spawn_tetromino))
+	if (atlas_surface != NULL)
 	{
-		game_state->current_tetromino.pivot_position = game_state->previous_tetromino_position;
-		game_state->current_tetromino.rotation = game_state->previous_tetromino_rotation;
-	} 
-}
-
-void put_tetromino_to_board(Game_State* game_state, bool force_update)
-{
-	Tetromino* tetromino = &(game_state->current_tetromino);
-	Vector2 position = tetromino->pivot_position;
-	uint8_t rotation = tetromino->rotation;
-	enum Tetromino_Type type = tetromino->type; 
-
-	printf("--- Putting Tetromino (Pivot: %i,%i) ---\n", position.x, position.y);
+		SDL_FillRect(atlas_surface, NULL, SDL_MapRGBA(atlas_surface->format, 0xff, 0xff, 0xff, 0x00));
+	}
 
-	for (size_t i = 0; i < MAX_TETROMINO_WIDTH; ++i)
+	for (int i = 0; i < GLYPH_COUNT; ++i)
 	{
-		for (size_t j = 0; j < MAX_TETROMINO_HEIGHT; ++j)
+		if (glyph_surfaces[i] == NULL)
 		{
-			uint8_t cell_value = TETROMINOES[type][rotation][j][i];
-
-			if (cell_value == 0)
-			{
-				continue;
-			}
-
-			int offset_x = i - TETROMINO_PIVOT_X;
-			int offset_y = j - TETROMINO_PIVOT_Y;
-			int board_x = position.x + offset_x;
-			int board_y = position.y - offset_y;
-
-			set_2d_array_element(game_state->board, BOARD_WIDTH, board_x, board_y, type);
-
-			printf("Added Type: %i -- At: %i, %i -- Rotation: %i\n", get_2d_array_element(game_state->board, BOARD_WIDTH, board_x, board_y), board_x, board_y, rotation);
+			continue;
 		}
-	}
-
-}
 
-void delete_tetromino_from_board(Game_State* game_state, enum Tetromino_Type type, uint16_t x, uint16_t y, uint8_t rotation)
-{
-	for (size_t i = 0; i < MAX_TETROMINO_WIDTH; ++i)
-	{
-		for (size_t j = 0; j < MAX_TETROMINO_HEIGHT; ++j)
+		if (atlas_surface != NULL)
 		{
-			uint8_t cell_value = TETROMINOES[type][rotation][j][i];
-
-			if (cell_value == 0)
-			{
-				continue;
-			}
-
-			int offset_x = i - TETROMINO_PIVOT_X;
-			int offset_y = j - TETROMINO_PIVOT_Y;
-			int board_x = x + offset_x;
-			int board_y = y - offset_y;
-
-			set_2d_array_element(game_state->board, BOARD_WIDTH, board_x, board_y, EMPTY_CELL_TYPE);
+			// Copy alpha as it is instead of blending it onto the atlas:
+			SDL_SetSurfaceBlendMode(glyph_surfaces[i], SDL_BLENDMODE_NONE);
+			SDL_BlitSurface(glyph_surfaces[i], NULL, atlas_surface, &atlas->glyphs[i]);
 		}
-	}	 
-}
-
-void move_tetromino_for_rotation(Game_State* game_state)
-{
-	Tetromino* tetromino = &(game_state->current_tetromino);
-	uint8_t previous_rotation = game_state->previous_tetromino_rotation;
 
-	if (previous_rotation == tetromino->rotation)
-	{
-		return;
+		SDL_FreeSurface(glyph_surfaces[i]);
 	}
 
-	if (is_possible_movement(game_state, false))
+	if (atlas_surface == NULL)
 	{
-		return;
-	}
-
-	uint16_t position_x = tetromino->pivot_position.x;
-	uint16_t position_y = tetromino->pivot_position.y;
-	uint8_t rotation = tetromino->rotation;
-	enum Tetromino_Type type = tetromino->type;
-	int higher_max_x = 0;
-	int lower_min_x = 0;
-
-	for (size_t i = 0; i < MAX_TETROMINO_WIDTH; ++i)
-	{
-		for (size_t j = 0; j < MAX_TETROMINO_HEIGHT; ++j)
-		{
-			uint8_t cell_value = TETROMINOES[type][rotation][j][i];
-
-			if (cell_value == 0)
-			{
-				continue;
-			}
-
-			int offset_x = i - TETROMINO_PIVOT_X;
-			int offset_y = j - TETROMINO_PIVOT_Y;
-			int board_x = position_x + offset_x;
-			int board_y = position_y - offset_y;
-
-			int higher_difference_x = board_x - (BOARD_WIDTH - 1);
-			int lower_difference_x = board_x;
-
-			higher_max_x = max(higher_difference_x, higher_max_x);
-			lower_min_x = min(lower_difference_x, lower_min_x);
-		}
+		printf("Glyph atlas could not be created! SDL Error: %s\n", SDL_GetError());
+		return false;
 	}
 
-	int final_offset_x = (higher_max_x) > 0 ? higher_max_x : lower_min_x;
-
-	tetromino->pivot_position.x -= final_offset_x;
-}
+	atlas->texture = SDL_CreateTextureFromSurface(renderer, atlas_surface);
+	SDL_FreeSurface(atlas_surface);
 
-inline void level_up(Game_State* game_state)
-{
-	if ( game_state->current_level < (LEVEL_COUNT - 1) && 
-		 game_state->line_count >= ((game_state->current_level + 1) * 10))
+	if (atlas->texture == NULL)
 	{
-		game_state->current_level++;
-		printf("--- LEVEL: %i ---\n", game_state->current_level);
+		printf("Glyph atlas texture could not be created! SDL Error: %s\n", SDL_GetError());
+		return false;
 	}
-}
 
-inline void add_score(Game_State* game_state, uint8_t lines_this_frame)
-{
-	switch (lines_this_frame)
-    {
-		case 1:
-			game_state->score += (40 * (game_state->current_level + 1));
-		case 2:
-			game_state->score += (100 * (game_state->current_level + 1));
-		case 3:
-			game_state->score += (300 * (game_state->current_level + 1));
-		case 4:
-			game_state->score += (1200 * (game_state->current_level + 1));
-    }
-
-	printf("--- SCORE: %i ---\n", game_state->score);
-}
+	SDL_SetTextureBlendMode(atlas->texture, SDL_BLENDMODE_BLEND);
 
-inline double get_current_fall_time(Game_State* game_state)
-{
-	return FALL_TIME_IN_SECS[game_state->current_level];
+	return true;
 }
 
-bool recycle_current_tetromino(Game_State* game_state)
+void destroy_glyph_atlas(Glyph_Atlas* atlas)
 {
-	Vector2 previous_position = game_state->previous_tetromino_position;
-	Vector2 current_position = game_state->current_tetromino.pivot_position; 
-	uint8_t current_rotation = game_state->current_tetromino.rotation;
-	uint8_t previous_rotation = game_state->previous_tetromino_rotation;
-
-	if (game_state->should_spawn_tetromino)
-	{
-		return true;
-	}
-
-	if (will_fall_this_turn(game_state) ||
-		current_position.x != previous_position.x || 
-		current_position.y != previous_position.y || 
-		current_rotation != previous_rotation)
+	if (atlas->texture != NULL)
 	{
-		enum Tetromino_Type type = game_state->current_tetromino.type;
-		
-		delete_tetromino_from_board(game_state, type, previous_position.x, previous_position.y, previous_rotation);
-		
-		printf("Deleted Type: %i -- At: %i, %i -- Rotation: %i\n", type, previous_position.x, previous_position.y, previous_rotation);
-
-		return true;
+		SDL_DestroyTexture(atlas->texture);
 	}
 
-	return false;
+	memset(atlas, 0, sizeof(*atlas));
 }
 
-inline bool will_fall_this_turn(Game_State* game_state)
+void initialize_text(Text* text, const Glyph_Atlas* atlas, Vector2 position, enum Text_Alignment alignment, Color color)
 {
-	return (game_state->fall_clock >= get_current_fall_time(game_state));
+	text->atlas = atlas;
+	text->buffer[0] = '\0';
+	text->alignment = alignment;
+	text->position = position;
+	text->color = color;
+	text->value = -1;
+	text->glyph_count = 0;
 }
 
-bool tetromino_fall(Game_State* game_state)
+void set_text(Text* text, const char* string)
 {
-	// Clamp movement to avoid overflows or collisions:
-	clamp_movement(game_state);
-		
-	game_state->fall_clock = 0.0f;
-	game_state->current_tetromino.pivot_position.y--;
+	const Glyph_Atlas* atlas = text->atlas;
+	int width = 0;
+	char previous = '\0';
 
-	if (!is_possible_movement(game_state, false))
+	if (string != text->buffer)
 	{
-		printf("--- Falled ---\n");
-		game_state->current_tetromino.pivot_position.y++;
-		return false;
+		snprintf(text->buffer, TEXT_BUFFER_SIZE, "%s", string);
 	}
 
-	return true;	
-}
+	// Lay glyphs out from 0 first, alignment needs the width of the whole text:
+	text->glyph_count = 0;
 
-void determine_current_destination(Game_State* game_state)
-{
-	int16_t initial_y = game_state->current_tetromino.pivot_position.y;
-	int16_t y_offset = 0;
-
-	while (is_possible_movement(game_state, false))
+	for (const char* character = text->buffer; *character != '\0'; ++character)
 	{
-		y_offset--;
-		game_state->current_tetromino.pivot_position.y--;
-	};
-
-	y_offset++;	
-
-	game_state->current_destination.y = initial_y + y_offset;
-	game_state->current_destination.x = game_state->current_tetromino.pivot_position.x;
-	game_state->current_tetromino.pivot_position.y = initial_y;
-
-	printf("--- Determined Current Destination: (%i, %i) initial_y: %i y_offset: %i ---\n", game_state->current_destination.x, game_state->current_destination.y, initial_y, y_offset);
-}
+		int i = *character - GLYPH_FIRST;
 
-void check_game_over(Game_State* game_state)
-{
-	// If tetromino cannot fall any further, and its pivot is beyond rendered board this means user has lost the game:
-	for (size_t j = BOARD_HEIGHT_RENDERED; j < BOARD_HEIGHT; ++j)
-	{
-		bool has_line = true;
-		
-		for (size_t i = 0; i < BOARD_WIDTH; ++i)
-		{	
-			enum Tetromino_Type tetromino_type = get_2d_array_element(game_state->board, BOARD_WIDTH, i, j);
-
-			if (tetromino_type != EMPTY_CELL_TYPE)
-			{
-				game_state->game_phase = GAME_PHASE_GAMEOVER;
-				return;
-			}
-		}
-	}
-}
-
-void destroy_lines(Game_State* game_state)
-{
-	uint8_t line_count = 0;
-	size_t new_board_index = 0;
-	uint8_t new_board[BOARD_SIZE]; 
-
-	memset(new_board, EMPTY_CELL_TYPE, BOARD_SIZE);
-
-	for (size_t j = 0; j < BOARD_HEIGHT; ++j)
-	{
-		bool has_line = true;
-		
-		for (size_t i = 0; i < BOARD_WIDTH; ++i)
-		{	
-			enum Tetromino_Type tetromino_type = get_2d_array_element(game_state->board, BOARD_WIDTH, i, j);
-
-			if (tetromino_type == EMPTY_CELL_TYPE)
-			{
-				has_line = false;
-				break;
-			}
-		}
-
-		if (has_line)
+		if (i < 0 || i >= GLYPH_COUNT)
 		{
-			game_state->tetromino_lines[j] = DURATION_LINE_ANIMATION;
-			line_count++;
 			continue;
 		}
 
-		for (size_t i = 0; i < BOARD_WIDTH; ++i)
-		{	
-			enum Tetromino_Type tetromino_type = get_2d_array_element(game_state->board, BOARD_WIDTH, i, j);
-
-			new_board[new_board_index + i] = tetromino_type;
+		if (previous != '\0')
+		{
+			width += TTF_GetFontKerningSizeGlyphs(atlas->font, (Uint16)previous, (Uint16)*character);
 		}
 
-		new_board_index += BOARD_WIDTH;
-	}
+		if (atlas->glyphs[i].w > 0)
+		{
+			text->sources[text->glyph_count] = atlas->glyphs[i];
+			text->destinations[text->glyph_count] = (SDL_Rect){.x = width, .y = text->position.y, .w = atlas->glyphs[i].w, .h = atlas->glyphs[i].h};
+			text->glyph_count++;
+		}
 
-	for (size_t i = 0; i < BOARD_SIZE; ++i)
-	{
-		game_state->board[i] = new_board[i];
+		width += atlas->advances[i];
+		previous = *character;
 	}
-	
-	game_state->line_count += line_count;
-}
 
-void update_line_data(Game_State* game_state)
-{
-	float_t delta_time = game_state->delta_time;
+	int x_offset = text->position.x;
 
-	for (size_t i = 0; i < BOARD_HEIGHT_RENDERED; i++)
+	switch (text->alignment)
 	{
-		float_t remaining_duration = game_state->tetromino_lines[i];
-		remaining_duration = max(0, remaining_duration - delta_time);
-		game_state->tetromino_lines[i] = remaining_duration;
-	}
-}
+	case TEXT_ALIGNMENT_LEFT:
+		break;
 
-void update_game_text(Game_State* game_state, Text_State* text_state)
-{
-	switch (game_state->game_phase)
-	{
-	case GAME_PHASE_PLAYING:
-		snprintf(text_state->level_text.buffer, TEXT_BUFFER_SIZE, "LEVEL: %i", game_state->current_level);
-		snprintf(text_state->line_text.buffer, TEXT_BUFFER_SIZE, "LINES: %i", game_state->line_count);
-		snprintf(text_state->score_text.buffer, TEXT_BUFFER_SIZE, "SCORE: %i", game_state->score);
+	case TEXT_ALIGNMENT_CENTER:
+		x_offset -= width / 2;
 		break;
-	default:
+
+	case TEXT_ALIGNMENT_RIGHT:
+		x_offset -= width;
 		break;
 	}
-}
 
-void update_game_playing_phase(Game_State* game_state, Input_State* input_state)
-{
-	if (game_state->should_spawn_tetromino)
+	for (int i = 0; i < text->glyph_count; ++i)
 	{
-		enum Tetromino_Type initial_tetromino_type = (enum Tetromino_Type)random_range(0, TETROMINO_TYPE_COUNT-1);
-
-		printf("Generated new tetromino of type: %i\n", initial_tetromino_type);
-
-		Vector2 spawn_position = {.x = 4, .y = 20};
-
-		Tetromino new_tetromino = {
-			.pivot_position = spawn_position,
-			.rotation = 0,
-			.type = initial_tetromino_type,
-		};
-
-		// Set initial state:
-		game_state->current_tetromino = new_tetromino;
-		game_state->previous_tetromino_position = spawn_position;
-		game_state->previous_tetromino_rotation = 0;
+		text->destinations[i].x += x_offset;
 	}
+}
 
-	// Update line related data if any line is currently active:
-	update_line_data(game_state);
-
-	// Parse input commands:
-	parse_input_state_playing_phase(game_state, input_state);
-
-	// If created new and in illegal cell after parsing input, go to game over state:
-	if (game_state->should_spawn_tetromino && !is_possible_movement(game_state, true))
+void set_text_value(Text* text, const char* format, uint32_t value)
+{
+	// Most frames show the same numbers as the frame before, those cost a compare:
+	if (text->value == (int64_t)value)
 	{
-		game_state->game_phase = GAME_PHASE_GAMEOVER;
 		return;
 	}
 
-	// Tick the fall clock:
-	game_state->fall_clock += (float_t)game_state->delta_time;
+	text->value = value;
+	snprintf(text->buffer, TEXT_BUFFER_SIZE, format, value);
+	set_text(text, text->buffer);
+}
 
-	// Delete previous state of same tetromino if any feature is different from the previous state:
-	bool recycled_tetromino = recycle_current_tetromino(game_state);
-	
-	// This flag is controlled by fall algorithm, which decides if the tetromino can fall any further:
-	bool cannot_fall = false;
-	
-	// Decide if fall will occur this time:
-	if (will_fall_this_turn(game_state))	
-	{	
-		// Try falling, get if fall was successfull:
-		cannot_fall = !tetromino_fall(game_state);
-	}
+void draw_text(Render_Backend* backend, const Text* text)
+{
+	SDL_Texture* texture = text->atlas->texture;
 
-	// Cache tetromino memory location:
-	Tetromino* current_tetromino = &(game_state->current_tetromino);
-	
-	// Move tetromino horizontally if colliding with borders of board:
-	move_tetromino_for_rotation(game_state, game_state->should_spawn_tetromino);
+	SDL_SetTextureColorMod(texture, text->color.r, text->color.g, text->color.b);
+	SDL_SetTextureAlphaMod(texture, text->color.a);
 
-	// Put the new state of tetromino to the board if previous was deleted or this is a new tetromino:
-	if (recycled_tetromino || game_state->should_spawn_tetromino)
+	for (int i = 0; i < text->glyph_count; ++i)
 	{
-		// Clamp movement to avoid overflows or collisions:
-		clamp_movement(game_state);
-
-		// Determine final possible final destination for currently falling tetromino:
-		determine_current_destination(game_state);
-
-		// Fill corresponding cells in board:
-		put_tetromino_to_board(game_state, game_state->should_spawn_tetromino);
+		SDL_RenderCopy(backend->renderer, texture, &text->sources[i], &text->destinations[i]);
 	}
 
-	// Set previouses:
-	// These are highly used for validation of any movement.
-	game_state->previous_tetromino_position = current_tetromino->pivot_position;
-	game_state->previous_tetromino_rotation = current_tetromino->rotation;
-
-	// Set should_spawn_tetromino to cannot_fall so that new tetromino is spawned if the current one cannot fall any further:
-	game_state->should_spawn_tetromino = cannot_fall;
-
-	if (game_state->should_spawn_tetromino)
-	{
-		// Get line count before destroying new ones,
-		// Destroy the lines if there are any,
-		// Calculate new lines destroyed this frame,
-		uint8_t new_line_count = game_state->line_count;
-		destroy_lines(game_state);
-		new_line_count = (game_state->line_count - new_line_count);
-
-		// Add score using new lines:
-		add_score(game_state, new_line_count);
-
-		// Check for game over condition:
-		check_game_over(game_state);
-
-		// Level up if requirements are met:
-		level_up(game_state);
-	}
+	backend->draw_call_count += text->glyph_count;
 }
 
-void update_game_gameover_phase(Game_State* game_state, Input_State* input_state)
+bool initialize_text_state(Text_State* text_state, SDL_Renderer* renderer, TTF_Font* font_24pt, TTF_Font* font_16pt)
 {
-	if (input_state->pressed_space)
-	{
-		// Reset game state:
-		initialize_game_state(game_state);
-	}
-}
+	memset(text_state, 0, sizeof(*text_state));
 
-void update_game(Game_State* game_state, Input_State* input_state)
-{	
-	switch (game_state->game_phase)
+	if (!create_glyph_atlas(renderer, font_24pt, &text_state->atlas_24pt) || !create_glyph_atlas(renderer, font_16pt, &text_state->atlas_16pt))
 	{
-	case GAME_PHASE_PLAYING:
-		update_game_playing_phase(game_state, input_state);
-	break;
-	
-	case GAME_PHASE_GAMEOVER:
-		update_game_gameover_phase(game_state, input_state);
-	break;
+		destroy_text_state(text_state);
+		return false;
 	}
 
-}
-
-void initialize_game_state(Game_State* game_state)
-{
-	// Clear board to empty cells:
-	memset(&game_state->board, EMPTY_CELL_TYPE, BOARD_SIZE);
+	Text* texts = text_state->texts;
 
-	// Initialize lines to 0.0f:
-	memset(&game_state->tetromino_lines, 0.0f, BOARD_HEIGHT_RENDERED);
+	// Initialize Texts:
+	initialize_text(&texts[RENDER_TEXT_LEVEL], &text_state->atlas_16pt, (Vector2){.x = SCREEN_WIDTH - TETROMINO_SIZE, .y = TETROMINO_SIZE}, TEXT_ALIGNMENT_RIGHT, LINE_COLOR);
+	initialize_text(&texts[RENDER_TEXT_LINES], &text_state->atlas_16pt, (Vector2){.x = SCREEN_WIDTH - TETROMINO_SIZE, .y = TETROMINO_SIZE * 1.5}, TEXT_ALIGNMENT_RIGHT, LINE_COLOR);
+	initialize_text(&texts[RENDER_TEXT_SCORE], &text_state->atlas_16pt, (Vector2){.x = TETROMINO_SIZE, .y = TETROMINO_SIZE}, TEXT_ALIGNMENT_LEFT, LINE_COLOR);
 
-	game_state->game_phase = GAME_PHASE_PLAYING;
-	game_state->should_spawn_tetromino = true;  
+	// Texts that never change are laid out once:
+	initialize_text(&texts[RENDER_TEXT_GAME_OVER], &text_state->atlas_24pt, (Vector2){.x = SCREEN_WIDTH/2, .y = SCREEN_HEIGHT/2}, TEXT_ALIGNMENT_CENTER, LINE_COLOR);
+	set_text(&texts[RENDER_TEXT_GAME_OVER], "GAME OVER");
+	initialize_text(&texts[RENDER_TEXT_PLAY_AGAIN], &text_state->atlas_16pt, (Vector2){.x = SCREEN_WIDTH/2, .y = (SCREEN_HEIGHT/2) + 32}, TEXT_ALIGNMENT_CENTER, LINE_COLOR);
+	set_text(&texts[RENDER_TEXT_PLAY_AGAIN], "PRESS SPACE TO PLAY AGAIN");
 
-	game_state->current_level = 0;
-	game_state->line_count = 0;
-	game_state->score = 0;
-	
-	// Delta time:
-	game_state->delta_time = 0.0;
+	return true;
+}
 
-	game_state->current_destination = (Vector2) {.x = 0, .y = 0};
-	game_state->fall_clock = 0.0f;
+void destroy_text_state(Text_State* text_state)
+{
+	destroy_glyph_atlas(&text_state->atlas_24pt);
+	destroy_glyph_atlas(&text_state->atlas_16pt);
 }
 
-void initialize_game(Game_State* game_state, Input_State* input_state, Text_State* text_state)
+void initialize_game(Game_State* game_state, Input_State* input_state, uint64_t seed)
 {
 	// Reset game_state related variables:
-	initialize_game_state(game_state);	
+	initialize_game_state(game_state, seed, PIECE_RANDOMIZER_UNIFORM);	
 
 	// Reset input variables:
 	reset_input_state(input_state);
-
-	// Initialize Texts:
-	text_state->level_text.position = (Vector2){.x = SCREEN_WIDTH - TETROMINO_SIZE, .y = TETROMINO_SIZE};
-	text_state->level_text.alignment = TEXT_ALIGNMENT_RIGHT;
-	
-	text_state->line_text.position = (Vector2){.x = SCREEN_WIDTH - TETROMINO_SIZE, .y = TETROMINO_SIZE * 1.5};
-	text_state->line_text.alignment = TEXT_ALIGNMENT_RIGHT;
-	
-	text_state->score_text.position = (Vector2){.x = TETROMINO_SIZE, .y = TETROMINO_SIZE};
-	text_state->score_text.alignment = TEXT_ALIGNMENT_LEFT;
 }
 
-void reset_input_state(Input_State* input_state)
+SDL_Texture* create_tile_atlas(SDL_Renderer* renderer)
 {
-	input_state->pressed_down = false;
-	input_state->pressed_left = false;
-	input_state->pressed_right = false;
-	input_state->pressed_up = false;
-	input_state->pressed_space = false;
-}
+	SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, TILE_COUNT * TETROMINO_SIZE, TETROMINO_SIZE, 32, SDL_PIXELFORMAT_ARGB8888);
 
-void parse_input_state_playing_phase(Game_State* game_state, Input_State* input_state)
-{
-	if (input_state->pressed_right)
+	if (surface == NULL)
 	{
-		printf("INPUT: Pressed right\n");
-		game_state->current_tetromino.pivot_position.x++;
+		printf("Tile atlas could not be created! SDL Error: %s\n", SDL_GetError());
+		return NULL;
 	}
 
-	if (input_state->pressed_left)
+	SDL_FillRect(surface, NULL, SDL_MapRGBA(surface->format, 0x00, 0x00, 0x00, 0x00));
+
+	// Tiles look the same as in every other backend:
+	for (int tile = 0; tile < TILE_COUNT; ++tile)
 	{
-		printf("INPUT: Pressed left\n");
-		game_state->current_tetromino.pivot_position.x--;
+		Tile_Rect rects[MAX_TILE_RECT_COUNT];
+		uint32_t rect_count = get_tile_rects((enum Tile)tile, rects);
+
+		for (uint32_t i = 0; i < rect_count; ++i)
+		{
+			SDL_Rect rect = {.x = tile * TETROMINO_SIZE + rects[i].x, .y = rects[i].y, .w = rects[i].width, .h = rects[i].height};
+			Color color = rects[i].color;
+
+			SDL_FillRect(surface, &rect, SDL_MapRGBA(surface->format, color.r, color.g, color.b, color.a));
+		}
 	}
 
-	if (input_state->pressed_up)
+	SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+	SDL_FreeSurface(surface);
+
+	if (texture == NULL)
 	{
-		printf("INPUT: Pressed up\n");
-		game_state->current_tetromino.rotation = (game_state->current_tetromino.rotation + 1) % TETROMINO_ROTATION_COUNT;
+		printf("Tile atlas texture could not be created! SDL Error: %s\n", SDL_GetError());
+		return NULL;
 	}
 
-	if (input_state->pressed_down)
+	// Ghost and empty cells leave their border transparent:
+	SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
+	return texture;
+}
+
+Render_Backend* create_render_backend(SDL_Renderer* renderer, Text_State* text_state)
+{
+	Render_Backend* backend = malloc(sizeof(Render_Backend));
+
+	if (backend == NULL)
 	{
-		printf("INPUT: Pressed down\n");
-		// game_state->current_tetromino.rotation = (game_state->current_tetromino.rotation - 1 + TETROMINO_ROTATION_COUNT) % TETROMINO_ROTATION_COUNT;
-		game_state->current_tetromino.pivot_position.y--;
+		printf("Render backend could not be allocated!\n");
+		return NULL;
 	}
 
-	if (input_state->pressed_space)
+	memset(backend->layer_textures, 0, sizeof(backend->layer_textures));
+	backend->renderer = renderer;
+	backend->tile_atlas = create_tile_atlas(renderer);
+	backend->text_state = text_state;
+	backend->draw_call_count = 0;
+	backend->use_layer_cache = SDL_RenderTargetSupported(renderer);
+	backend->valid_layers = 0;
+
+	if (backend->tile_atlas == NULL)
 	{
-		printf("INPUT: Pressed space\n");
+		free(backend);
+		return NULL;
 	}
-}
 
-void render_game_text_playing_phase(Game_State* game_state, Text_State* text_state, SDL_Renderer* renderer, TTF_Font* font_24pt, TTF_Font* font_16pt)
-{
-	draw_text(renderer, font_16pt, text_state->score_text.buffer, text_state->score_text.position, text_state->score_text.alignment, TEXT_RENDER_MODE_BLENDED, LINE_COLOR);
-	draw_text(renderer, font_16pt, text_state->line_text.buffer, text_state->line_text.position, text_state->line_text.alignment, TEXT_RENDER_MODE_BLENDED, LINE_COLOR);
-	draw_text(renderer, font_16pt, text_state->level_text.buffer, text_state->level_text.position, text_state->level_text.alignment, TEXT_RENDER_MODE_BLENDED, LINE_COLOR);
-}
+	if (!backend->use_layer_cache)
+	{
+		printf("Renderer has no render targets, every layer is drawn every frame\n");
+	}
 
-void render_game_text_gameover_phase(Game_State* game_state, Text_State* text_state, SDL_Renderer* renderer, TTF_Font* font_24pt, TTF_Font* font_16pt)
-{
-	render_game_text_playing_phase(game_state, text_state, renderer, font_24pt, font_16pt);
-	
-	// Render gameover text over game phase text:
-	draw_text(renderer, font_24pt, "GAME OVER", (Vector2){.x = SCREEN_WIDTH/2, .y = SCREEN_HEIGHT/2}, TEXT_ALIGNMENT_CENTER, TEXT_RENDER_MODE_BLENDED, LINE_COLOR);
-	draw_text(renderer, font_16pt, "PRESS SPACE TO PLAY AGAIN",(Vector2) {.x = SCREEN_WIDTH/2, .y = (SCREEN_HEIGHT/2) + 32}, TEXT_ALIGNMENT_CENTER, TEXT_RENDER_MODE_BLENDED, LINE_COLOR);
-}	
+	return backend;
+}
 
-void render_game_text(Game_State* game_state, Text_State* text_state, SDL_Renderer* renderer, TTF_Font* font_24pt, TTF_Font* font_16pt)
+void destroy_render_backend(Render_Backend* backend)
 {
-	switch (game_state->game_phase)
+	for (int i = 0; i < RENDER_LAYER_COUNT; ++i)
 	{
-	case GAME_PHASE_PLAYING:
-		render_game_text_playing_phase(game_state, text_state, renderer, font_24pt, font_16pt);
-		break;
-	case GAME_PHASE_GAMEOVER:
-		render_game_text_gameover_phase(game_state, text_state, renderer, font_24pt, font_16pt);
-	default:
-		break;
+		if (backend->layer_textures[i] != NULL)
+		{
+			SDL_DestroyTexture(backend->layer_textures[i]);
+		}
 	}
-}
 
-void draw_tetromino_unit(SDL_Renderer* renderer, int row, int column, enum Tetromino_Type type)
-{
-	int x_position = BOARD_OFFSET_X + (row * (TETROMINO_SIZE));
-	int y_position = BOARD_OFFSET_Y + ((BOARD_HEIGHT - 1 - column) * (TETROMINO_SIZE));
-		
-	draw_filled_rectangle(renderer, x_position, y_position, TETROMINO_SIZE, TETROMINO_SIZE, COLORS[type][2]);
-	draw_filled_rectangle(renderer, x_position + 3, y_position, TETROMINO_SIZE - 3, TETROMINO_SIZE - 3, COLORS[type][0]);
-	draw_filled_rectangle(renderer, x_position + 3, y_position + 3, TETROMINO_SIZE - 6, TETROMINO_SIZE - 6, COLORS[type][1]);
+	SDL_DestroyTexture(backend->tile_atlas);
+	free(backend);
 }
 
-void draw_empty_cell(SDL_Renderer* renderer, int row, int column)
+void invalidate_render_layers(Render_Backend* backend)
 {
-	int x_position = BOARD_OFFSET_X + (row * (TETROMINO_SIZE));
-	int y_position = BOARD_OFFSET_Y + ((BOARD_HEIGHT - 1 - column) * (TETROMINO_SIZE));
-
-	draw_filled_rectangle(renderer, x_position + 3, y_position + 3, TETROMINO_SIZE - 6, TETROMINO_SIZE - 6, EMPTY_CELL_COLOR);
+	backend->valid_layers = 0;
 }
 
-void draw_current_destination(Game_State* game_state, SDL_Renderer* renderer)
+void draw_render_commands(Render_Backend* backend, const Render_Command* commands, uint32_t command_count)
 {
-	if (game_state->game_phase == GAME_PHASE_GAMEOVER)
-	{
-		return;
-	}
-
-	Tetromino tetromino = (game_state->current_tetromino);
-	Vector2 destination = game_state->current_destination;
+	uint32_t i = 0;
 
-	for (size_t i = 0; i < MAX_TETROMINO_WIDTH; ++i)
+	while (i < command_count)
 	{
-		for (size_t j = 0; j < MAX_TETROMINO_HEIGHT; ++j)
+		const Render_Command* command = &commands[i];
+		uint32_t end = i + 1;
+
+		// Commands that continue a draw call go to the renderer with it:
+		while (end < command_count && continues_draw_call(&commands[end - 1], &commands[end]))
 		{
-			uint8_t cell_value = TETROMINOES[tetromino.type][tetromino.rotation][j][i];
+			++end;
+		}
 
-			if (cell_value == 0)
+		switch (command->type)
+		{
+		case RENDER_COMMAND_FILL:
+			for (uint32_t j = i; j < end; ++j)
 			{
-				continue;
+				backend->rects[j - i] = (SDL_Rect){.x = commands[j].x, .y = commands[j].y, .w = commands[j].width, .h = commands[j].height};
 			}
 
-			int16_t offset_x = i - TETROMINO_PIVOT_X;
-			int16_t offset_y = j - TETROMINO_PIVOT_Y;
-			int board_x = destination.x + offset_x;
-			int board_y = destination.y - offset_y;
-			
-			int x_position = BOARD_OFFSET_X + (board_x * (TETROMINO_SIZE));
-			int y_position = BOARD_OFFSET_Y + ((BOARD_HEIGHT - 1 - board_y) * (TETROMINO_SIZE));
+			SDL_SetRenderDrawColor(backend->renderer, command->color.r, command->color.g, command->color.b, command->color.a);
+			SDL_RenderFillRects(backend->renderer, backend->rects, end - i);
+			backend->draw_call_count++;
+			break;
 
-			if (board_y >= BOARD_HEIGHT_RENDERED)
+		case RENDER_COMMAND_TILE:
+			for (uint32_t j = i; j < end; ++j)
 			{
-				continue;
+				SDL_Rect source = {.x = commands[j].id * TETROMINO_SIZE, .y = 0, .w = TETROMINO_SIZE, .h = TETROMINO_SIZE};
+				SDL_Rect destination = {.x = commands[j].x, .y = commands[j].y, .w = TETROMINO_SIZE, .h = TETROMINO_SIZE};
+
+				SDL_RenderCopy(backend->renderer, backend->tile_atlas, &source, &destination);
+				backend->draw_call_count++;
 			}
-			
-			// draw_filled_rectangle(renderer, x_position, y_position, TETROMINO_SIZE, TETROMINO_SIZE, COLORS[tetromino.type][1]);
-			draw_filled_rectangle(renderer, x_position + 3, y_position + 3, TETROMINO_SIZE - 6, TETROMINO_SIZE - 6, COLORS[tetromino.type][2]);
-		}
-	}
-}
 
-void draw_tetrominoes(Game_State* game_state, SDL_Renderer* renderer)
-{
-	for (size_t i = 0; i < BOARD_WIDTH; ++i)
-	{
-		for (size_t j = 0; j < BOARD_HEIGHT; ++j)
-		{	
-			uint8_t current_board_element_type = get_2d_array_element(game_state->board, BOARD_WIDTH, i,j); 
+			break;
 
-			if (current_board_element_type == EMPTY_CELL_TYPE)
+		case RENDER_COMMAND_TEXT:
+		{
+			Text* text = &backend->text_state->texts[command->id];
+
+			if (TEXT_FORMATS[command->id] != NULL)
 			{
-				continue;
+				set_text_value(text, TEXT_FORMATS[command->id], command->value);
 			}
 
-			draw_tetromino_unit(renderer, i, j, current_board_element_type);
+			draw_text(backend, text);
+			break;
 		}
-	}
-}
 
-void draw_board_cells(Game_State* game_state, SDL_Renderer* renderer)
-{
-	for (size_t i = 0; i < BOARD_WIDTH; ++i)
-	{
-		for (size_t j = 0; j < BOARD_HEIGHT_RENDERED; ++j)
-		{	
-			uint8_t current_board_element_type = get_2d_array_element(game_state->board, BOARD_WIDTH, i,j); 
-			
-			// Don't draw if cell is not empty:
-			if (current_board_element_type != EMPTY_CELL_TYPE)
-			{
-				continue;
-			}
-		
-			draw_empty_cell(renderer, i, j);
+		default:
+			break;
 		}
+
+		i = end;
 	}
 }
 
-void draw_lines(Game_State* game_state, SDL_Renderer* renderer)
+void submit_render_commands(Render_Backend* backend, const Render_Command_Buffer* buffer)
 {
-	for (size_t j = 0; j < BOARD_HEIGHT_RENDERED; ++j)
+	SDL_Renderer* renderer = backend->renderer;
+	uint32_t begin = 0;
+
+	// Fills with alpha blend, the game over overlay is the only one that is not opaque:
+	SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+
+	// Commands are sorted, each layer is one run of them:
+	for (int layer = 0; layer < RENDER_LAYER_COUNT; ++layer)
 	{
-		// Read line data from tetromino_lines, if it is 0, that means line on that row is not active:
-		if (game_state->tetromino_lines[j] <= 0.0f)
+		uint32_t end = begin;
+		uint32_t layer_bit = 1u << layer;
+
+		while (end < buffer->command_count && buffer->commands[end].layer == layer)
 		{
-			continue;
+			++end;
 		}
 
-		// Draw squares on that row:
-		for (size_t i = 0; i < BOARD_WIDTH; ++i)
+		if ((buffer->cached_layers & layer_bit) && backend->use_layer_cache && backend->layer_textures[layer] == NULL)
 		{
-			int x_position = BOARD_OFFSET_X + (i * (TETROMINO_SIZE));
-			int y_position = BOARD_OFFSET_Y + ((BOARD_HEIGHT - 1 - j) * (TETROMINO_SIZE));
-
-			// Calculate scale by time remaining on this line:
-			float_t scale = game_state->tetromino_lines[j] / DURATION_LINE_ANIMATION;
-			int size = (int)((float_t)TETROMINO_SIZE * scale);
-			int delta_half = (TETROMINO_SIZE - size) / 2;
+			backend->layer_textures[layer] = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, SCREEN_WIDTH, SCREEN_HEIGHT);
 
-			// Draw square using scaled values:
-			draw_filled_rectangle(renderer, x_position + delta_half, y_position + delta_half, TETROMINO_SIZE - delta_half*2, TETROMINO_SIZE - delta_half*2, LINE_COLOR);
+			if (backend->layer_textures[layer] == NULL)
+			{
+				printf("Layer texture could not be created, every layer is drawn every frame! SDL Error: %s\n", SDL_GetError());
+				backend->use_layer_cache = false;
+			}
+			else
+			{
+				SDL_SetTextureBlendMode(backend->layer_textures[layer], SDL_BLENDMODE_BLEND);
+			}
 		}
-	}
-}
-
-void render_game_playing_phase(Game_State* game_state, SDL_Renderer* renderer)
-{
-	// Draw empty cells:
-	draw_board_cells(game_state, renderer);
 
-	// Draw the final destination of tetromino:
-	draw_current_destination(game_state, renderer);
-	
-	// Draw All Tetrominoes:
-	draw_tetrominoes(game_state, renderer);
+		if ((buffer->cached_layers & layer_bit) && backend->use_layer_cache)
+		{
+			SDL_Texture* texture = backend->layer_textures[layer];
 
-	// Draw Lines:
-	draw_lines(game_state, renderer);
-}
+			if (!(backend->valid_layers & layer_bit) || backend->layer_keys[layer] != buffer->layer_keys[layer])
+			{
+				SDL_SetRenderTarget(renderer, texture);
+				SDL_SetRenderDrawColor(renderer, 0x00, 0x00, 0x00, 0x00);
+				SDL_RenderClear(renderer);
+				draw_render_commands(backend, &buffer->commands[begin], end - begin);
+				SDL_SetRenderTarget(renderer, NULL);
 
-void render_game_gameover_phase(Game_State* game_state, SDL_Renderer* renderer)
-{
-	render_game_playing_phase(game_state, renderer);
-	SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-	draw_filled_rectangle(renderer, 0,0, SCREEN_WIDTH, SCREEN_HEIGHT, (Color) {.r = 0x00, .g = 0x00, .b = 0x00, .a = 0x80});
-}
+				backend->layer_keys[layer] = buffer->layer_keys[layer];
+				backend->valid_layers |= layer_bit;
+			}
 
-void render_game(Game_State* game_state, SDL_Renderer* renderer)
-{
-	switch (game_state->game_phase)
-	{
-	case GAME_PHASE_PLAYING:
-		render_game_playing_phase(game_state, renderer);
-	break;
+			SDL_RenderCopy(renderer, texture, NULL, NULL);
+			backend->draw_call_count++;
+		}
+		else
+		{
+			draw_render_commands(backend, &buffer->commands[begin], end - begin);
+		}
 
-	case GAME_PHASE_GAMEOVER:	
-		render_game_gameover_phase(game_state, renderer);
-	break;
+		begin = end;
 	}
-}	
-
+}
@@ -0,0 +1,62 @@
+/* ISMET BARAN SURUCU -- github.com/baransrc */
+#include "tetris_util.h"
+#include "tetris_perft.h"
+#include "tetris_platform.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#define PERFT_DEFAULT_DEPTH 4
+#define PERFT_REFERENCE_SEED 1
+#define PERFT_REFERENCE_DEPTH 4
+
+// Leaf counts of a new uniform game seeded with PERFT_REFERENCE_SEED, index is the depth:
+static const uint64_t PERFT_REFERENCE_COUNTS[PERFT_REFERENCE_DEPTH + 1] = {
+	1,
+	17,
+	300,
+	10727,
+	196126,
+};
+
+int main(int argc, char* args[])
+{
+	uint32_t depth = (argc > 1) ? (uint32_t)strtoul(args[1], NULL, 10) : PERFT_DEFAULT_DEPTH;
+	uint64_t seed = (argc > 2) ? strtoull(args[2], NULL, 10) : PERFT_REFERENCE_SEED;
+	uint32_t thread_count = (argc > 3) ? (uint32_t)strtoul(args[3], NULL, 10) : get_cpu_count();
+	bool failed = false;
+
+	if (depth == 0 || depth > MAX_PERFT_DEPTH)
+	{
+		printf("Depth has to be between 1 and %d\n", MAX_PERFT_DEPTH);
+		return 1;
+	}
+
+	printf("seed: %llu threads: %u\n", (unsigned long long)seed, max(thread_count, 1));
+
+	for (uint32_t d = 1; d <= depth; ++d)
+	{
+		Perft_Result result;
+
+		if (!run_perft(seed, PIECE_RANDOMIZER_UNIFORM, d, thread_count, &result))
+		{
+			printf("Could not run perft at depth %u\n", d);
+			return 1;
+		}
+
+		printf("depth %2u: %14llu leaves %14llu nodes %10llu game overs %8.3fs %12.0f nodes/s", d, (unsigned long long)result.leaf_count, (unsigned long long)result.node_count, (unsigned long long)result.game_over_count, result.seconds, result.node_count / result.seconds);
+
+		// Known counts catch any change in how the engine places pieces:
+		if (seed == PERFT_REFERENCE_SEED && d <= PERFT_REFERENCE_DEPTH)
+		{
+			bool matches = (result.leaf_count == PERFT_REFERENCE_COUNTS[d]);
+
+			printf(" %s", matches ? "ok" : "MISMATCH");
+			failed = failed || !matches;
+		}
+
+		printf("\n");
+	}
+
+	return failed ? 1 : 0;
+}
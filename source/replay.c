@@ -0,0 +1,457 @@
+/* ISMET BARAN SURUCU -- github.com/baransrc */
+#include "tetris_util.h"
+#include "tetris_core.h"
+#include "tetris_replay.h"
+#include "tetris_archive.h"
+#include "tetris_verify.h"
+#include "tetris_platform.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#define REPLAY_DEFAULT_TICK_COUNT 1000000
+#define REPLAY_DEFAULT_PLAY_COUNT 10
+#define REPLAY_DEFAULT_GAME_COUNT 100000
+#define REPLAY_DEFAULT_SEEK_COUNT 1000
+// A random key every few ticks on average, about as busy as a fast player:
+#define REPLAY_INPUT_ONE_IN 6
+#define REPLAY_SWITCH_ONE_IN 100000
+
+static uint8_t get_random_event(Random_State* random)
+{
+	uint8_t event = 0;
+
+	if (random_below(random, REPLAY_INPUT_ONE_IN) == 0)
+	{
+		event = (uint8_t)(1 << random_below(random, 5));
+	}
+
+	if (random_below(random, REPLAY_SWITCH_ONE_IN) == 0)
+	{
+		event |= REPLAY_EVENT_SWITCH_ROTATION_SYSTEM;
+	}
+
+	return event;
+}
+
+static void print_game(const char* label, const Game_State* game_state)
+{
+	printf("%s, last game: ticks: %llu lines: %u score: %u level: %u\n", label, (unsigned long long)game_state->tick_count, game_state->line_count, game_state->score, game_state->current_level);
+}
+
+static int record(const char* path, uint64_t seed, uint64_t tick_count, uint32_t keyframe_interval)
+{
+	// Plays random inputs through the same event path as the game, then saves and checks the replay:
+	Game_State game_state;
+	Game_State played_state;
+	Random_State random;
+	Replay replay;
+	Replay loaded;
+
+	initialize_game_state(&game_state, seed, PIECE_RANDOMIZER_BAG);
+	seed_random(&random, seed ^ 0x9e3779b97f4a7c15ull);
+
+	if (!initialize_replay(&replay, &game_state, seed, keyframe_interval))
+	{
+		printf("Could not allocate the replay\n");
+		return 1;
+	}
+
+	for (uint64_t tick = 0; tick < tick_count; ++tick)
+	{
+		uint8_t event = get_random_event(&random);
+
+		if (!record_replay_tick(&replay, &game_state, event))
+		{
+			printf("Could not grow the replay\n");
+			free_replay(&replay);
+			return 1;
+		}
+
+		play_replay_event(&game_state, event);
+	}
+
+	bool saved = save_replay(&replay, path);
+
+	printf("seed: %llu events: %zu bytes (%.3f bytes/tick), keyframes: %zu of %zu bytes every %u ticks\n", (unsigned long long)seed, replay.event_size, (double)replay.event_size / (double)max(tick_count, 1), replay.keyframe_count, sizeof(Replay_Keyframe), keyframe_interval);
+	free_replay(&replay);
+
+	if (!saved || !load_replay(&loaded, path))
+	{
+		printf("Could not write %s\n", path);
+		return 1;
+	}
+
+	play_replay(&played_state, &loaded);
+	free_replay(&loaded);
+
+	print_game("recorded", &game_state);
+	print_game("replayed", &played_state);
+
+	bool same = played_state.tick_count == game_state.tick_count && played_state.score == game_state.score &&
+				played_state.line_count == game_state.line_count && memcmp(&played_state.board, &game_state.board, sizeof(Board)) == 0;
+
+	printf("%s\n", same ? "replay matches" : "REPLAY MISMATCH");
+
+	return same ? 0 : 1;
+}
+
+static int play(const char* path, uint32_t play_count)
+{
+	// Plays the replay back at full speed, nothing drawn:
+	Game_State game_state;
+	Replay replay;
+
+	if (!load_replay(&replay, path))
+	{
+		printf("Could not read %s\n", path);
+		return 1;
+	}
+
+	play_count = max(play_count, 1);
+
+	double start = get_time_in_seconds();
+	uint64_t tick_count = 0;
+
+	for (uint32_t i = 0; i < play_count; ++i)
+	{
+		tick_count += play_replay(&game_state, &replay);
+	}
+
+	double seconds = get_time_in_seconds() - start;
+
+	print_game("replay", &game_state);
+	printf("events: %zu bytes, played %u times\n", replay.event_size, play_count);
+	printf("time: %.3fs -- %.0f ticks/s, %.0fx real time\n", seconds, tick_count / seconds, tick_count / seconds / TICKS_PER_SECOND);
+
+	free_replay(&replay);
+
+	return 0;
+}
+
+static int seek(const char* path, uint32_t seek_count)
+{
+	// Seeks to random ticks, checks a few against playing from tick 0 and times both:
+	Game_State game_state;
+	Game_State played_state;
+	Game_Snapshot seeked;
+	Game_Snapshot played;
+	Replay_Reader reader;
+	Replay_Reader played_reader;
+	Random_State random;
+	Replay replay;
+	Replay events_only;
+
+	if (!load_replay(&replay, path))
+	{
+		printf("Could not read %s\n", path);
+		return 1;
+	}
+
+	events_only = replay;
+	events_only.keyframe_count = 0;
+	seed_random(&random, replay.header.seed);
+	start_replay_game(&game_state, &replay.header);
+	start_replay_reader(&reader, replay.events, replay.event_size, replay.header.tick_count);
+
+	uint64_t played_count = 0;
+	uint64_t mismatch_count = 0;
+	uint32_t checked_count = min(seek_count, 8);
+	double seek_seconds = 0.0;
+	double full_seconds = 0.0;
+
+	for (uint32_t i = 0; i < seek_count; ++i)
+	{
+		uint64_t tick = next_random(&random) % (replay.header.tick_count + 1);
+		double start = get_time_in_seconds();
+
+		played_count += seek_replay(&game_state, &reader, &replay, tick);
+		seek_seconds += get_time_in_seconds() - start;
+
+		if (i >= checked_count)
+		{
+			continue;
+		}
+
+		start = get_time_in_seconds();
+		start_replay_game(&played_state, &events_only.header);
+		start_replay_reader(&played_reader, events_only.events, events_only.event_size, events_only.header.tick_count);
+		seek_replay(&played_state, &played_reader, &events_only, tick);
+		full_seconds += get_time_in_seconds() - start;
+
+		memset(&seeked, 0, sizeof(seeked));
+		memset(&played, 0, sizeof(played));
+		save_game_snapshot(&game_state, &seeked);
+		save_game_snapshot(&played_state, &played);
+
+		if (memcmp(&seeked, &played, sizeof(Game_Snapshot)) != 0)
+		{
+			printf("SEEK MISMATCH at tick %llu\n", (unsigned long long)tick);
+			++mismatch_count;
+		}
+	}
+
+	printf("ticks: %llu keyframes: %zu every %u ticks\n", (unsigned long long)replay.header.tick_count, replay.keyframe_count, replay.header.keyframe_interval);
+	printf("seeks: %u, %.1f ticks and %.3fms per seek, %.3fms from tick 0, mismatches: %llu of %u checked\n", seek_count, played_count / (double)max(seek_count, 1), 1000.0 * seek_seconds / max(seek_count, 1), 1000.0 * full_seconds / max(checked_count, 1), (unsigned long long)mismatch_count, checked_count);
+
+	free_replay(&replay);
+
+	return (mismatch_count == 0) ? 0 : 1;
+}
+
+static int verify(char** paths, int path_count)
+{
+	// Plays the replays again on all CPUs and reports the first tick each stops matching its hashes:
+	Replay* replays = calloc(path_count, sizeof(Replay));
+	Replay_Check* checks = calloc(path_count, sizeof(Replay_Check));
+	int loaded_count = 0;
+	int result = 1;
+
+	if (replays == NULL || checks == NULL)
+	{
+		free(replays);
+		free(checks);
+		return 1;
+	}
+
+	for (; loaded_count < path_count; ++loaded_count)
+	{
+		if (!load_replay(&replays[loaded_count], paths[loaded_count]))
+		{
+			printf("Could not read %s\n", paths[loaded_count]);
+			break;
+		}
+	}
+
+	if (loaded_count == path_count)
+	{
+		uint32_t thread_count = get_cpu_count();
+		double start = get_time_in_seconds();
+
+		if (verify_replays(replays, path_count, thread_count, checks))
+		{
+			double seconds = get_time_in_seconds() - start;
+			uint64_t tick_count = 0;
+			int diverged_count = 0;
+
+			for (int i = 0; i < path_count; ++i)
+			{
+				tick_count += checks[i].tick_count;
+				diverged_count += checks[i].diverged;
+
+				if (checks[i].diverged)
+				{
+					printf("%s: DIVERGED after tick %llu, by tick %llu\n", paths[i], (unsigned long long)checks[i].last_matching_tick, (unsigned long long)checks[i].first_diverged_tick);
+				}
+				else
+				{
+					printf("%s: matches, %llu checkpoints over %llu ticks\n", paths[i], (unsigned long long)checks[i].checkpoint_count, (unsigned long long)replays[i].header.tick_count);
+				}
+			}
+
+			printf("replays: %d diverged: %d threads: %u\n", path_count, diverged_count, thread_count);
+			printf("time: %.3fs -- %.0f ticks/s\n", seconds, tick_count / seconds);
+			result = (diverged_count == 0) ? 0 : 1;
+		}
+	}
+
+	for (int i = 0; i < loaded_count; ++i)
+	{
+		free_replay(&replays[i]);
+	}
+
+	free(replays);
+	free(checks);
+
+	return result;
+}
+
+static int pack(const char* path, uint64_t game_count, uint64_t seed)
+{
+	// Records games of random input until their first game over into one archive:
+	Archive_Writer writer;
+	Game_State game_state;
+	Random_State random;
+	Replay replay;
+	uint64_t tick_count = 0;
+	uint64_t event_size = 0;
+
+	if (!open_archive_writer(&writer, path))
+	{
+		printf("Could not write %s\n", path);
+		return 1;
+	}
+
+	double start = get_time_in_seconds();
+	bool success = true;
+
+	for (uint64_t id = 0; id < game_count && success; ++id)
+	{
+		initialize_game_state(&game_state, seed + id, PIECE_RANDOMIZER_BAG);
+		seed_random(&random, (seed + id) ^ 0x9e3779b97f4a7c15ull);
+		// Archives keep events only, keyframes would be left out:
+		success = initialize_replay(&replay, &game_state, seed + id, 0);
+
+		while (success && game_state.game_phase == GAME_PHASE_PLAYING)
+		{
+			uint8_t event = get_random_event(&random);
+
+			success = record_replay_tick(&replay, &game_state, event);
+			play_replay_event(&game_state, event);
+		}
+
+		success = success && add_archive_game(&writer, &replay, id, game_state.score);
+		tick_count += replay.header.tick_count;
+		event_size += replay.event_size;
+		free_replay(&replay);
+	}
+
+	success = close_archive_writer(&writer) && success;
+
+	if (!success)
+	{
+		printf("Could not write %s\n", path);
+		return 1;
+	}
+
+	Archive archive;
+
+	if (!open_archive(&archive, path))
+	{
+		printf("Could not read %s\n", path);
+		return 1;
+	}
+
+	uint64_t file_size = archive.file.size;
+	uint64_t block_size = archive.header->block_table_offset - sizeof(Archive_Header);
+
+	close_archive(&archive);
+
+	printf("games: %llu ticks: %llu events: %llu bytes\n", (unsigned long long)game_count, (unsigned long long)tick_count, (unsigned long long)event_size);
+	printf("archive: %llu bytes, blocks %.1f%% of the events, %.1f bytes/game with the index\n", (unsigned long long)file_size, 100.0 * block_size / (double)max(event_size, 1), file_size / (double)max(game_count, 1));
+	printf("time: %.3fs\n", get_time_in_seconds() - start);
+
+	return 0;
+}
+
+static int scan(const char* path, bool play_one, uint64_t id)
+{
+	// Streams every game of the archive, or the game of id, through the simulator and checks the scores:
+	Archive archive;
+	Archive_Reader reader;
+	Game_State game_state;
+	uint64_t game_count = 0;
+	uint64_t tick_count = 0;
+	uint64_t mismatch_count = 0;
+
+	double start = get_time_in_seconds();
+
+	if (!open_archive(&archive, path))
+	{
+		printf("Could not read %s\n", path);
+		return 1;
+	}
+
+	double open_seconds = get_time_in_seconds() - start;
+
+	if (!initialize_archive_reader(&reader, &archive))
+	{
+		close_archive(&archive);
+		return 1;
+	}
+
+	const Archive_Entry* first = archive.entries;
+	const Archive_Entry* last = archive.entries + archive.header->game_count;
+
+	if (play_one)
+	{
+		first = find_archive_game(&archive, id);
+		last = (first != NULL) ? first + 1 : NULL;
+
+		if (first == NULL)
+		{
+			printf("No game %llu in %s\n", (unsigned long long)id, path);
+		}
+	}
+
+	start = get_time_in_seconds();
+
+	for (const Archive_Entry* entry = first; entry != last; ++entry)
+	{
+		bool played = play_archive_game(&reader, &game_state, entry);
+
+		if (!played || game_state.score != entry->score)
+		{
+			printf("GAME %llu MISMATCH: score %u, index %u%s\n", (unsigned long long)entry->id, game_state.score, entry->score, played ? "" : ", damaged block");
+			++mismatch_count;
+		}
+
+		++game_count;
+		tick_count += reader.tick;
+	}
+
+	double seconds = get_time_in_seconds() - start;
+
+	printf("games: %llu ticks: %llu mismatches: %llu, opened in %.6fs\n", (unsigned long long)game_count, (unsigned long long)tick_count, (unsigned long long)mismatch_count, open_seconds);
+	printf("time: %.3fs -- %.0f games/s, %.0f ticks/s\n", seconds, game_count / seconds, tick_count / seconds);
+
+	free_archive_reader(&reader);
+	close_archive(&archive);
+
+	return (mismatch_count == 0 && first != NULL) ? 0 : 1;
+}
+
+int main(int argc, char* args[])
+{
+	if (argc > 2 && strcmp(args[1], "record") == 0)
+	{
+		uint64_t seed = (argc > 3) ? strtoull(args[3], NULL, 10) : (uint64_t)time(NULL);
+		uint64_t tick_count = (argc > 4) ? strtoull(args[4], NULL, 10) : REPLAY_DEFAULT_TICK_COUNT;
+		uint32_t keyframe_interval = (argc > 5) ? (uint32_t)strtoul(args[5], NULL, 10) : REPLAY_DEFAULT_KEYFRAME_INTERVAL;
+
+		return record(args[2], seed, tick_count, keyframe_interval);
+	}
+
+	if (argc > 2 && strcmp(args[1], "seek") == 0)
+	{
+		uint32_t seek_count = (argc > 3) ? (uint32_t)strtoul(args[3], NULL, 10) : REPLAY_DEFAULT_SEEK_COUNT;
+
+		return seek(args[2], seek_count);
+	}
+
+	if (argc > 2 && strcmp(args[1], "play") == 0)
+	{
+		uint32_t play_count = (argc > 3) ? (uint32_t)strtoul(args[3], NULL, 10) : REPLAY_DEFAULT_PLAY_COUNT;
+
+		return play(args[2], play_count);
+	}
+
+	if (argc > 2 && strcmp(args[1], "verify") == 0)
+	{
+		return verify(args + 2, argc - 2);
+	}
+
+	if (argc > 2 && strcmp(args[1], "pack") == 0)
+	{
+		uint64_t game_count = (argc > 3) ? strtoull(args[3], NULL, 10) : REPLAY_DEFAULT_GAME_COUNT;
+		uint64_t seed = (argc > 4) ? strtoull(args[4], NULL, 10) : (uint64_t)time(NULL);
+
+		return pack(args[2], game_count, seed);
+	}
+
+	if (argc > 2 && strcmp(args[1], "scan") == 0)
+	{
+		return scan(args[2], argc > 3, (argc > 3) ? strtoull(args[3], NULL, 10) : 0);
+	}
+
+	printf("usage: replay record <file> [seed] [ticks] [keyframe_interval]\n");
+	printf("       replay play <file> [times]\n");
+	printf("       replay seek <file> [seeks]\n");
+	printf("       replay verify <file> [more files]\n");
+	printf("       replay pack <archive> [games] [seed]\n");
+	printf("       replay scan <archive> [id]\n");
+
+	return 1;
+}
@@ -0,0 +1,594 @@
+/* ISMET BARAN SURUCU -- github.com/baransrc */
+#include "tetris_archive.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define ARCHIVE_MAGIC "TARC"
+#define ARCHIVE_VERSION 1
+
+// rANS with 32 bit state and byte output, frequencies scaled to 1 << RANS_SCALE_BITS:
+#define RANS_SCALE_BITS 12
+#define RANS_SCALE (1u << RANS_SCALE_BITS)
+#define RANS_LOWER_BOUND (1u << 23)
+#define RANS_SYMBOL_COUNT 256
+// A compressed block starts with the frequency of every byte value, 16 bits each:
+#define RANS_TABLE_SIZE (RANS_SYMBOL_COUNT * 2)
+// Every byte in costs at most two bytes out, plus the table and the final state:
+#define RANS_ENCODED_CAPACITY (RANS_TABLE_SIZE + ARCHIVE_BLOCK_SIZE * 2 + 16)
+
+// Internal ---------------------
+static void normalize_frequencies(const uint32_t*, uint32_t, uint16_t*);
+static uint32_t encode_block(const uint8_t*, uint32_t, uint8_t*);
+static bool decode_block(const uint8_t*, uint32_t, uint8_t*, uint32_t);
+static bool flush_archive_block(Archive_Writer*);
+static int compare_archive_entries(const void*, const void*);
+static bool load_next_archive_block(Archive_Reader*);
+static void read_next_archive_event(Archive_Reader*);
+// ------------------------------
+
+static void normalize_frequencies(const uint32_t* counts, uint32_t total, uint16_t* frequencies)
+{
+	// Scales counts to sum to RANS_SCALE, every byte value that occurs keeps at least 1:
+	int32_t sum = 0;
+	uint32_t largest = 0;
+
+	for (uint32_t symbol = 0; symbol < RANS_SYMBOL_COUNT; ++symbol)
+	{
+		frequencies[symbol] = 0;
+
+		if (counts[symbol] > 0)
+		{
+			frequencies[symbol] = (uint16_t)max(((uint64_t)counts[symbol] * RANS_SCALE) / total, 1);
+			sum += frequencies[symbol];
+
+			if (frequencies[symbol] > frequencies[largest])
+			{
+				largest = symbol;
+			}
+		}
+	}
+
+	// Rounding is paid by the largest symbols, where it costs the least:
+	while (sum != (int32_t)RANS_SCALE)
+	{
+		if (sum < (int32_t)RANS_SCALE)
+		{
+			frequencies[largest] += (uint16_t)(RANS_SCALE - sum);
+			sum = RANS_SCALE;
+			break;
+		}
+
+		for (uint32_t symbol = 0; symbol < RANS_SYMBOL_COUNT; ++symbol)
+		{
+			if (frequencies[symbol] > frequencies[largest])
+			{
+				largest = symbol;
+			}
+		}
+
+		int32_t taken = min(sum - (int32_t)RANS_SCALE, (int32_t)frequencies[largest] - 1);
+
+		frequencies[largest] -= (uint16_t)taken;
+		sum -= taken;
+	}
+}
+
+static uint32_t encode_block(const uint8_t* raw, uint32_t raw_size, uint8_t* encoded)
+{
+	// Returns the encoded size, 0 when it would not be smaller than the block itself:
+	uint32_t counts[RANS_SYMBOL_COUNT] = {0};
+	uint16_t frequencies[RANS_SYMBOL_COUNT];
+	uint32_t starts[RANS_SYMBOL_COUNT];
+
+	for (uint32_t i = 0; i < raw_size; ++i)
+	{
+		++counts[raw[i]];
+	}
+
+	normalize_frequencies(counts, raw_size, frequencies);
+
+	for (uint32_t symbol = 0, start = 0; symbol < RANS_SYMBOL_COUNT; ++symbol)
+	{
+		starts[symbol] = start;
+		start += frequencies[symbol];
+
+		encoded[symbol * 2] = (uint8_t)frequencies[symbol];
+		encoded[symbol * 2 + 1] = (uint8_t)(frequencies[symbol] >> 8);
+	}
+
+	// rANS encodes backwards, so the decoder reads forwards:
+	uint8_t* end = encoded + RANS_ENCODED_CAPACITY;
+	uint8_t* next = end;
+	uint32_t state = RANS_LOWER_BOUND;
+
+	for (uint32_t i = raw_size; i-- > 0;)
+	{
+		uint32_t frequency = frequencies[raw[i]];
+		uint32_t state_limit = ((RANS_LOWER_BOUND >> RANS_SCALE_BITS) << 8) * frequency;
+
+		while (state >= state_limit)
+		{
+			*--next = (uint8_t)state;
+			state >>= 8;
+		}
+
+		state = ((state / frequency) << RANS_SCALE_BITS) + (state % frequency) + starts[raw[i]];
+	}
+
+	next -= 4;
+	next[0] = (uint8_t)state;
+	next[1] = (uint8_t)(state >> 8);
+	next[2] = (uint8_t)(state >> 16);
+	next[3] = (uint8_t)(state >> 24);
+
+	uint32_t encoded_size = RANS_TABLE_SIZE + (uint32_t)(end - next);
+
+	if (encoded_size >= raw_size)
+	{
+		return 0;
+	}
+
+	memmove(encoded + RANS_TABLE_SIZE, next, end - next);
+
+	return encoded_size;
+}
+
+static bool decode_block(const uint8_t* encoded, uint32_t encoded_size, uint8_t* raw, uint32_t raw_size)
+{
+	uint16_t frequencies[RANS_SYMBOL_COUNT];
+	uint16_t starts[RANS_SYMBOL_COUNT];
+	uint8_t symbols[RANS_SCALE];
+	uint32_t start = 0;
+
+	if (encoded_size < RANS_TABLE_SIZE + 4)
+	{
+		return false;
+	}
+
+	for (uint32_t symbol = 0; symbol < RANS_SYMBOL_COUNT; ++symbol)
+	{
+		frequencies[symbol] = (uint16_t)(encoded[symbol * 2] | (encoded[symbol * 2 + 1] << 8));
+		starts[symbol] = (uint16_t)start;
+
+		if (start + frequencies[symbol] > RANS_SCALE)
+		{
+			return false;
+		}
+
+		memset(symbols + start, (int)symbol, frequencies[symbol]);
+		start += frequencies[symbol];
+	}
+
+	if (start != RANS_SCALE)
+	{
+		return false;
+	}
+
+	const uint8_t* next = encoded + RANS_TABLE_SIZE;
+	const uint8_t* end = encoded + encoded_size;
+	uint32_t state = (uint32_t)next[0] | ((uint32_t)next[1] << 8) | ((uint32_t)next[2] << 16) | ((uint32_t)next[3] << 24);
+
+	next += 4;
+
+	for (uint32_t i = 0; i < raw_size; ++i)
+	{
+		uint32_t slot = state & (RANS_SCALE - 1);
+		uint8_t symbol = symbols[slot];
+
+		raw[i] = symbol;
+		state = frequencies[symbol] * (state >> RANS_SCALE_BITS) + slot - starts[symbol];
+
+		while (state < RANS_LOWER_BOUND)
+		{
+			if (next >= end)
+			{
+				return false;
+			}
+
+			state = (state << 8) | *next++;
+		}
+	}
+
+	return true;
+}
+
+static bool flush_archive_block(Archive_Writer* writer)
+{
+	if (writer->block_size == 0)
+	{
+		return true;
+	}
+
+	if (writer->block_count == writer->block_capacity)
+	{
+		size_t capacity = max(writer->block_capacity * 2, 64);
+		Archive_Block* blocks = realloc(writer->blocks, capacity * sizeof(Archive_Block));
+
+		if (blocks == NULL)
+		{
+			return false;
+		}
+
+		writer->blocks = blocks;
+		writer->block_capacity = capacity;
+	}
+
+	uint32_t encoded_size = encode_block(writer->block, writer->block_size, writer->encoded);
+	const uint8_t* stored = (encoded_size > 0) ? writer->encoded : writer->block;
+	uint32_t stored_size = (encoded_size > 0) ? encoded_size : writer->block_size;
+
+	if (fwrite(stored, 1, stored_size, writer->file) != stored_size)
+	{
+		return false;
+	}
+
+	Archive_Block* block = &writer->blocks[writer->block_count++];
+
+	block->offset = writer->file_offset;
+	block->stored_size = stored_size;
+	block->raw_size = writer->block_size;
+
+	writer->file_offset += stored_size;
+	writer->block_size = 0;
+
+	return true;
+}
+
+static int compare_archive_entries(const void* a, const void* b)
+{
+	uint64_t id_a = ((const Archive_Entry*)a)->id;
+	uint64_t id_b = ((const Archive_Entry*)b)->id;
+
+	return (id_a > id_b) - (id_a < id_b);
+}
+
+bool open_archive_writer(Archive_Writer* writer, const char* path)
+{
+	Archive_Header header = {0};
+
+	memset(writer, 0, sizeof(*writer));
+
+	writer->block = malloc(ARCHIVE_BLOCK_SIZE);
+	writer->encoded = malloc(RANS_ENCODED_CAPACITY);
+	writer->file = fopen(path, "wb");
+
+	// The header is written again with the counts once the archive is closed:
+	if (writer->block == NULL || writer->encoded == NULL || writer->file == NULL ||
+		fwrite(&header, sizeof(header), 1, writer->file) != 1)
+	{
+		if (writer->file != NULL)
+		{
+			fclose(writer->file);
+		}
+
+		free(writer->block);
+		free(writer->encoded);
+		memset(writer, 0, sizeof(*writer));
+
+		return false;
+	}
+
+	writer->file_offset = sizeof(header);
+
+	return true;
+}
+
+bool add_archive_game(Archive_Writer* writer, const Replay* replay, uint64_t id, uint32_t score)
+{
+	// Ids are meant to be unique, find_archive_game returns any game of an id:
+	if (writer->entry_count == writer->entry_capacity)
+	{
+		size_t capacity = max(writer->entry_capacity * 2, 1024);
+		Archive_Entry* entries = realloc(writer->entries, capacity * sizeof(Archive_Entry));
+
+		if (entries == NULL)
+		{
+			return false;
+		}
+
+		writer->entries = entries;
+		writer->entry_capacity = capacity;
+	}
+
+	Archive_Entry* entry = &writer->entries[writer->entry_count++];
+
+	memset(entry, 0, sizeof(*entry));
+	entry->id = id;
+	entry->seed = replay->header.seed;
+	entry->tick_count = replay->header.tick_count;
+	entry->event_offset = writer->stream_size;
+	entry->event_size = replay->event_size;
+	entry->score = score;
+	entry->fixed_gravity = replay->header.fixed_gravity;
+	entry->randomizer = replay->header.randomizer;
+	entry->rotation_system = replay->header.rotation_system;
+
+	const uint8_t* events = replay->events;
+	size_t event_size = replay->event_size;
+
+	while (event_size > 0)
+	{
+		uint32_t copied = (uint32_t)min(event_size, (size_t)(ARCHIVE_BLOCK_SIZE - writer->block_size));
+
+		memcpy(writer->block + writer->block_size, events, copied);
+		writer->block_size += copied;
+		events += copied;
+		event_size -= copied;
+
+		if (writer->block_size == ARCHIVE_BLOCK_SIZE && !flush_archive_block(writer))
+		{
+			return false;
+		}
+	}
+
+	writer->stream_size += replay->event_size;
+
+	return true;
+}
+
+bool close_archive_writer(Archive_Writer* writer)
+{
+	static const uint8_t padding[8] = {0};
+	Archive_Header header = {0};
+	bool success = flush_archive_block(writer);
+
+	// Tables start 8 byte aligned, so they can be read in place from the mapping:
+	size_t padding_size = (size_t)((8 - (writer->file_offset & 7)) & 7);
+
+	success = success && fwrite(padding, 1, padding_size, writer->file) == padding_size;
+	writer->file_offset += padding_size;
+
+	if (writer->entry_count > 0)
+	{
+		qsort(writer->entries, writer->entry_count, sizeof(Archive_Entry), compare_archive_entries);
+	}
+
+	memcpy(header.magic, ARCHIVE_MAGIC, 4);
+	header.version = ARCHIVE_VERSION;
+	header.game_count = writer->entry_count;
+	header.block_count = writer->block_count;
+	header.stream_size = writer->stream_size;
+	header.block_table_offset = writer->file_offset;
+	header.index_offset = header.block_table_offset + writer->block_count * sizeof(Archive_Block);
+
+	success = success && fwrite(writer->blocks, sizeof(Archive_Block), writer->block_count, writer->file) == writer->block_count;
+	success = success && fwrite(writer->entries, sizeof(Archive_Entry), writer->entry_count, writer->file) == writer->entry_count;
+	success = success && fseek(writer->file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, writer->file) == 1;
+	success = (fclose(writer->file) == 0) && success;
+
+	free(writer->block);
+	free(writer->encoded);
+	free(writer->blocks);
+	free(writer->entries);
+	memset(writer, 0, sizeof(*writer));
+
+	return success;
+}
+
+bool open_archive(Archive* archive, const char* path)
+{
+	memset(archive, 0, sizeof(*archive));
+
+	if (!map_file(&archive->file, path))
+	{
+		return false;
+	}
+
+	const Archive_Header* header = (const Archive_Header*)archive->file.data;
+	uint64_t file_size = archive->file.size;
+
+	// Tables have to lie inside the file and be aligned, they are read in place:
+	bool valid = file_size >= sizeof(Archive_Header) && memcmp(header->magic, ARCHIVE_MAGIC, 4) == 0 &&
+				 header->version == ARCHIVE_VERSION && (header->block_table_offset & 7) == 0 &&
+				 header->block_count <= file_size / sizeof(Archive_Block) && header->game_count <= file_size / sizeof(Archive_Entry) &&
+				 header->index_offset == header->block_table_offset + header->block_count * sizeof(Archive_Block) &&
+				 header->index_offset <= file_size && header->game_count * sizeof(Archive_Entry) <= file_size - header->index_offset;
+
+	if (!valid)
+	{
+		close_archive(archive);
+		return false;
+	}
+
+	archive->header = header;
+	archive->blocks = (const Archive_Block*)(archive->file.data + header->block_table_offset);
+	archive->entries = (const Archive_Entry*)(archive->file.data + header->index_offset);
+
+	return true;
+}
+
+void close_archive(Archive* archive)
+{
+	unmap_file(&archive->file);
+
+	memset(archive, 0, sizeof(*archive));
+}
+
+const Archive_Entry* find_archive_game(const Archive* archive, uint64_t id)
+{
+	// The index is sorted by id:
+	uint64_t low = 0;
+	uint64_t high = archive->header->game_count;
+
+	while (low < high)
+	{
+		uint64_t middle = low + (high - low) / 2;
+
+		if (archive->entries[middle].id < id)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	return (low < archive->header->game_count && archive->entries[low].id == id) ? &archive->entries[low] : NULL;
+}
+
+bool initialize_archive_reader(Archive_Reader* reader, const Archive* archive)
+{
+	memset(reader, 0, sizeof(*reader));
+
+	reader->archive = archive;
+	reader->buffer = malloc(REPLAY_MAX_VARINT_SIZE + ARCHIVE_BLOCK_SIZE);
+	reader->decoded_block = UINT64_MAX;
+
+	return reader->buffer != NULL;
+}
+
+void free_archive_reader(Archive_Reader* reader)
+{
+	free(reader->buffer);
+
+	memset(reader, 0, sizeof(*reader));
+}
+
+static bool load_next_archive_block(Archive_Reader* reader)
+{
+	// Bytes of a varint the last block cut off go right in front of the next block:
+	uint8_t tail[REPLAY_MAX_VARINT_SIZE];
+	size_t tail_size = reader->end - reader->next;
+	uint64_t block_index = reader->stream_offset / ARCHIVE_BLOCK_SIZE;
+	uint32_t block_offset = (uint32_t)(reader->stream_offset % ARCHIVE_BLOCK_SIZE);
+	uint8_t* block = reader->buffer + REPLAY_MAX_VARINT_SIZE;
+
+	if (tail_size >= REPLAY_MAX_VARINT_SIZE || block_index >= reader->archive->header->block_count)
+	{
+		return false;
+	}
+
+	memcpy(tail, reader->next, tail_size);
+
+	if (block_index != reader->decoded_block)
+	{
+		const Archive_Block* stored = &reader->archive->blocks[block_index];
+		const uint8_t* data = reader->archive->file.data + stored->offset;
+		bool valid = stored->raw_size <= ARCHIVE_BLOCK_SIZE && stored->offset <= reader->archive->header->block_table_offset &&
+					 stored->stored_size <= reader->archive->header->block_table_offset - stored->offset;
+
+		reader->decoded_block = UINT64_MAX;
+
+		if (!valid)
+		{
+			return false;
+		}
+
+		if (stored->stored_size == stored->raw_size)
+		{
+			memcpy(block, data, stored->raw_size);
+		}
+		else if (!decode_block(data, stored->stored_size, block, stored->raw_size))
+		{
+			return false;
+		}
+
+		reader->decoded_block = block_index;
+	}
+
+	uint32_t raw_size = reader->archive->blocks[block_index].raw_size;
+
+	if (block_offset >= raw_size)
+	{
+		return false;
+	}
+
+	uint64_t available = min((uint64_t)(raw_size - block_offset), reader->stream_end - reader->stream_offset);
+
+	// Only a game that goes on from the block before has a tail, and it starts at the front:
+	reader->next = block + block_offset - tail_size;
+	reader->end = block + block_offset + available;
+	reader->stream_offset += available;
+
+	memcpy((uint8_t*)reader->next, tail, tail_size);
+
+	return true;
+}
+
+static void read_next_archive_event(Archive_Reader* reader)
+{
+	for (;;)
+	{
+		uint64_t value;
+		size_t size = read_varint(reader->next, reader->end, &value);
+
+		if (size > 0)
+		{
+			reader->next += size;
+			reader->event_tick += value >> REPLAY_EVENT_BITS;
+			reader->event = (uint8_t)(value & ((1u << REPLAY_EVENT_BITS) - 1));
+			return;
+		}
+
+		if (reader->stream_offset >= reader->stream_end)
+		{
+			// Bytes left over mean the last varint was cut off:
+			reader->failed = reader->failed || (reader->next != reader->end);
+			reader->event_tick = UINT64_MAX;
+			return;
+		}
+
+		if (!load_next_archive_block(reader))
+		{
+			reader->failed = true;
+			reader->event_tick = UINT64_MAX;
+			return;
+		}
+	}
+}
+
+void start_archive_game(Archive_Reader* reader, Game_State* game_state, const Archive_Entry* entry)
+{
+	Replay_Header header;
+
+	header.seed = entry->seed;
+	header.tick_count = entry->tick_count;
+	header.fixed_gravity = entry->fixed_gravity;
+	header.randomizer = entry->randomizer;
+	header.rotation_system = entry->rotation_system;
+
+	start_replay_game(game_state, &header);
+
+	reader->stream_offset = entry->event_offset;
+	reader->stream_end = entry->event_offset + entry->event_size;
+	reader->next = reader->buffer + REPLAY_MAX_VARINT_SIZE;
+	reader->end = reader->next;
+	reader->tick = 0;
+	reader->tick_count = entry->tick_count;
+	reader->event_tick = 0;
+	reader->event = 0;
+	reader->failed = false;
+
+	// Deltas count from tick 0 for the first event:
+	read_next_archive_event(reader);
+}
+
+uint8_t read_archive_tick(Archive_Reader* reader)
+{
+	// Event of the next tick, 0 on ticks without one:
+	uint64_t tick = reader->tick++;
+
+	if (tick != reader->event_tick)
+	{
+		return 0;
+	}
+
+	uint8_t event = reader->event;
+
+	read_next_archive_event(reader);
+
+	return event;
+}
+
+bool play_archive_game(Archive_Reader* reader, Game_State* game_state, const Archive_Entry* entry)
+{
+	start_archive_game(reader, game_state, entry);
+
+	while (reader->tick < reader->tick_count && !reader->failed)
+	{
+		play_replay_event(game_state, read_archive_tick(reader));
+	}
+
+	return !reader->failed;
+}
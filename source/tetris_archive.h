@@ -0,0 +1,117 @@
+#ifndef TETRIS_ARCHIVE_H
+#define TETRIS_ARCHIVE_H
+
+// Many recorded games in one file. The events of all games are joined into one stream, which
+// is cut into blocks of ARCHIVE_BLOCK_SIZE bytes, each compressed on its own with an order-0
+// rANS coder. The block table and the index, one Archive_Entry per game sorted by id, follow
+// the blocks. Readers map the file and use the index where it lies; a game is decoded one
+// block at a time while it plays, so no game is ever held whole in memory.
+// The structs below are the file layout, little endian like every platform the game builds for.
+
+#include "tetris_core.h"
+#include "tetris_replay.h"
+#include "tetris_platform.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#define ARCHIVE_BLOCK_SIZE (64 * 1024)
+
+typedef struct Archive_Header
+{
+	char magic[4];
+	uint32_t version;
+	uint64_t game_count;
+	uint64_t block_count;
+	// Bytes of events of all games, before compression:
+	uint64_t stream_size;
+	uint64_t block_table_offset;
+	uint64_t index_offset;
+} Archive_Header;
+
+typedef struct Archive_Block
+{
+	uint64_t offset;
+	// Same as raw_size when the block did not compress and is stored as it is:
+	uint32_t stored_size;
+	uint32_t raw_size;
+} Archive_Block;
+
+typedef struct Archive_Entry
+{
+	uint64_t id;
+	uint64_t seed;
+	uint64_t tick_count;
+	// Where the events of the game start in the stream:
+	uint64_t event_offset;
+	uint64_t event_size;
+	uint32_t score;
+	uint32_t fixed_gravity;
+	uint8_t randomizer;
+	uint8_t rotation_system;
+	uint8_t reserved[6];
+} Archive_Entry;
+
+typedef struct Archive_Writer
+{
+	FILE* file;
+	uint64_t file_offset;
+	uint64_t stream_size;
+	// Events not compressed yet, and room for the encoder:
+	uint8_t* block;
+	uint8_t* encoded;
+	uint32_t block_size;
+	Archive_Block* blocks;
+	size_t block_count;
+	size_t block_capacity;
+	Archive_Entry* entries;
+	size_t entry_count;
+	size_t entry_capacity;
+} Archive_Writer;
+
+typedef struct Archive
+{
+	Mapped_File file;
+	const Archive_Header* header;
+	const Archive_Block* blocks;
+	const Archive_Entry* entries;
+} Archive;
+
+// Plays games of an archive, like Replay_Reader over blocks decoded as they are reached.
+// One reader can play any number of games, a block games share is decoded once:
+typedef struct Archive_Reader
+{
+	const Archive* archive;
+	// Room for the end of a varint cut by a block boundary, then the decoded block:
+	uint8_t* buffer;
+	uint64_t decoded_block;
+	// Stream offset of the first byte not in the buffer, and the end of the game:
+	uint64_t stream_offset;
+	uint64_t stream_end;
+	const uint8_t* next;
+	const uint8_t* end;
+	uint64_t tick;
+	uint64_t tick_count;
+	// Next event and its tick, UINT64_MAX once there are none left:
+	uint64_t event_tick;
+	uint8_t event;
+	// A block was damaged, the game stops where it was:
+	bool failed;
+} Archive_Reader;
+
+bool open_archive_writer(Archive_Writer*, const char*);
+bool add_archive_game(Archive_Writer*, const Replay*, uint64_t, uint32_t);
+bool close_archive_writer(Archive_Writer*);
+
+bool open_archive(Archive*, const char*);
+void close_archive(Archive*);
+const Archive_Entry* find_archive_game(const Archive*, uint64_t);
+
+bool initialize_archive_reader(Archive_Reader*, const Archive*);
+void free_archive_reader(Archive_Reader*);
+void start_archive_game(Archive_Reader*, Game_State*, const Archive_Entry*);
+uint8_t read_archive_tick(Archive_Reader*);
+bool play_archive_game(Archive_Reader*, Game_State*, const Archive_Entry*);
+
+#endif
@@ -0,0 +1,531 @@
+/* ISMET BARAN SURUCU -- github.com/baransrc */
+#include "tetris_batch.h"
+#include "tetris_platform.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define BATCH_HAS_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef __AVX2__
+#define BATCH_HAS_AVX2
+#include <immintrin.h>
+#endif
+
+// Number of per lane arrays allocated next to the rows:
+#define BATCH_ARRAY_COUNT 16
+
+enum Batch_Step_Mode
+{
+	BATCH_STEP_MODE_NONE,
+	BATCH_STEP_MODE_FALL,
+};
+
+// Row masks of every type and rotation as 32-bit words, so the kernels can gather them:
+static int32_t BATCH_SHAPE_ROWS[TETROMINO_TYPE_COUNT * TETROMINO_ROTATION_COUNT][MAX_TETROMINO_HEIGHT];
+static uint32_t BATCH_GRAVITY[LEVEL_COUNT];
+
+// Internal ---------------------
+static void initialize_batch_tables(void);
+static inline bool does_batch_lane_collide(const uint16_t*, int32_t, int32_t, int32_t);
+static inline uint32_t find_full_batch_rows(const uint16_t*, bool);
+static uint8_t clear_full_batch_rows(uint16_t*, uint32_t);
+static void lock_batch_lane(Batch_Engine*, uint32_t);
+// ------------------------------
+
+static void initialize_batch_tables(void)
+{
+	initialize_tetromino_shapes();
+
+	for (size_t type = 0; type < TETROMINO_TYPE_COUNT; ++type)
+	{
+		for (size_t rotation = 0; rotation < TETROMINO_ROTATION_COUNT; ++rotation)
+		{
+			for (size_t j = 0; j < MAX_TETROMINO_HEIGHT; ++j)
+			{
+				BATCH_SHAPE_ROWS[type * TETROMINO_ROTATION_COUNT + rotation][j] = TETROMINO_SHAPES[type][rotation].row_masks[j];
+			}
+		}
+	}
+
+	for (uint8_t level = 0; level < LEVEL_COUNT; ++level)
+	{
+		BATCH_GRAVITY[level] = get_gravity(level);
+	}
+}
+
+bool create_batch_engine(Batch_Engine* batch, uint32_t lane_count)
+{
+	initialize_batch_tables();
+
+	memset(batch, 0, sizeof(*batch));
+
+	// Round lane count up so the kernels can always work on full vectors:
+	size_t padded_lane_count = ((size_t)lane_count + 7) & ~(size_t)7;
+	size_t array_size = (padded_lane_count * sizeof(int32_t) + BATCH_LANE_ALIGNMENT - 1) & ~(size_t)(BATCH_LANE_ALIGNMENT - 1);
+	size_t rows_size = padded_lane_count * sizeof(uint16_t) * BATCH_ROW_STRIDE;
+	size_t piece_queue_size = padded_lane_count * sizeof(Piece_Queue);
+	size_t columns_size = padded_lane_count * sizeof(uint32_t) * BOARD_WIDTH;
+	size_t total_size = rows_size + piece_queue_size + columns_size + array_size * BATCH_ARRAY_COUNT;
+
+	uint8_t* memory = allocate_aligned(BATCH_LANE_ALIGNMENT, total_size);
+
+	if (memory == NULL)
+	{
+		return false;
+	}
+
+	memset(memory, 0, total_size);
+
+	batch->memory = memory;
+	batch->lane_count = lane_count;
+	batch->use_simd = true;
+	batch->randomizer = PIECE_RANDOMIZER_UNIFORM;
+
+	batch->rows = (uint16_t (*)[BATCH_ROW_STRIDE])memory;
+	memory += rows_size;
+	// Only touched when a lane spawns, kept out of the arrays the kernels stream through:
+	batch->piece_queue = (Piece_Queue*)memory;
+	memory += piece_queue_size;
+	batch->columns = (uint32_t (*)[BOARD_WIDTH])memory;
+	memory += columns_size;
+
+	batch->position_x = (int32_t*)memory; memory += array_size;
+	batch->position_y = (int32_t*)memory; memory += array_size;
+	batch->fall_progress = (uint32_t*)memory; memory += array_size;
+	batch->line_count = (uint32_t*)memory; memory += array_size;
+	batch->score = (uint32_t*)memory; memory += array_size;
+	batch->candidate_x = (int32_t*)memory; memory += array_size;
+	batch->candidate_y = (int32_t*)memory; memory += array_size;
+	batch->candidate_shape = (int32_t*)memory; memory += array_size;
+	batch->rotation = memory; memory += array_size;
+	batch->type = memory; memory += array_size;
+	batch->current_level = memory; memory += array_size;
+	batch->game_phase = memory; memory += array_size;
+	batch->should_spawn_tetromino = memory; memory += array_size;
+	batch->collisions = memory; memory += array_size;
+	batch->step_mode = memory; memory += array_size;
+	batch->spawned = memory;
+
+	for (uint32_t lane = 0; lane < lane_count; ++lane)
+	{
+		reset_batch_lane(batch, lane, lane + 1);
+	}
+
+	return true;
+}
+
+void destroy_batch_engine(Batch_Engine* batch)
+{
+	free_aligned(batch->memory);
+
+	memset(batch, 0, sizeof(*batch));
+}
+
+void reset_batch_lane(Batch_Engine* batch, uint32_t lane, uint64_t seed)
+{
+	uint16_t* rows = batch->rows[lane];
+
+	for (int j = 0; j < BATCH_ROW_STRIDE; ++j)
+	{
+		bool is_board_row = (j >= BATCH_ROW_OFFSET && j < BATCH_ROW_OFFSET + BOARD_HEIGHT);
+		rows[j] = is_board_row ? BOARD_ROW_EMPTY : BOARD_ROW_FULL;
+	}
+
+	memset(batch->columns[lane], 0, sizeof(batch->columns[lane]));
+
+	batch->position_x[lane] = SPAWN_POSITION_X;
+	batch->position_y[lane] = SPAWN_POSITION_Y;
+	batch->rotation[lane] = 0;
+	batch->type[lane] = 0;
+	batch->fall_progress[lane] = 0;
+	batch->line_count[lane] = 0;
+	batch->score[lane] = 0;
+	seed_piece_queue(&batch->piece_queue[lane], seed, batch->randomizer);
+	batch->current_level[lane] = 0;
+	batch->game_phase[lane] = GAME_PHASE_PLAYING;
+	batch->should_spawn_tetromino[lane] = true;
+}
+
+void load_batch_lane(Batch_Engine* batch, uint32_t lane, const Game_State* game_state)
+{
+	reset_batch_lane(batch, lane, 0);
+
+	Tetromino tetromino = game_state->current_tetromino;
+
+	tetromino.pivot_position = game_state->previous_tetromino_position;
+	tetromino.rotation = game_state->previous_tetromino_rotation;
+
+	// Both keep only locked cells in their boards:
+	for (int j = 0; j < BOARD_HEIGHT; ++j)
+	{
+		batch->rows[lane][j + BATCH_ROW_OFFSET] = game_state->board.rows[j];
+	}
+
+	memcpy(batch->columns[lane], game_state->board.columns, sizeof(batch->columns[lane]));
+
+	batch->position_x[lane] = tetromino.pivot_position.x;
+	batch->position_y[lane] = tetromino.pivot_position.y;
+	batch->rotation[lane] = tetromino.rotation;
+	batch->type[lane] = (uint8_t)tetromino.type;
+	batch->fall_progress[lane] = game_state->fall_progress;
+	batch->line_count[lane] = game_state->line_count;
+	batch->score[lane] = game_state->score;
+	batch->current_level[lane] = game_state->current_level;
+	batch->game_phase[lane] = (uint8_t)game_state->game_phase;
+	batch->should_spawn_tetromino[lane] = game_state->should_spawn_tetromino;
+	// Same generator state, so the lane spawns the same pieces the game would:
+	batch->piece_queue[lane] = game_state->piece_queue;
+}
+
+uint32_t restart_finished_batch_lanes(Batch_Engine* batch, uint64_t seed)
+{
+	uint32_t finished_count = 0;
+
+	for (uint32_t lane = 0; lane < batch->lane_count; ++lane)
+	{
+		if (batch->game_phase[lane] != GAME_PHASE_GAMEOVER)
+		{
+			continue;
+		}
+
+		reset_batch_lane(batch, lane, seed + lane);
+		finished_count++;
+	}
+
+	return finished_count;
+}
+
+static inline bool does_batch_lane_collide(const uint16_t* rows, int32_t x, int32_t y, int32_t shape)
+{
+	const int32_t* shape_rows = BATCH_SHAPE_ROWS[shape];
+	// Tested positions are never more than one cell beyond a wall, so the shift stays positive:
+	int32_t shift = x - TETROMINO_PIVOT_X + BOARD_ROW_WALL_BITS;
+	const uint16_t* pivot_row = rows + y + BATCH_ROW_OFFSET + TETROMINO_PIVOT_Y;
+	uint32_t hit = 0;
+
+	for (int j = 0; j < MAX_TETROMINO_HEIGHT; ++j)
+	{
+		hit |= ((uint32_t)shape_rows[j] << shift) & pivot_row[-j];
+	}
+
+	return hit != 0;
+}
+
+void find_batch_collisions(const Batch_Engine* batch, bool use_simd)
+{
+	uint32_t lane = 0;
+
+#ifdef BATCH_HAS_AVX2
+	if (use_simd)
+	{
+		const int* shape_table = (const int*)BATCH_SHAPE_ROWS;
+		const int* row_bytes = (const int*)batch->rows;
+		const __m256i lane_index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+		const __m256i lane_bytes = _mm256_set1_epi32(BATCH_ROW_STRIDE * sizeof(uint16_t));
+		const __m256i shift_offset = _mm256_set1_epi32(BOARD_ROW_WALL_BITS - TETROMINO_PIVOT_X);
+		const __m256i row_offset = _mm256_set1_epi32(BATCH_ROW_OFFSET + TETROMINO_PIVOT_Y);
+		const __m256i row_mask = _mm256_set1_epi32(0xFFFF);
+		const __m256i shape_height = _mm256_set1_epi32(MAX_TETROMINO_HEIGHT);
+		const __m256i zero = _mm256_setzero_si256();
+
+		// Eight games per iteration, each lane gathers its own shape and board rows:
+		for (; lane + 8 <= batch->lane_count; lane += 8)
+		{
+			__m256i x = _mm256_load_si256((const __m256i*)(batch->candidate_x + lane));
+			__m256i y = _mm256_load_si256((const __m256i*)(batch->candidate_y + lane));
+			__m256i shape = _mm256_load_si256((const __m256i*)(batch->candidate_shape + lane));
+
+			__m256i shift = _mm256_add_epi32(x, shift_offset);
+			__m256i shape_index = _mm256_mullo_epi32(shape, shape_height);
+			__m256i lane_offset = _mm256_mullo_epi32(_mm256_add_epi32(lane_index, _mm256_set1_epi32((int)lane)), lane_bytes);
+			__m256i row_index = _mm256_add_epi32(y, row_offset);
+			__m256i hit = zero;
+
+			for (int j = 0; j < MAX_TETROMINO_HEIGHT; ++j)
+			{
+				__m256i piece = _mm256_i32gather_epi32(shape_table, _mm256_add_epi32(shape_index, _mm256_set1_epi32(j)), 4);
+				__m256i row_byte_offset = _mm256_add_epi32(lane_offset, _mm256_slli_epi32(_mm256_sub_epi32(row_index, _mm256_set1_epi32(j)), 1));
+				__m256i row = _mm256_and_si256(_mm256_i32gather_epi32(row_bytes, row_byte_offset, 1), row_mask);
+
+				hit = _mm256_or_si256(hit, _mm256_and_si256(_mm256_sllv_epi32(piece, shift), row));
+			}
+
+			int free_lanes = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(hit, zero)));
+
+			for (int i = 0; i < 8; ++i)
+			{
+				batch->collisions[lane + i] = ((free_lanes >> i) & 1) == 0;
+			}
+		}
+	}
+#endif
+
+	for (; lane < batch->lane_count; ++lane)
+	{
+		batch->collisions[lane] = does_batch_lane_collide(batch->rows[lane], batch->candidate_x[lane], batch->candidate_y[lane], batch->candidate_shape[lane]);
+	}
+}
+
+static inline uint32_t find_full_batch_rows(const uint16_t* rows, bool use_simd)
+{
+	uint32_t full_rows = 0;
+
+#ifdef BATCH_HAS_SSE2
+	if (use_simd)
+	{
+		const __m128i full = _mm_set1_epi16((short)BOARD_ROW_FULL);
+		const __m128i zero = _mm_setzero_si128();
+
+		// Eight rows per compare, the whole lane in four:
+		for (int i = 0; i < BATCH_ROW_STRIDE / 8; ++i)
+		{
+			__m128i row = _mm_load_si128((const __m128i*)(rows + i * 8));
+			__m128i is_full = _mm_packs_epi16(_mm_cmpeq_epi16(row, full), zero);
+
+			full_rows |= (uint32_t)(_mm_movemask_epi8(is_full) & 0xff) << (i * 8);
+		}
+
+		return full_rows & BATCH_BOARD_ROW_MASK;
+	}
+#endif
+
+	for (int j = BATCH_ROW_OFFSET; j < BATCH_ROW_OFFSET + BOARD_HEIGHT; ++j)
+	{
+		if (rows[j] == BOARD_ROW_FULL)
+		{
+			full_rows |= (1u << j);
+		}
+	}
+
+	return full_rows;
+}
+
+static uint8_t clear_full_batch_rows(uint16_t* rows, uint32_t full_rows)
+{
+	uint8_t line_count = 0;
+	int new_row_index = BATCH_ROW_OFFSET;
+
+	for (int j = BATCH_ROW_OFFSET; j < BATCH_ROW_OFFSET + BOARD_HEIGHT; ++j)
+	{
+		if (full_rows & (1u << j))
+		{
+			line_count++;
+			continue;
+		}
+
+		rows[new_row_index++] = rows[j];
+	}
+
+	while (new_row_index < BATCH_ROW_OFFSET + BOARD_HEIGHT)
+	{
+		rows[new_row_index++] = BOARD_ROW_EMPTY;
+	}
+
+	return line_count;
+}
+
+static void lock_batch_lane(Batch_Engine* batch, uint32_t lane)
+{
+	uint16_t* rows = batch->rows[lane];
+	uint32_t* columns = batch->columns[lane];
+	const Tetromino_Shape* shape = &TETROMINO_SHAPES[batch->type[lane]][batch->rotation[lane]];
+	int32_t x = batch->position_x[lane];
+	int32_t y = batch->position_y[lane];
+
+	for (size_t i = 0; i < TETROMINO_CELL_COUNT; ++i)
+	{
+		rows[y - shape->cells[i].y + BATCH_ROW_OFFSET] |= BOARD_ROW_BIT(x + shape->cells[i].x);
+		columns[x + shape->cells[i].x] |= 1u << (y - shape->cells[i].y);
+	}
+
+	uint32_t full_rows = find_full_batch_rows(rows, batch->use_simd);
+	uint8_t line_count = 0;
+
+	if (full_rows != 0)
+	{
+		line_count = clear_full_batch_rows(rows, full_rows);
+
+		// Take cleared rows out of every column, highest first so lower bits keep their place:
+		for (uint32_t remaining = full_rows >> BATCH_ROW_OFFSET; remaining != 0; )
+		{
+			int j = find_highest_set_bit(remaining);
+			uint32_t below = (1u << j) - 1;
+
+			for (size_t i = 0; i < BOARD_WIDTH; ++i)
+			{
+				columns[i] = (columns[i] & below) | ((columns[i] >> 1) & ~below);
+			}
+
+			remaining &= below;
+		}
+	}
+
+	// Same order as update_game_playing_phase: lines, score, game over, level:
+	batch->line_count[lane] += line_count;
+	batch->score[lane] += get_score_for_lines(batch->current_level[lane], line_count);
+
+	if (rows[BOARD_HEIGHT_RENDERED + BATCH_ROW_OFFSET] != BOARD_ROW_EMPTY ||
+		rows[BOARD_HEIGHT_RENDERED + 1 + BATCH_ROW_OFFSET] != BOARD_ROW_EMPTY)
+	{
+		batch->game_phase[lane] = GAME_PHASE_GAMEOVER;
+	}
+
+	uint8_t level = batch->current_level[lane];
+
+	if (level < (LEVEL_COUNT - 1) && batch->line_count[lane] >= ((uint32_t)(level + 1) * 10))
+	{
+		batch->current_level[lane]++;
+	}
+
+	batch->should_spawn_tetromino[lane] = true;
+}
+
+void step_batch_engine(Batch_Engine* batch, const uint8_t* input_flags)
+{
+	uint32_t lane_count = batch->lane_count;
+	uint8_t* step_mode = batch->step_mode;
+	uint8_t* spawned = batch->spawned;
+
+	// Spawn and apply input, this is the candidate state of every lane:
+	for (uint32_t lane = 0; lane < lane_count; ++lane)
+	{
+		spawned[lane] = false;
+
+		if (batch->game_phase[lane] != GAME_PHASE_PLAYING)
+		{
+			batch->candidate_x[lane] = batch->position_x[lane];
+			batch->candidate_y[lane] = batch->position_y[lane];
+			batch->candidate_shape[lane] = batch->type[lane] * TETROMINO_ROTATION_COUNT + batch->rotation[lane];
+			continue;
+		}
+
+		if (batch->should_spawn_tetromino[lane])
+		{
+			batch->type[lane] = (uint8_t)next_piece(&batch->piece_queue[lane]);
+			batch->position_x[lane] = SPAWN_POSITION_X;
+			batch->position_y[lane] = SPAWN_POSITION_Y;
+			batch->rotation[lane] = 0;
+			batch->should_spawn_tetromino[lane] = false;
+			spawned[lane] = true;
+		}
+
+		uint8_t input = input_flags ? input_flags[lane] : 0;
+		int32_t rotation = (batch->rotation[lane] + ((input & INPUT_FLAG_UP) ? 1 : 0)) % TETROMINO_ROTATION_COUNT;
+
+		batch->candidate_x[lane] = batch->position_x[lane] + ((input & INPUT_FLAG_RIGHT) ? 1 : 0) - ((input & INPUT_FLAG_LEFT) ? 1 : 0);
+		batch->candidate_y[lane] = batch->position_y[lane] - ((input & INPUT_FLAG_DOWN) ? 1 : 0);
+		batch->candidate_shape[lane] = batch->type[lane] * TETROMINO_ROTATION_COUNT + rotation;
+	}
+
+	find_batch_collisions(batch, batch->use_simd);
+
+	// Resolve rotations, then decide if the second test is for falling one row:
+	for (uint32_t lane = 0; lane < lane_count; ++lane)
+	{
+		step_mode[lane] = BATCH_STEP_MODE_NONE;
+
+		if (batch->game_phase[lane] != GAME_PHASE_PLAYING)
+		{
+			continue;
+		}
+
+		bool hit = batch->collisions[lane];
+		int32_t rotation = batch->candidate_shape[lane] % TETROMINO_ROTATION_COUNT;
+
+		if (spawned[lane] && hit)
+		{
+			batch->game_phase[lane] = GAME_PHASE_GAMEOVER;
+			continue;
+		}
+
+		// A rotation that collides is pushed off the walls before gravity, as in move_tetromino_for_rotation.
+		// Rare enough to test one lane at a time:
+		if (hit && rotation != batch->rotation[lane])
+		{
+			Extents extents = TETROMINO_SHAPES[batch->type[lane]][rotation].extents;
+			int32_t x = batch->candidate_x[lane];
+
+			// How far the rotated tetromino overflows from right or left wall:
+			int32_t higher_max_x = max(x + extents.max_x - (BOARD_WIDTH - 1), 0);
+			int32_t lower_min_x = min(x + extents.min_x, 0);
+
+			batch->candidate_x[lane] -= (higher_max_x > 0) ? higher_max_x : lower_min_x;
+			hit = does_batch_lane_collide(batch->rows[lane], batch->candidate_x[lane], batch->candidate_y[lane], batch->candidate_shape[lane]);
+		}
+
+		// Input that still collides is dropped, the lane stays where it was:
+		if (hit)
+		{
+			batch->candidate_x[lane] = batch->position_x[lane];
+			batch->candidate_y[lane] = batch->position_y[lane];
+			batch->candidate_shape[lane] = batch->type[lane] * TETROMINO_ROTATION_COUNT + batch->rotation[lane];
+		}
+
+		batch->fall_progress[lane] += BATCH_GRAVITY[batch->current_level[lane]];
+
+		if (batch->fall_progress[lane] >= GRAVITY_ONE_ROW)
+		{
+			// Gravity of every level stays below a row per tick, one row is all a lane ever falls:
+			batch->fall_progress[lane] &= GRAVITY_FRACTION_MASK;
+			batch->candidate_y[lane]--;
+			step_mode[lane] = BATCH_STEP_MODE_FALL;
+		}
+		else if (!hit)
+		{
+			batch->position_x[lane] = batch->candidate_x[lane];
+			batch->position_y[lane] = batch->candidate_y[lane];
+			batch->rotation[lane] = (uint8_t)rotation;
+		}
+	}
+
+	find_batch_collisions(batch, batch->use_simd);
+
+	for (uint32_t lane = 0; lane < lane_count; ++lane)
+	{
+		if (step_mode[lane] == BATCH_STEP_MODE_NONE)
+		{
+			continue;
+		}
+
+		bool hit = batch->collisions[lane];
+		uint8_t rotation = (uint8_t)(batch->candidate_shape[lane] % TETROMINO_ROTATION_COUNT);
+
+		batch->position_x[lane] = batch->candidate_x[lane];
+		batch->position_y[lane] = batch->candidate_y[lane] + (hit ? 1 : 0);
+		batch->rotation[lane] = rotation;
+
+		if (hit)
+		{
+			lock_batch_lane(batch, lane);
+		}
+	}
+
+	if (input_flags == NULL)
+	{
+		return;
+	}
+
+	// Hard drops, rare enough to do one lane at a time:
+	for (uint32_t lane = 0; lane < lane_count; ++lane)
+	{
+		if ((input_flags[lane] & INPUT_FLAG_SPACE) == 0 || batch->game_phase[lane] != GAME_PHASE_PLAYING || batch->should_spawn_tetromino[lane])
+		{
+			continue;
+		}
+
+		Tetromino tetromino = {
+			.pivot_position = {.x = (int16_t)batch->position_x[lane], .y = (int16_t)batch->position_y[lane]},
+			.rotation = batch->rotation[lane],
+			.type = (enum Tetromino_Type)batch->type[lane],
+		};
+
+		// Landing row from the column bits, as find_landing_y does for a Board:
+		batch->position_y[lane] = find_column_landing_y(batch->columns[lane], tetromino);
+
+		batch->fall_progress[lane] = 0;
+		lock_batch_lane(batch, lane);
+	}
+}
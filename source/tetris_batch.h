@@ -0,0 +1,64 @@
+#ifndef TETRIS_BATCH_H
+#define TETRIS_BATCH_H
+
+// Lock-step engine advancing many independent games per call, one lane per game.
+// It follows the rules of update_game_playing_phase, with gravity counted in ticks.
+// Lanes always play ROTATION_SYSTEM_SIMPLE and the gravity of their level, whatever the
+// rotation system or fixed gravity of a loaded game.
+
+#include "tetris_board.h"
+#include "tetris_core.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// Every lane owns 32 rows (64 bytes, one cache line). Board row y is stored at
+// y + BATCH_ROW_OFFSET, rows below and above the board are full, so collision
+// tests never have to check bounds:
+#define BATCH_ROW_STRIDE 32
+#define BATCH_ROW_OFFSET 6
+#define BATCH_BOARD_ROW_MASK (((1u << BOARD_HEIGHT) - 1) << BATCH_ROW_OFFSET)
+#define BATCH_LANE_ALIGNMENT 64
+
+typedef struct Batch_Engine
+{
+	uint32_t lane_count;
+	bool use_simd;
+	// Randomizer of lanes started by reset_batch_lane:
+	enum Piece_Randomizer randomizer;
+
+	// Per lane, structure of arrays:
+	uint16_t (*rows)[BATCH_ROW_STRIDE];
+	int32_t* position_x;
+	int32_t* position_y;
+	uint8_t* rotation;
+	uint8_t* type;
+	uint32_t* fall_progress;
+	uint32_t* line_count;
+	uint32_t* score;
+	Piece_Queue* piece_queue;
+	// Filled rows of every column, bit y for board row y, as in Board. Only hard drops read them:
+	uint32_t (*columns)[BOARD_WIDTH];
+	uint8_t* current_level;
+	uint8_t* game_phase;
+	uint8_t* should_spawn_tetromino;
+
+	// Scratch space of the collision passes:
+	int32_t* candidate_x;
+	int32_t* candidate_y;
+	int32_t* candidate_shape;
+	uint8_t* collisions;
+	uint8_t* step_mode;
+	uint8_t* spawned;
+
+	void* memory;
+} Batch_Engine;
+
+bool create_batch_engine(Batch_Engine*, uint32_t);
+void destroy_batch_engine(Batch_Engine*);
+void reset_batch_lane(Batch_Engine*, uint32_t, uint64_t);
+void load_batch_lane(Batch_Engine*, uint32_t, const Game_State*);
+void step_batch_engine(Batch_Engine*, const uint8_t*);
+uint32_t restart_finished_batch_lanes(Batch_Engine*, uint64_t);
+void find_batch_collisions(const Batch_Engine*, bool);
+
+#endif
@@ -0,0 +1,479 @@
+/* ISMET BARAN SURUCU -- github.com/baransrc */
+#include "tetris_board.h"
+#include <string.h>
+
+Tetromino_Shape TETROMINO_SHAPES[TETROMINO_TYPE_COUNT][TETROMINO_ROTATION_COUNT];
+
+static bool tetromino_shapes_initialized = false;
+
+// Internal ---------------------
+static void write_board_cell(Board*, int, int, uint8_t);
+static void update_tetromino_columns(Board*, Tetromino);
+// ------------------------------
+
+void initialize_tetromino_shapes(void)
+{
+	if (tetromino_shapes_initialized)
+	{
+		return;
+	}
+
+	for (size_t type = 0; type < TETROMINO_TYPE_COUNT; ++type)
+	{
+		for (size_t rotation = 0; rotation < TETROMINO_ROTATION_COUNT; ++rotation)
+		{
+			Tetromino_Shape* shape = &TETROMINO_SHAPES[type][rotation];
+			size_t cell_index = 0;
+
+			shape->extents = (Extents){.min_x = 0, .min_y = 0, .max_x = 0, .max_y = 0};
+			memset(shape->column_bottoms, -1, sizeof(shape->column_bottoms));
+
+			for (size_t j = 0; j < MAX_TETROMINO_HEIGHT; ++j)
+			{
+				uint8_t mask = 0;
+
+				for (size_t i = 0; i < MAX_TETROMINO_WIDTH; ++i)
+				{
+					if (TETROMINOES[type][rotation][j][i] == 0)
+					{
+						continue;
+					}
+
+					int8_t offset_x = (int8_t)i - TETROMINO_PIVOT_X;
+					int8_t offset_y = (int8_t)j - TETROMINO_PIVOT_Y;
+
+					mask |= (uint8_t)(1u << i);
+					shape->column_bottoms[i] = (int8_t)j;
+					shape->cells[cell_index++] = (Cell_Offset){.x = offset_x, .y = offset_y};
+
+					shape->extents.max_x = max(offset_x, shape->extents.max_x);
+					shape->extents.min_x = min(offset_x, shape->extents.min_x);
+					shape->extents.max_y = max(offset_y, shape->extents.max_y);
+					shape->extents.min_y = min(offset_y, shape->extents.min_y);
+				}
+
+				shape->row_masks[j] = mask;
+			}
+		}
+	}
+
+	tetromino_shapes_initialized = true;
+}
+
+const Tetromino_Shape* get_tetromino_shape(Tetromino tetromino)
+{
+	return &TETROMINO_SHAPES[tetromino.type][tetromino.rotation];
+}
+
+void put_tetromino_cells(Board* board, Tetromino tetromino)
+{
+	const Tetromino_Shape* shape = get_tetromino_shape(tetromino);
+
+	for (size_t i = 0; i < TETROMINO_CELL_COUNT; ++i)
+	{
+		int board_x = tetromino.pivot_position.x + shape->cells[i].x;
+		int board_y = tetromino.pivot_position.y - shape->cells[i].y;
+
+		write_board_cell(board, board_x, board_y, tetromino.type);
+	}
+
+	update_tetromino_columns(board, tetromino);
+}
+
+void delete_tetromino_cells(Board* board, Tetromino tetromino)
+{
+	const Tetromino_Shape* shape = get_tetromino_shape(tetromino);
+
+	for (size_t i = 0; i < TETROMINO_CELL_COUNT; ++i)
+	{
+		int board_x = tetromino.pivot_position.x + shape->cells[i].x;
+		int board_y = tetromino.pivot_position.y - shape->cells[i].y;
+
+		write_board_cell(board, board_x, board_y, EMPTY_CELL_TYPE);
+	}
+
+	update_tetromino_columns(board, tetromino);
+}
+
+static void update_tetromino_columns(Board* board, Tetromino tetromino)
+{
+	const Tetromino_Shape* shape = get_tetromino_shape(tetromino);
+
+	update_board_columns(board, tetromino.pivot_position.x + shape->extents.min_x, tetromino.pivot_position.x + shape->extents.max_x);
+}
+
+void clear_board(Board* board)
+{
+	for (size_t j = 0; j < BOARD_HEIGHT; ++j)
+	{
+		board->rows[j] = BOARD_ROW_EMPTY;
+	}
+
+	memset(board->columns, 0, sizeof(board->columns));
+	memset(board->colors, 0xff, sizeof(board->colors));
+	memset(board->row_counts, 0, sizeof(board->row_counts));
+	memset(board->column_heights, 0, sizeof(board->column_heights));
+	memset(board->column_holes, 0, sizeof(board->column_holes));
+	memset(board->well_depths, 0, sizeof(board->well_depths));
+	board->hole_count = 0;
+}
+
+void set_board_cell(Board* board, int x, int y, uint8_t type)
+{
+	write_board_cell(board, x, y, type);
+	update_board_columns(board, x, x);
+}
+
+static void write_board_cell(Board* board, int x, int y, uint8_t type)
+{
+	// Cells and row counts only, callers update the columns they touched once afterwards:
+	uint8_t* color_byte = &board->colors[y][x / 2];
+	uint8_t shift = (x & 1) * 4;
+	uint8_t nibble = (type == EMPTY_CELL_TYPE) ? BOARD_COLOR_EMPTY : type;
+
+	*color_byte = (uint8_t)((*color_byte & ~(0xf << shift)) | (nibble << shift));
+
+	bool was_filled = (board->rows[y] & BOARD_ROW_BIT(x)) != 0;
+
+	if (type == EMPTY_CELL_TYPE)
+	{
+		board->rows[y] &= (uint16_t)~BOARD_ROW_BIT(x);
+		board->columns[x] &= ~(1u << y);
+		board->row_counts[y] -= was_filled;
+	}
+	else
+	{
+		board->rows[y] |= BOARD_ROW_BIT(x);
+		board->columns[x] |= 1u << y;
+		board->row_counts[y] += !was_filled;
+	}
+}
+
+void update_board_columns(Board* board, int first_x, int last_x)
+{
+	// Heights and holes of the given columns from their bits, then the wells they border:
+	for (int i = first_x; i <= last_x; ++i)
+	{
+		uint32_t column = board->columns[i];
+		uint8_t height = column ? (uint8_t)(find_highest_set_bit(column) + 1) : 0;
+		uint8_t holes = (uint8_t)(height - count_set_bits(column));
+
+		board->hole_count += holes - board->column_holes[i];
+		board->column_heights[i] = height;
+		board->column_holes[i] = holes;
+	}
+
+	for (int i = max(first_x - 1, 0); i <= min(last_x + 1, BOARD_WIDTH - 1); ++i)
+	{
+		int left = (i > 0) ? board->column_heights[i - 1] : BOARD_HEIGHT;
+		int right = (i < BOARD_WIDTH - 1) ? board->column_heights[i + 1] : BOARD_HEIGHT;
+		int depth = min(left, right) - board->column_heights[i];
+
+		board->well_depths[i] = (uint8_t)max(depth, 0);
+	}
+}
+
+uint8_t get_board_cell(const Board* board, int x, int y)
+{
+	uint8_t nibble = (board->colors[y][x / 2] >> ((x & 1) * 4)) & 0xf;
+
+	return (nibble == BOARD_COLOR_EMPTY) ? EMPTY_CELL_TYPE : nibble;
+}
+
+bool is_board_row_full(const Board* board, int y)
+{
+	return board->rows[y] == BOARD_ROW_FULL;
+}
+
+bool is_board_row_empty(const Board* board, int y)
+{
+	return board->rows[y] == BOARD_ROW_EMPTY;
+}
+
+bool does_tetromino_collide(const Board* board, Tetromino tetromino)
+{
+	const Tetromino_Shape* shape = get_tetromino_shape(tetromino);
+	// Column i of the definition lands on board bit (pivot_x + i - TETROMINO_PIVOT_X + BOARD_ROW_WALL_BITS):
+	int shift = tetromino.pivot_position.x - TETROMINO_PIVOT_X + BOARD_ROW_WALL_BITS;
+	int first_row = shape->extents.min_y + TETROMINO_PIVOT_Y;
+	int last_row = shape->extents.max_y + TETROMINO_PIVOT_Y;
+
+	for (int j = first_row; j <= last_row; ++j)
+	{
+		uint32_t mask = shape->row_masks[j];
+		int board_y = tetromino.pivot_position.y - (j - TETROMINO_PIVOT_Y);
+
+		// Is this row overflowing from top or bottom:
+		if (board_y < 0 || board_y >= BOARD_HEIGHT)
+		{
+			return true;
+		}
+
+		uint32_t row_mask;
+
+		if (shift >= 0)
+		{
+			row_mask = mask << shift;
+		}
+		else
+		{
+			// Cells shifted out are far beyond the left wall:
+			if (mask & ((1u << -shift) - 1))
+			{
+				return true;
+			}
+
+			row_mask = mask >> -shift;
+		}
+
+		// Bits above the row are far beyond the right wall:
+		if ((row_mask & ~(uint32_t)BOARD_ROW_FULL) || (row_mask & board->rows[board_y]))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+uint32_t clear_full_board_rows(Board* board)
+{
+	return clear_full_board_rows_between(board, 0, BOARD_HEIGHT - 1);
+}
+
+uint32_t clear_full_board_rows_between(Board* board, int first_y, int last_y)
+{
+	// Only rows first_y to last_y can be full, such as the rows of the tetromino that just locked.
+	// Rows below the first full one stay where they are:
+	uint32_t cleared_rows = 0;
+
+	for (int j = first_y; j <= last_y; ++j)
+	{
+		if (board->row_counts[j] == BOARD_WIDTH)
+		{
+			cleared_rows |= (1u << j);
+		}
+	}
+
+	if (cleared_rows == 0)
+	{
+		return 0;
+	}
+
+	int new_row_index = find_lowest_set_bit(cleared_rows);
+
+	for (int j = new_row_index; j < BOARD_HEIGHT; ++j)
+	{
+		if (cleared_rows & (1u << j))
+		{
+			continue;
+		}
+
+		board->rows[new_row_index] = board->rows[j];
+		board->row_counts[new_row_index] = board->row_counts[j];
+		memcpy(board->colors[new_row_index], board->colors[j], BOARD_COLOR_ROW_SIZE);
+
+		new_row_index++;
+	}
+
+	for (int j = new_row_index; j < BOARD_HEIGHT; ++j)
+	{
+		board->rows[j] = BOARD_ROW_EMPTY;
+		board->row_counts[j] = 0;
+		memset(board->colors[j], 0xff, BOARD_COLOR_ROW_SIZE);
+	}
+
+	// Take cleared rows out of every column, highest first so lower bits keep their place:
+	for (uint32_t remaining = cleared_rows; remaining != 0; )
+	{
+		int j = find_highest_set_bit(remaining);
+		uint32_t below = (1u << j) - 1;
+
+		for (size_t i = 0; i < BOARD_WIDTH; ++i)
+		{
+			board->columns[i] = (board->columns[i] & below) | ((board->columns[i] >> 1) & ~below);
+		}
+
+		remaining &= below;
+	}
+
+	update_board_columns(board, 0, BOARD_WIDTH - 1);
+
+	return cleared_rows;
+}
+
+int16_t find_landing_y(const Board* board, Tetromino tetromino)
+{
+	// Pivot y where the tetromino ends if it drops straight down, it must not collide where it is:
+	return find_column_landing_y(board->columns, tetromino);
+}
+
+int16_t find_column_landing_y(const uint32_t* columns, Tetromino tetromino)
+{
+	// Same as find_landing_y for anything that keeps filled rows per column, one bit per row.
+	// In every column it can drop until its lowest cell meets the highest filled cell below it:
+	const Tetromino_Shape* shape = get_tetromino_shape(tetromino);
+	int drop = BOARD_HEIGHT;
+
+	for (int i = shape->extents.min_x + TETROMINO_PIVOT_X; i <= shape->extents.max_x + TETROMINO_PIVOT_X; ++i)
+	{
+		if (shape->column_bottoms[i] < 0)
+		{
+			continue;
+		}
+
+		int board_x = tetromino.pivot_position.x + i - TETROMINO_PIVOT_X;
+		int board_y = tetromino.pivot_position.y - (shape->column_bottoms[i] - TETROMINO_PIVOT_Y);
+		uint32_t below = columns[board_x] & ((1u << board_y) - 1);
+		int floor_y = below ? find_highest_set_bit(below) + 1 : 0;
+
+		drop = min(drop, board_y - floor_y);
+	}
+
+	return (int16_t)(tetromino.pivot_position.y - drop);
+}
+
+uint64_t hash_board_rows(const Board* board, int first_y, int last_y)
+{
+	// Every row that is not empty mixes its cells, colours and y into 64 bits. Rows combine
+	// with xor, so a changed row is swapped out by hashing it before and after, and an empty
+	// board hashes to 0:
+	uint64_t hash = 0;
+
+	first_y = max(first_y, 0);
+	last_y = min(last_y, BOARD_HEIGHT - 1);
+
+	for (int j = first_y; j <= last_y; ++j)
+	{
+		if (board->rows[j] == BOARD_ROW_EMPTY)
+		{
+			continue;
+		}
+
+		uint64_t key = ((uint64_t)board->rows[j] << 48) | ((uint64_t)j << 40);
+
+		for (int i = 0; i < BOARD_COLOR_ROW_SIZE; ++i)
+		{
+			key |= (uint64_t)board->colors[j][i] << (i * 8);
+		}
+
+		hash ^= mix_hash(key);
+	}
+
+	return hash;
+}
+
+void put_tetromino_cells_reference(Board* board, Tetromino tetromino)
+{
+	for (size_t i = 0; i < MAX_TETROMINO_WIDTH; ++i)
+	{
+		for (size_t j = 0; j < MAX_TETROMINO_HEIGHT; ++j)
+		{
+			uint8_t cell_value = TETROMINOES[tetromino.type][tetromino.rotation][j][i];
+
+			if (cell_value == 0)
+			{
+				continue;
+			}
+
+			int board_x = tetromino.pivot_position.x + (int)i - TETROMINO_PIVOT_X;
+			int board_y = tetromino.pivot_position.y - ((int)j - TETROMINO_PIVOT_Y);
+
+			set_board_cell(board, board_x, board_y, (uint8_t)tetromino.type);
+		}
+	}
+}
+
+bool does_tetromino_collide_reference(const Board* board, Tetromino tetromino)
+{
+	Vector2 center = tetromino.pivot_position;
+
+	for (size_t i = 0; i < MAX_TETROMINO_WIDTH; ++i)
+	{
+		for (size_t j = 0; j < MAX_TETROMINO_HEIGHT; ++j)
+		{
+			uint8_t cell_value = TETROMINOES[tetromino.type][tetromino.rotation][j][i];
+
+			if (cell_value == 0)
+			{
+				continue;
+			}
+
+			int offset_x = (int)i - TETROMINO_PIVOT_X;
+			int offset_y = (int)j - TETROMINO_PIVOT_Y;
+			int board_x = center.x + offset_x;
+			int board_y = center.y - offset_y;
+
+			// Is this cell overflowing from any side of the board:
+			if (board_x >= BOARD_WIDTH || board_x < 0 || board_y >= BOARD_HEIGHT || board_y < 0)
+			{
+				return true;
+			}
+
+			// Is this cell already occupied by another tetromino:
+			if (get_board_cell(board, board_x, board_y) != EMPTY_CELL_TYPE)
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+int16_t find_landing_y_reference(const Board* board, Tetromino tetromino)
+{
+	// Drops the tetromino one row at a time until the next row would collide:
+	do
+	{
+		tetromino.pivot_position.y--;
+	}
+	while (!does_tetromino_collide_reference(board, tetromino));
+
+	return tetromino.pivot_position.y + 1;
+}
+
+uint32_t clear_full_board_rows_reference(Board* board)
+{
+	uint32_t cleared_rows = 0;
+	int new_row_index = 0;
+	Board new_board;
+
+	clear_board(&new_board);
+
+	for (int j = 0; j < BOARD_HEIGHT; ++j)
+	{
+		bool has_line = true;
+
+		for (int i = 0; i < BOARD_WIDTH; ++i)
+		{
+			if (get_board_cell(board, i, j) == EMPTY_CELL_TYPE)
+			{
+				has_line = false;
+				break;
+			}
+		}
+
+		if (has_line)
+		{
+			cleared_rows |= (1u << j);
+			continue;
+		}
+
+		for (int i = 0; i < BOARD_WIDTH; ++i)
+		{
+			uint8_t type = get_board_cell(board, i, j);
+
+			if (type != EMPTY_CELL_TYPE)
+			{
+				set_board_cell(&new_board, i, new_row_index, type);
+			}
+		}
+
+		new_row_index++;
+	}
+
+	*board = new_board;
+
+	return cleared_rows;
+}
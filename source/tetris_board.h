@@ -0,0 +1,179 @@
+#ifndef TETRIS_BOARD_H
+#define TETRIS_BOARD_H
+
+#include "tetris_util.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#define BOARD_WIDTH 10
+#define BOARD_HEIGHT 22
+#define BOARD_HEIGHT_RENDERED 20
+#define BOARD_SIZE BOARD_HEIGHT*BOARD_WIDTH
+#define MAX_TETROMINO_WIDTH 5
+#define MAX_TETROMINO_HEIGHT 5
+#define MAX_TETROMINO_ARRAY_SIZE MAX_TETROMINO_WIDTH*MAX_TETROMINO_HEIGHT
+#define TETROMINO_TYPE_COUNT 7
+#define TETROMINO_ROTATION_COUNT 4
+#define EMPTY_CELL_TYPE 255
+#define TETROMINO_PIVOT_X 2
+#define TETROMINO_PIVOT_Y 2
+#define TETROMINO_CELL_COUNT 4
+
+// Row bitmasks:
+// Column x of the board is bit (x + BOARD_ROW_WALL_BITS) of its row. The bits on both sides
+// of the playfield are always set, so walls collide like any other occupied cell.
+#define BOARD_ROW_WALL_BITS 3
+#define BOARD_ROW_EMPTY ((uint16_t)0xE007)
+#define BOARD_ROW_FULL ((uint16_t)0xFFFF)
+#define BOARD_ROW_BIT(x) ((uint16_t)(1u << ((x) + BOARD_ROW_WALL_BITS)))
+
+// Colour plane packs two cell types per byte, 0xF is an empty cell:
+#define BOARD_COLOR_ROW_SIZE (BOARD_WIDTH / 2)
+#define BOARD_COLOR_EMPTY 0xF
+
+enum Tetromino_Type
+{
+	TETROMINO_TYPE_I,
+	TETROMINO_TYPE_O,
+	TETROMINO_TYPE_T,
+	TETROMINO_TYPE_J,
+	TETROMINO_TYPE_L,
+	TETROMINO_TYPE_S,
+	TETROMINO_TYPE_Z
+};
+
+typedef struct Vector2
+{
+	int16_t x;
+	int16_t y;
+} Vector2;
+
+typedef struct Extents
+{
+	int16_t min_x;
+	int16_t min_y;
+	int16_t max_x;
+	int16_t max_y;
+} Extents;
+
+typedef struct Cell_Offset
+{
+	int8_t x;
+	int8_t y;
+} Cell_Offset;
+
+typedef struct Tetromino
+{
+	Vector2 pivot_position;
+	uint8_t rotation;
+	enum Tetromino_Type type;
+} Tetromino;
+
+typedef struct Board
+{
+	// Occupancy of each row, used by collision and line detection:
+	uint16_t rows[BOARD_HEIGHT];
+	// Occupancy of each column, bit y is row y, used to find landing rows:
+	uint32_t columns[BOARD_WIDTH];
+	// Tetromino type of each cell, only needed for rendering:
+	uint8_t colors[BOARD_HEIGHT][BOARD_COLOR_ROW_SIZE];
+	// Features kept up to date as cells change, so evaluators never recount them:
+	// Filled cells of each row:
+	uint8_t row_counts[BOARD_HEIGHT];
+	// One above the highest filled cell of each column, 0 for an empty column:
+	uint8_t column_heights[BOARD_WIDTH];
+	// Empty cells below the height of each column:
+	uint8_t column_holes[BOARD_WIDTH];
+	// How far both neighbours of each column rise above it, the walls count as BOARD_HEIGHT high:
+	uint8_t well_depths[BOARD_WIDTH];
+	uint8_t hole_count;
+} Board;
+
+// Everything derived from one TETROMINOES entry, so nothing has to walk the 5x5 definition:
+typedef struct Tetromino_Shape
+{
+	// Offsets of filled cells from the pivot, y grows downwards as in TETROMINOES:
+	Cell_Offset cells[TETROMINO_CELL_COUNT];
+	// Bit i is column i of the definition:
+	uint8_t row_masks[MAX_TETROMINO_HEIGHT];
+	// Lowest filled row of column i of the definition, -1 if the column is empty:
+	int8_t column_bottoms[MAX_TETROMINO_WIDTH];
+	// Relative to the pivot, same convention as cells:
+	Extents extents;
+} Tetromino_Shape;
+
+extern Tetromino_Shape TETROMINO_SHAPES[TETROMINO_TYPE_COUNT][TETROMINO_ROTATION_COUNT];
+
+static inline int find_highest_set_bit(uint32_t value)
+{
+	// Value must not be zero:
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanReverse(&index, value);
+	return (int)index;
+#else
+	return 31 - __builtin_clz(value);
+#endif
+}
+
+static inline int find_lowest_set_bit(uint32_t value)
+{
+	// Value must not be zero:
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, value);
+	return (int)index;
+#else
+	return __builtin_ctz(value);
+#endif
+}
+
+static inline int count_set_bits(uint32_t value)
+{
+#ifdef _MSC_VER
+	return (int)__popcnt(value);
+#else
+	return __builtin_popcount(value);
+#endif
+}
+
+static inline uint64_t mix_hash(uint64_t value)
+{
+	// Finalizer of MurmurHash3, every bit in flips about half of the bits out:
+	value ^= value >> 33;
+	value *= 0xFF51AFD7ED558CCDull;
+	value ^= value >> 33;
+	value *= 0xC4CEB9FE1A85EC53ull;
+	value ^= value >> 33;
+
+	return value;
+}
+
+void initialize_tetromino_shapes(void);
+const Tetromino_Shape* get_tetromino_shape(Tetromino);
+void put_tetromino_cells(Board*, Tetromino);
+void delete_tetromino_cells(Board*, Tetromino);
+void clear_board(Board*);
+void set_board_cell(Board*, int, int, uint8_t);
+void update_board_columns(Board*, int, int);
+uint8_t get_board_cell(const Board*, int, int);
+bool is_board_row_full(const Board*, int);
+bool is_board_row_empty(const Board*, int);
+bool does_tetromino_collide(const Board*, Tetromino);
+uint32_t clear_full_board_rows(Board*);
+uint32_t clear_full_board_rows_between(Board*, int, int);
+int16_t find_landing_y(const Board*, Tetromino);
+int16_t find_column_landing_y(const uint32_t*, Tetromino);
+uint64_t hash_board_rows(const Board*, int, int);
+
+// Reference implementations, walking the board cell by cell:
+void put_tetromino_cells_reference(Board*, Tetromino);
+bool does_tetromino_collide_reference(const Board*, Tetromino);
+int16_t find_landing_y_reference(const Board*, Tetromino);
+uint32_t clear_full_board_rows_reference(Board*);
+
+#endif
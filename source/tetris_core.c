@@ -0,0 +1,695 @@
+/* ISMET BARAN SURUCU -- github.com/baransrc */
+#include "tetris_core.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Internal ---------------------
+static inline void level_up(Game_State*);
+static inline void add_score(Game_State*, uint8_t);
+static inline bool will_fall_this_turn(Game_State*);
+static inline bool does_game_tetromino_collide(const Game_State*, Tetromino);
+static inline int16_t find_game_landing_y(const Game_State*, Tetromino);
+// ------------------------------
+
+static inline bool does_game_tetromino_collide(const Game_State* game_state, Tetromino tetromino)
+{
+	if (game_state->use_reference_board)
+	{
+		return does_tetromino_collide_reference(&game_state->board, tetromino);
+	}
+
+	return does_tetromino_collide(&game_state->board, tetromino);
+}
+
+static inline int16_t find_game_landing_y(const Game_State* game_state, Tetromino tetromino)
+{
+	if (game_state->use_reference_board)
+	{
+		return find_landing_y_reference(&game_state->board, tetromino);
+	}
+
+	return find_landing_y(&game_state->board, tetromino);
+}
+
+Extents find_extents_of_tetromino(Tetromino tetromino)
+{
+	// Finds extents of tetromino relative to matrix pivot position of tetromino (not board).
+	return get_tetromino_shape(tetromino)->extents;
+}
+
+uint32_t get_gravity(uint8_t level)
+{
+	// Rows per tick of this level, rounded up so no row takes longer than the fall time:
+	return (uint32_t)ceil(GRAVITY_ONE_ROW / (FALL_TIME_IN_SECS[level] * TICKS_PER_SECOND));
+}
+
+uint32_t get_game_gravity(const Game_State* game_state)
+{
+	return (game_state->fixed_gravity != 0) ? game_state->fixed_gravity : get_gravity(game_state->current_level);
+}
+
+uint32_t get_score_for_lines(uint8_t current_level, uint8_t lines_this_frame)
+{
+	uint32_t score = 0;
+
+	switch (lines_this_frame)
+    {
+		case 1:
+			score += (40 * (current_level + 1));
+		case 2:
+			score += (100 * (current_level + 1));
+		case 3:
+			score += (300 * (current_level + 1));
+		case 4:
+			score += (1200 * (current_level + 1));
+    }
+
+	return score;
+}
+
+uint8_t get_input_flags(const Input_State* input_state)
+{
+	return (input_state->pressed_left ? INPUT_FLAG_LEFT : 0) |
+		   (input_state->pressed_right ? INPUT_FLAG_RIGHT : 0) |
+		   (input_state->pressed_up ? INPUT_FLAG_UP : 0) |
+		   (input_state->pressed_down ? INPUT_FLAG_DOWN : 0) |
+		   (input_state->pressed_space ? INPUT_FLAG_SPACE : 0);
+}
+
+void set_input_flags(Input_State* input_state, uint8_t input_flags)
+{
+	input_state->pressed_left = (input_flags & INPUT_FLAG_LEFT) != 0;
+	input_state->pressed_right = (input_flags & INPUT_FLAG_RIGHT) != 0;
+	input_state->pressed_up = (input_flags & INPUT_FLAG_UP) != 0;
+	input_state->pressed_down = (input_flags & INPUT_FLAG_DOWN) != 0;
+	input_state->pressed_space = (input_flags & INPUT_FLAG_SPACE) != 0;
+}
+
+uint64_t get_game_hash(const Game_State* game_state)
+{
+	// Everything that decides how the game goes on, mixed one word at a time onto the board
+	// hash. Built from values and not from the layout of Game_State, so engines that store
+	// the state another way can hash it the same:
+	const Tetromino* tetromino = &game_state->current_tetromino;
+	const Piece_Queue* piece_queue = &game_state->piece_queue;
+	uint64_t words[11];
+	uint64_t hash = game_state->board_hash;
+
+	words[0] = (uint64_t)(uint16_t)tetromino->pivot_position.x | ((uint64_t)(uint16_t)tetromino->pivot_position.y << 16) |
+			   ((uint64_t)tetromino->rotation << 32) | ((uint64_t)tetromino->type << 40) | ((uint64_t)game_state->current_level << 48) |
+			   ((uint64_t)game_state->game_phase << 56) | ((uint64_t)game_state->should_spawn_tetromino << 60) |
+			   ((uint64_t)game_state->rotation_system << 61);
+	words[1] = (uint64_t)game_state->score | ((uint64_t)game_state->line_count << 32);
+	words[2] = (uint64_t)game_state->fall_progress | ((uint64_t)game_state->fixed_gravity << 32);
+	words[3] = game_state->tick_count;
+	words[4] = (uint64_t)piece_queue->next | ((uint64_t)piece_queue->randomizer << 8);
+	words[5] = 0;
+	words[6] = 0;
+
+	// Pieces still to come, the generator only decides the ones after them:
+	for (uint32_t i = piece_queue->next; i < PIECE_QUEUE_SIZE; ++i)
+	{
+		words[5 + (i >= 16)] = (words[5 + (i >= 16)] << 3) | (piece_queue->pieces[i] + 1u);
+	}
+
+	for (int i = 0; i < 4; ++i)
+	{
+		words[7 + i] = piece_queue->random.s[i];
+	}
+
+	for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); ++i)
+	{
+		hash = mix_hash(hash ^ words[i]);
+	}
+
+	return hash;
+}
+
+bool is_possible_movement(Game_State* game_state, bool force_update)
+{
+	Tetromino* tetromino = &(game_state->current_tetromino);
+	Vector2 center = tetromino->pivot_position;
+	uint8_t current_rotation = tetromino->rotation;
+
+	if (center.x != game_state->previous_tetromino_position.x || 
+	    center.y != game_state->previous_tetromino_position.y ||
+		current_rotation != game_state->previous_tetromino_rotation || 
+		force_update)
+	{
+		// Check if this will be a valid move:
+		return !does_game_tetromino_collide(game_state, *tetromino);
+	}
+
+	return true;
+}
+
+void clamp_movement(Game_State* game_state)
+{
+	if (!is_possible_movement(game_state, game_state->should_spawn_tetromino))
+	{
+		game_state->current_tetromino.pivot_position = game_state->previous_tetromino_position;
+		game_state->current_tetromino.rotation = game_state->previous_tetromino_rotation;
+	} 
+}
+
+void put_tetromino_to_board(Game_State* game_state)
+{
+	Tetromino* tetromino = &(game_state->current_tetromino);
+	Vector2 position = tetromino->pivot_position;
+
+	Extents extents = find_extents_of_tetromino(*tetromino);
+	int first_y = position.y - extents.max_y;
+	int last_y = position.y - extents.min_y;
+
+	TETRIS_LOG("--- Putting Tetromino (Pivot: %i,%i) ---\n", position.x, position.y);
+
+	if (game_state->use_reference_board)
+	{
+		put_tetromino_cells_reference(&game_state->board, *tetromino);
+		game_state->board_hash = hash_board_rows(&game_state->board, 0, BOARD_HEIGHT - 1);
+		return;
+	}
+
+	// Only the rows of the tetromino change, their hashes are swapped for the new ones:
+	game_state->board_hash ^= hash_board_rows(&game_state->board, first_y, last_y);
+	put_tetromino_cells(&game_state->board, *tetromino);
+	game_state->board_hash ^= hash_board_rows(&game_state->board, first_y, last_y);
+}
+
+bool is_tetromino_falling(const Game_State* game_state)
+{
+	// Between spawning and locking, the tetromino lives outside of the board:
+	return game_state->game_phase == GAME_PHASE_PLAYING && !game_state->should_spawn_tetromino;
+}
+
+void move_tetromino_for_rotation(Game_State* game_state)
+{
+	Tetromino* tetromino = &(game_state->current_tetromino);
+	uint8_t previous_rotation = game_state->previous_tetromino_rotation;
+
+	if (previous_rotation == tetromino->rotation)
+	{
+		return;
+	}
+
+	// Tests of the rotation system, the SRS I moves even when the plain turn fits:
+	enum Rotation_System rotation_system = (enum Rotation_System)game_state->rotation_system;
+	bool fits = game_state->use_reference_board ?
+		kick_rotated_tetromino_reference(&game_state->board, tetromino, rotation_system) :
+		kick_rotated_tetromino(&game_state->board, tetromino, rotation_system);
+
+	// None of them fits, the rotation is reverted with the move that came with it:
+	if (!fits)
+	{
+		tetromino->pivot_position = game_state->previous_tetromino_position;
+		tetromino->rotation = previous_rotation;
+	}
+}
+
+static inline void level_up(Game_State* game_state)
+{
+	if ( game_state->current_level < (LEVEL_COUNT - 1) && 
+		 game_state->line_count >= ((game_state->current_level + 1) * 10))
+	{
+		game_state->current_level++;
+		TETRIS_LOG("--- LEVEL: %i ---\n", game_state->current_level);
+	}
+}
+
+static inline void add_score(Game_State* game_state, uint8_t lines_this_frame)
+{
+	game_state->score += get_score_for_lines(game_state->current_level, lines_this_frame);
+
+	TETRIS_LOG("--- SCORE: %i ---\n", game_state->score);
+}
+
+bool has_current_tetromino_changed(Game_State* game_state)
+{
+	Vector2 previous_position = game_state->previous_tetromino_position;
+	Vector2 current_position = game_state->current_tetromino.pivot_position; 
+	uint8_t current_rotation = game_state->current_tetromino.rotation;
+	uint8_t previous_rotation = game_state->previous_tetromino_rotation;
+
+	if (game_state->should_spawn_tetromino)
+	{
+		return true;
+	}
+
+	if (will_fall_this_turn(game_state) ||
+		current_position.x != previous_position.x || 
+		current_position.y != previous_position.y || 
+		current_rotation != previous_rotation)
+	{
+		return true;
+	}
+
+	return false;
+}
+
+static inline bool will_fall_this_turn(Game_State* game_state)
+{
+	return (game_state->fall_progress >= GRAVITY_ONE_ROW);
+}
+
+bool tetromino_fall(Game_State* game_state)
+{
+	// Clamp movement to avoid overflows or collisions:
+	clamp_movement(game_state);
+
+	// Whole rows gathered fall now, the fraction is kept for the next ticks:
+	uint32_t row_count = game_state->fall_progress >> GRAVITY_FRACTION_BITS;
+	game_state->fall_progress &= GRAVITY_FRACTION_MASK;
+
+	// However many rows gravity asks for, the piece stops on its landing row:
+	Tetromino* tetromino = &(game_state->current_tetromino);
+	int distance = tetromino->pivot_position.y - find_game_landing_y(game_state, *tetromino);
+
+	if (distance == 0)
+	{
+		TETRIS_LOG("--- Falled ---\n");
+		return false;
+	}
+
+	tetromino->pivot_position.y -= (int16_t)min((uint32_t)distance, row_count);
+
+	return true;
+}
+
+void determine_current_destination(Game_State* game_state)
+{
+	// Straight from the column bits of the board, no row by row collision tests:
+	game_state->current_destination.y = find_game_landing_y(game_state, game_state->current_tetromino);
+	game_state->current_destination.x = game_state->current_tetromino.pivot_position.x;
+
+	TETRIS_LOG("--- Determined Current Destination: (%i, %i) ---\n", game_state->current_destination.x, game_state->current_destination.y);
+}
+
+void check_game_over(Game_State* game_state)
+{
+	// If tetromino cannot fall any further, and its pivot is beyond rendered board this means user has lost the game:
+	for (size_t j = BOARD_HEIGHT_RENDERED; j < BOARD_HEIGHT; ++j)
+	{
+		if (!is_board_row_empty(&game_state->board, j))
+		{
+			game_state->game_phase = GAME_PHASE_GAMEOVER;
+			return;
+		}
+	}
+}
+
+void destroy_lines(Game_State* game_state)
+{
+	uint8_t line_count = 0;
+	uint32_t cleared_rows;
+
+	if (game_state->use_reference_board)
+	{
+		// Every row checked cell by cell, and the hash built again from the whole board:
+		cleared_rows = clear_full_board_rows_reference(&game_state->board);
+		game_state->board_hash = hash_board_rows(&game_state->board, 0, BOARD_HEIGHT - 1);
+	}
+	else
+	{
+		// Only rows of the tetromino that just locked can have become full:
+		Tetromino tetromino = game_state->current_tetromino;
+		Extents extents = find_extents_of_tetromino(tetromino);
+		int first_y = max(tetromino.pivot_position.y - extents.max_y, 0);
+		int last_y = min(tetromino.pivot_position.y - extents.min_y, BOARD_HEIGHT - 1);
+		int lowest_full_y = -1;
+
+		for (int j = first_y; j <= last_y && lowest_full_y < 0; ++j)
+		{
+			lowest_full_y = is_board_row_full(&game_state->board, j) ? j : -1;
+		}
+
+		// Rows from the lowest full one up move down, their hashes are swapped for the new ones:
+		if (lowest_full_y >= 0)
+		{
+			game_state->board_hash ^= hash_board_rows(&game_state->board, lowest_full_y, BOARD_HEIGHT - 1);
+		}
+
+		cleared_rows = clear_full_board_rows_between(&game_state->board, first_y, last_y);
+
+		if (lowest_full_y >= 0)
+		{
+			game_state->board_hash ^= hash_board_rows(&game_state->board, lowest_full_y, BOARD_HEIGHT - 1);
+		}
+	}
+
+	for (size_t j = 0; j < BOARD_HEIGHT; ++j)
+	{
+		if ((cleared_rows & (1u << j)) == 0)
+		{
+			continue;
+		}
+
+		if (j < BOARD_HEIGHT_RENDERED)
+		{
+			game_state->tetromino_lines[j] = LINE_ANIMATION_TICKS;
+		}
+
+		line_count++;
+	}
+	
+	game_state->line_count += line_count;
+}
+
+void update_line_data(Game_State* game_state)
+{
+	for (size_t i = 0; i < BOARD_HEIGHT_RENDERED; i++)
+	{
+		if (game_state->tetromino_lines[i] > 0)
+		{
+			game_state->tetromino_lines[i]--;
+		}
+	}
+}
+
+void update_game_playing_phase(Game_State* game_state, Input_State* input_state)
+{
+	if (game_state->should_spawn_tetromino)
+	{
+		enum Tetromino_Type initial_tetromino_type = next_piece(&game_state->piece_queue);
+
+		TETRIS_LOG("Generated new tetromino of type: %i\n", initial_tetromino_type);
+
+		Vector2 spawn_position = {.x = SPAWN_POSITION_X, .y = SPAWN_POSITION_Y};
+
+		Tetromino new_tetromino = {
+			.pivot_position = spawn_position,
+			.rotation = 0,
+			.type = initial_tetromino_type,
+		};
+
+		// Set initial state:
+		game_state->current_tetromino = new_tetromino;
+		game_state->previous_tetromino_position = spawn_position;
+		game_state->previous_tetromino_rotation = 0;
+	}
+
+	// Update line related data if any line is currently active:
+	update_line_data(game_state);
+
+	// Parse input commands:
+	parse_input_state_playing_phase(game_state, input_state);
+
+	// If created new and in illegal cell after parsing input, go to game over state:
+	if (game_state->should_spawn_tetromino && !is_possible_movement(game_state, true))
+	{
+		game_state->game_phase = GAME_PHASE_GAMEOVER;
+		return;
+	}
+
+	// Kick or revert a rotation before gravity, so the fall starts from where the rotation ended:
+	move_tetromino_for_rotation(game_state);
+
+	// Gather gravity of this tick:
+	game_state->fall_progress += get_game_gravity(game_state);
+
+	// Board only holds locked cells, the tetromino has to be tested again only if anything about it changed:
+	bool changed_tetromino = has_current_tetromino_changed(game_state);
+	
+	// This flag is controlled by fall algorithm, which decides if the tetromino can fall any further:
+	bool cannot_fall = false;
+	
+	// Decide if fall will occur this time:
+	if (will_fall_this_turn(game_state))	
+	{	
+		// Try falling, get if fall was successfull:
+		cannot_fall = !tetromino_fall(game_state);
+	}
+
+	// Cache tetromino memory location:
+	Tetromino* current_tetromino = &(game_state->current_tetromino);
+
+	// Validate the new state of tetromino if it changed or this is a new tetromino:
+	if (changed_tetromino || game_state->should_spawn_tetromino)
+	{
+		// Clamp movement to avoid overflows or collisions:
+		clamp_movement(game_state);
+
+		// Determine final possible final destination for currently falling tetromino:
+		determine_current_destination(game_state);
+	}
+
+	// Hard drop, land on the destination and lock right away:
+	if (input_state->pressed_space && !cannot_fall)
+	{
+		TETRIS_LOG("--- Hard Drop ---\n");
+		current_tetromino->pivot_position.y = game_state->current_destination.y;
+		game_state->fall_progress = 0;
+		cannot_fall = true;
+	}
+
+	// Set previouses:
+	// These are highly used for validation of any movement.
+	game_state->previous_tetromino_position = current_tetromino->pivot_position;
+	game_state->previous_tetromino_rotation = current_tetromino->rotation;
+
+	// Set should_spawn_tetromino to cannot_fall so that new tetromino is spawned if the current one cannot fall any further:
+	game_state->should_spawn_tetromino = cannot_fall;
+
+	if (game_state->should_spawn_tetromino)
+	{
+		// Fill corresponding cells in board, the only time the board changes:
+		put_tetromino_to_board(game_state);
+
+		lock_current_tetromino(game_state);
+	}
+}
+
+void lock_current_tetromino(Game_State* game_state)
+{
+	// Get line count before destroying new ones,
+	// Destroy the lines if there are any,
+	// Calculate new lines destroyed this frame,
+	uint8_t new_line_count = game_state->line_count;
+	destroy_lines(game_state);
+	new_line_count = (game_state->line_count - new_line_count);
+
+	// Add score using new lines:
+	add_score(game_state, new_line_count);
+
+	// Check for game over condition:
+	check_game_over(game_state);
+
+	// Level up if requirements are met:
+	level_up(game_state);
+}
+
+void place_tetromino(Game_State* game_state, Tetromino tetromino)
+{
+	// Lands the falling tetromino at a placement right away and locks it there, as if it
+	// had been moved down to it. Used by search, the placement must be a resting one:
+	if (game_state->should_spawn_tetromino)
+	{
+		next_piece(&game_state->piece_queue);
+	}
+
+	game_state->current_tetromino = tetromino;
+	put_tetromino_to_board(game_state);
+
+	game_state->current_destination = tetromino.pivot_position;
+	game_state->previous_tetromino_position = tetromino.pivot_position;
+	game_state->previous_tetromino_rotation = tetromino.rotation;
+	game_state->fall_progress = 0;
+	game_state->should_spawn_tetromino = true;
+
+	lock_current_tetromino(game_state);
+}
+
+void update_game_gameover_phase(Game_State* game_state, Input_State* input_state)
+{
+	if (input_state->pressed_space)
+	{
+		// Reset game state, the next game is seeded from this game's generator and keeps its rules:
+		uint64_t seed = next_random(&game_state->piece_queue.random);
+		uint8_t rotation_system = game_state->rotation_system;
+		uint32_t fixed_gravity = game_state->fixed_gravity;
+		bool use_reference_board = game_state->use_reference_board;
+
+		initialize_game_state(game_state, seed, (enum Piece_Randomizer)game_state->piece_queue.randomizer);
+		game_state->rotation_system = rotation_system;
+		game_state->fixed_gravity = fixed_gravity;
+		game_state->use_reference_board = use_reference_board;
+	}
+}
+
+void update_game(Game_State* game_state, Input_State* input_state)
+{	
+	switch (game_state->game_phase)
+	{
+	case GAME_PHASE_PLAYING:
+		update_game_playing_phase(game_state, input_state);
+	break;
+	
+	case GAME_PHASE_GAMEOVER:
+		update_game_gameover_phase(game_state, input_state);
+	break;
+	}
+
+}
+
+void step_game(Game_State* game_state, Input_State* input_state)
+{
+	// Advance the game by one tick, the same input sequence always plays the same game:
+	update_game(game_state, input_state);
+
+	game_state->tick_count++;
+}
+
+void reset_game_clock(Game_Clock* game_clock)
+{
+	game_clock->accumulated_seconds = 0.0;
+	game_clock->turbo = false;
+}
+
+uint32_t advance_game_clock(Game_Clock* game_clock, double elapsed_seconds)
+{
+	// Turbo has no tick budget, the caller runs ticks until its frame time is used up:
+	if (game_clock->turbo)
+	{
+		game_clock->accumulated_seconds = 0.0;
+		return UINT32_MAX;
+	}
+
+	game_clock->accumulated_seconds += elapsed_seconds;
+
+	uint32_t tick_count = (uint32_t)(game_clock->accumulated_seconds * TICKS_PER_SECOND);
+
+	if (tick_count > MAX_TICKS_PER_FRAME)
+	{
+		// Drop the time we cannot catch up with:
+		game_clock->accumulated_seconds = 0.0;
+		return MAX_TICKS_PER_FRAME;
+	}
+
+	game_clock->accumulated_seconds -= (double)tick_count / TICKS_PER_SECOND;
+
+	return tick_count;
+}
+
+void initialize_game_state(Game_State* game_state, uint64_t seed, enum Piece_Randomizer randomizer)
+{
+	// Build shape tables of tetrominoes once:
+	initialize_tetromino_shapes();
+
+	// Clear board to empty cells:
+	clear_board(&game_state->board);
+	game_state->board_hash = 0;
+
+	// No line animations running:
+	memset(&game_state->tetromino_lines, 0, sizeof(game_state->tetromino_lines));
+
+	game_state->game_phase = GAME_PHASE_PLAYING;
+	game_state->should_spawn_tetromino = true;  
+
+	game_state->current_level = 0;
+	game_state->line_count = 0;
+	game_state->score = 0;
+	
+	// Tick clock and gravity of the level:
+	game_state->tick_count = 0;
+	game_state->fall_progress = 0;
+	game_state->fixed_gravity = 0;
+
+	game_state->current_destination = (Vector2) {.x = 0, .y = 0};
+
+	// Rotations push off the walls only, set rotation_system afterwards for another profile:
+	game_state->rotation_system = ROTATION_SYSTEM_SIMPLE;
+	game_state->use_reference_board = false;
+
+	// Pieces of this game come from its own generator:
+	seed_piece_queue(&game_state->piece_queue, seed, randomizer);
+}
+
+void save_game_snapshot(const Game_State* game_state, Game_Snapshot* snapshot)
+{
+	snapshot->piece_queue = game_state->piece_queue;
+	snapshot->tick_count = game_state->tick_count;
+	snapshot->board_hash = game_state->board_hash;
+	snapshot->fall_progress = game_state->fall_progress;
+	snapshot->fixed_gravity = game_state->fixed_gravity;
+	snapshot->line_count = game_state->line_count;
+	snapshot->score = game_state->score;
+	snapshot->current_tetromino = game_state->current_tetromino;
+	snapshot->current_destination = game_state->current_destination;
+	snapshot->previous_tetromino_position = game_state->previous_tetromino_position;
+	snapshot->board = game_state->board;
+	snapshot->previous_tetromino_rotation = game_state->previous_tetromino_rotation;
+	snapshot->current_level = game_state->current_level;
+	snapshot->rotation_system = game_state->rotation_system;
+	snapshot->game_phase = (uint8_t)game_state->game_phase;
+	snapshot->should_spawn_tetromino = game_state->should_spawn_tetromino;
+}
+
+void restore_game_snapshot(Game_State* game_state, const Game_Snapshot* snapshot)
+{
+	game_state->piece_queue = snapshot->piece_queue;
+	game_state->tick_count = snapshot->tick_count;
+	game_state->board_hash = snapshot->board_hash;
+	game_state->fall_progress = snapshot->fall_progress;
+	game_state->fixed_gravity = snapshot->fixed_gravity;
+	game_state->line_count = snapshot->line_count;
+	game_state->score = snapshot->score;
+	game_state->current_tetromino = snapshot->current_tetromino;
+	game_state->current_destination = snapshot->current_destination;
+	game_state->previous_tetromino_position = snapshot->previous_tetromino_position;
+	game_state->board = snapshot->board;
+	game_state->previous_tetromino_rotation = snapshot->previous_tetromino_rotation;
+	game_state->current_level = snapshot->current_level;
+	game_state->rotation_system = snapshot->rotation_system;
+	game_state->game_phase = (enum Game_Phase)snapshot->game_phase;
+	game_state->should_spawn_tetromino = snapshot->should_spawn_tetromino;
+
+	// Snapshots do not keep animations, a restored game starts without any:
+	memset(&game_state->tetromino_lines, 0, sizeof(game_state->tetromino_lines));
+}
+
+void fork_game_state(Game_State* destination, const Game_State* source)
+{
+	// Writes over storage the caller already owns, nothing is allocated:
+	*destination = *source;
+}
+
+void reset_input_state(Input_State* input_state)
+{
+	input_state->pressed_down = false;
+	input_state->pressed_left = false;
+	input_state->pressed_right = false;
+	input_state->pressed_up = false;
+	input_state->pressed_space = false;
+}
+
+void parse_input_state_playing_phase(Game_State* game_state, Input_State* input_state)
+{
+	if (input_state->pressed_right)
+	{
+		TETRIS_LOG("INPUT: Pressed right\n");
+		game_state->current_tetromino.pivot_position.x++;
+	}
+
+	if (input_state->pressed_left)
+	{
+		TETRIS_LOG("INPUT: Pressed left\n");
+		game_state->current_tetromino.pivot_position.x--;
+	}
+
+	if (input_state->pressed_up)
+	{
+		TETRIS_LOG("INPUT: Pressed up\n");
+		game_state->current_tetromino.rotation = (game_state->current_tetromino.rotation + 1) % TETROMINO_ROTATION_COUNT;
+	}
+
+	if (input_state->pressed_down)
+	{
+		TETRIS_LOG("INPUT: Pressed down\n");
+		// game_state->current_tetromino.rotation = (game_state->current_tetromino.rotation - 1 + TETROMINO_ROTATION_COUNT) % TETROMINO_ROTATION_COUNT;
+		game_state->current_tetromino.pivot_position.y--;
+	}
+
+	if (input_state->pressed_space)
+	{
+		TETRIS_LOG("INPUT: Pressed space\n");
+	}
+}
@@ -0,0 +1,161 @@
+#ifndef TETRIS_CORE_H
+#define TETRIS_CORE_H
+
+// Gameplay of the game without any SDL dependency, so it can be stepped headless.
+
+#include "tetris_util.h"
+#include "tetris_board.h"
+#include "tetris_random.h"
+#include "tetris_rotation.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <math.h>
+
+// Console logging of gameplay events, compiled out unless TETRIS_ENABLE_LOG is defined:
+#ifdef TETRIS_ENABLE_LOG
+#define TETRIS_LOG(...) printf(__VA_ARGS__)
+#else
+#define TETRIS_LOG(...) do { if (0) printf(__VA_ARGS__); } while (0)
+#endif
+
+#define TICKS_PER_SECOND 60
+#define SPAWN_POSITION_X 4
+#define SPAWN_POSITION_Y 20
+
+// Cleared lines fade out over 0.2 seconds:
+#define LINE_ANIMATION_TICKS (TICKS_PER_SECOND / 5)
+// Most ticks a real-time clock runs per frame, so a stall does not snowball into more stalls:
+#define MAX_TICKS_PER_FRAME 8
+
+// Gravity is rows per tick in fixed point, 24 fraction bits leave room for up to 255 rows per tick:
+#define GRAVITY_FRACTION_BITS 24
+#define GRAVITY_ONE_ROW ((uint32_t)1 << GRAVITY_FRACTION_BITS)
+#define GRAVITY_FRACTION_MASK (GRAVITY_ONE_ROW - 1)
+// A whole board per tick, pieces land on the tick they spawn:
+#define GRAVITY_20G (20 * GRAVITY_ONE_ROW)
+
+enum Game_Phase
+{	
+	GAME_PHASE_PLAYING,
+	GAME_PHASE_GAMEOVER,
+};
+
+// Input_State packed into bits, for engines that store input compactly:
+enum Input_Flag
+{
+	INPUT_FLAG_LEFT = 1 << 0,
+	INPUT_FLAG_RIGHT = 1 << 1,
+	INPUT_FLAG_UP = 1 << 2,
+	INPUT_FLAG_DOWN = 1 << 3,
+	INPUT_FLAG_SPACE = 1 << 4,
+};
+
+typedef struct Input_State
+{
+	bool pressed_left;
+	bool pressed_right;
+	bool pressed_up;
+	bool pressed_down; 
+	bool pressed_space;
+} Input_State;
+
+typedef struct Game_State
+{
+	// Locked cells only, the falling tetromino is kept apart in current_tetromino:
+	Board board;
+	// hash_board_rows of the whole board, kept up to date as tetrominoes lock and lines clear:
+	uint64_t board_hash;
+	uint8_t previous_tetromino_rotation;
+	// Ticks played, gameplay never reads wall-clock time:
+	uint64_t tick_count;
+	// Rows of gravity gathered and not fallen yet, fixed point:
+	uint32_t fall_progress;
+	// Gravity used instead of the one of the level when not 0, fixed point:
+	uint32_t fixed_gravity;
+	enum Game_Phase game_phase;
+	bool should_spawn_tetromino;
+	Vector2 current_destination;
+	Vector2 previous_tetromino_position;
+	Tetromino current_tetromino;
+	uint32_t line_count;
+	uint32_t score;
+	uint8_t current_level;
+	// enum Rotation_System, what a rotation into a collision tries:
+	uint8_t rotation_system;
+	// Plays with the cell by cell reference functions of the board, to check the fast ones against:
+	bool use_reference_board;
+	Piece_Queue piece_queue;
+	// Ticks left of the animation of each cleared line:
+	uint8_t tetromino_lines[BOARD_HEIGHT_RENDERED];
+} Game_State;
+
+// Everything that decides how a game goes on, without the render-only line animations.
+// Fixed size and pointer free, ordered by size so there is no padding in between:
+typedef struct Game_Snapshot
+{
+	Piece_Queue piece_queue;
+	uint64_t tick_count;
+	uint64_t board_hash;
+	uint32_t fall_progress;
+	uint32_t fixed_gravity;
+	uint32_t line_count;
+	uint32_t score;
+	Tetromino current_tetromino;
+	Vector2 current_destination;
+	Vector2 previous_tetromino_position;
+	Board board;
+	uint8_t previous_tetromino_rotation;
+	uint8_t current_level;
+	uint8_t rotation_system;
+	uint8_t game_phase;
+	bool should_spawn_tetromino;
+} Game_Snapshot;
+
+// Turns wall-clock time into whole ticks for real-time front-ends:
+typedef struct Game_Clock
+{
+	double accumulated_seconds;
+	// Runs ticks as fast as the caller can, instead of TICKS_PER_SECOND:
+	bool turbo;
+} Game_Clock;
+
+// Utils ------------------------
+Extents find_extents_of_tetromino(Tetromino);
+uint32_t get_gravity(uint8_t);
+uint32_t get_game_gravity(const Game_State*);
+uint32_t get_score_for_lines(uint8_t, uint8_t);
+uint8_t get_input_flags(const Input_State*);
+uint64_t get_game_hash(const Game_State*);
+void set_input_flags(Input_State*, uint8_t);
+// ------------------------------
+
+// Gameplay ---------------------
+bool is_possible_movement(Game_State*, bool);
+void clamp_movement(Game_State*);
+void put_tetromino_to_board(Game_State*);
+bool is_tetromino_falling(const Game_State*);
+void move_tetromino_for_rotation(Game_State*);
+bool has_current_tetromino_changed(Game_State*);
+bool tetromino_fall(Game_State*);
+void determine_current_destination(Game_State*);
+void check_game_over(Game_State*);
+void destroy_lines(Game_State*);
+void update_line_data(Game_State*);
+void lock_current_tetromino(Game_State*);
+void place_tetromino(Game_State*, Tetromino);
+void update_game_playing_phase(Game_State*, Input_State*);
+void update_game_gameover_phase(Game_State*, Input_State*);
+void update_game(Game_State*, Input_State*);
+void step_game(Game_State*, Input_State*);
+void reset_game_clock(Game_Clock*);
+uint32_t advance_game_clock(Game_Clock*, double);
+void initialize_game_state(Game_State*, uint64_t, enum Piece_Randomizer);
+void save_game_snapshot(const Game_State*, Game_Snapshot*);
+void restore_game_snapshot(Game_State*, const Game_Snapshot*);
+void fork_game_state(Game_State*, const Game_State*);
+void reset_input_state(Input_State*);
+void parse_input_state_playing_phase(Game_State*, Input_State*);
+// ------------------------------
+
+#endif
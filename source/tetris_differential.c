@@ -0,0 +1,499 @@
+/* ISMET BARAN SURUCU -- github.com/baransrc */
+#include "tetris_differential.h"
+#include "tetris_batch.h"
+#include "tetris_moves.h"
+#include "tetris_runner.h"
+#include "tetris_platform.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define DIFFERENTIAL_NO_GAME UINT64_MAX
+// Chance out of 10 of each input on a random tick, the rest of them have none:
+#define DIFFERENTIAL_INPUT_RANGE 10
+// One in this many ticks takes random input instead of the path:
+#define DIFFERENTIAL_RANDOM_TICK_ODDS 64
+// One in this many pieces goes to a random placement instead of the best one:
+#define DIFFERENTIAL_RANDOM_PLACEMENT_ODDS 16
+// One in this many games starts at any level, the others at one of the first levels:
+#define DIFFERENTIAL_ANY_LEVEL_ODDS 4
+#define DIFFERENTIAL_LOW_LEVEL_COUNT 10
+
+enum Differential_Engine
+{
+	DIFFERENTIAL_ENGINE_FAST,
+	DIFFERENTIAL_ENGINE_BATCH_SIMD,
+	DIFFERENTIAL_ENGINE_BATCH_SCALAR,
+	DIFFERENTIAL_ENGINE_COUNT
+};
+
+static const char* DIFFERENTIAL_ENGINE_NAMES[DIFFERENTIAL_ENGINE_COUNT] = {"game state", "batch (simd)", "batch (scalar)"};
+
+typedef struct Differential_Lane
+{
+	uint64_t game;
+	uint64_t tick;
+	Random_State input_random;
+	// Whether the batch engine plays the rules of this game:
+	bool in_batch;
+	// Inputs to the placement picked for the falling piece, a hard drop once they run out:
+	uint32_t path_length;
+	uint32_t path_index;
+	uint8_t path[DIFFERENTIAL_MAX_PATH_LENGTH];
+	Game_State reference;
+	Game_State fast;
+} Differential_Lane;
+
+typedef struct Differential_Worker
+{
+	const Differential_Config* config;
+	volatile int64_t* next_game;
+	Differential_Lane* lanes;
+	Batch_Engine batches[2];
+	Move_Generator* generator;
+	uint8_t* inputs;
+	Differential_Result result;
+	Thread thread;
+} Differential_Worker;
+
+// Internal ---------------------
+static const char* compare_batch_lane(const Batch_Engine*, uint32_t, const Game_State*);
+static bool start_lane_game(Differential_Worker*, uint32_t);
+static uint32_t evaluate_placement(const Board*, Tetromino);
+static void plan_lane_placement(Differential_Worker*, Differential_Lane*);
+static uint8_t get_lane_input(Differential_Worker*, Differential_Lane*);
+static void report_mismatch(Differential_Worker*, const Differential_Lane*, enum Differential_Engine, const char*);
+static void run_differential_worker(void*);
+static Tetromino rotate_with_gravity(Tetromino, enum Rotation_System, uint32_t);
+// ------------------------------
+
+const char* compare_game_states(const Game_State* a, const Game_State* b)
+{
+	// Name of the first field that differs, NULL if the games are the same. Boards are compared
+	// field by field, so padding never counts:
+	if (memcmp(a->board.rows, b->board.rows, sizeof(a->board.rows)) != 0) return "board rows";
+	if (memcmp(a->board.columns, b->board.columns, sizeof(a->board.columns)) != 0) return "board columns";
+	if (memcmp(a->board.colors, b->board.colors, sizeof(a->board.colors)) != 0) return "board colors";
+	if (memcmp(a->board.row_counts, b->board.row_counts, sizeof(a->board.row_counts)) != 0) return "row counts";
+	if (memcmp(a->board.column_heights, b->board.column_heights, sizeof(a->board.column_heights)) != 0) return "column heights";
+	if (memcmp(a->board.column_holes, b->board.column_holes, sizeof(a->board.column_holes)) != 0) return "column holes";
+	if (memcmp(a->board.well_depths, b->board.well_depths, sizeof(a->board.well_depths)) != 0) return "well depths";
+	if (a->board.hole_count != b->board.hole_count) return "hole count";
+	if (a->board_hash != b->board_hash) return "board hash";
+	if (a->game_phase != b->game_phase) return "game phase";
+	if (a->should_spawn_tetromino != b->should_spawn_tetromino) return "spawn";
+	if (memcmp(&a->current_tetromino.pivot_position, &b->current_tetromino.pivot_position, sizeof(Vector2)) != 0) return "tetromino position";
+	if (a->current_tetromino.rotation != b->current_tetromino.rotation) return "tetromino rotation";
+	if (a->current_tetromino.type != b->current_tetromino.type) return "tetromino type";
+	if (memcmp(&a->current_destination, &b->current_destination, sizeof(Vector2)) != 0) return "destination";
+	if (memcmp(&a->previous_tetromino_position, &b->previous_tetromino_position, sizeof(Vector2)) != 0) return "previous position";
+	if (a->previous_tetromino_rotation != b->previous_tetromino_rotation) return "previous rotation";
+	if (a->fall_progress != b->fall_progress) return "fall progress";
+	if (a->tick_count != b->tick_count) return "tick count";
+	if (a->line_count != b->line_count) return "line count";
+	if (a->score != b->score) return "score";
+	if (a->current_level != b->current_level) return "level";
+	if (memcmp(&a->piece_queue.random, &b->piece_queue.random, sizeof(Random_State)) != 0) return "generator";
+	if (memcmp(a->piece_queue.pieces, b->piece_queue.pieces, PIECE_QUEUE_SIZE) != 0 || a->piece_queue.next != b->piece_queue.next) return "piece queue";
+	if (memcmp(a->tetromino_lines, b->tetromino_lines, sizeof(a->tetromino_lines)) != 0) return "line animations";
+
+	return NULL;
+}
+
+static const char* compare_batch_lane(const Batch_Engine* batch, uint32_t lane, const Game_State* game_state)
+{
+	// Lanes keep fewer fields, the piece only counts while it falls:
+	for (int j = 0; j < BOARD_HEIGHT; ++j)
+	{
+		if (batch->rows[lane][j + BATCH_ROW_OFFSET] != game_state->board.rows[j]) return "board rows";
+	}
+
+	if (batch->game_phase[lane] != (uint8_t)game_state->game_phase) return "game phase";
+	// Lanes that lost no longer spawn, the flag only means something while playing:
+	if (game_state->game_phase == GAME_PHASE_PLAYING && batch->should_spawn_tetromino[lane] != game_state->should_spawn_tetromino) return "spawn";
+
+	if (is_tetromino_falling(game_state))
+	{
+		if (batch->position_x[lane] != game_state->current_tetromino.pivot_position.x ||
+			batch->position_y[lane] != game_state->current_tetromino.pivot_position.y) return "tetromino position";
+		if (batch->rotation[lane] != game_state->current_tetromino.rotation) return "tetromino rotation";
+		if (batch->type[lane] != (uint8_t)game_state->current_tetromino.type) return "tetromino type";
+	}
+
+	if (batch->fall_progress[lane] != game_state->fall_progress) return "fall progress";
+	if (batch->line_count[lane] != game_state->line_count) return "line count";
+	if (batch->score[lane] != game_state->score) return "score";
+	if (batch->current_level[lane] != game_state->current_level) return "level";
+	if (memcmp(&batch->piece_queue[lane].random, &game_state->piece_queue.random, sizeof(Random_State)) != 0) return "generator";
+	if (batch->piece_queue[lane].next != game_state->piece_queue.next) return "piece queue";
+
+	return NULL;
+}
+
+static bool start_lane_game(Differential_Worker* worker, uint32_t lane_index)
+{
+	Differential_Lane* lane = &worker->lanes[lane_index];
+	int64_t game = atomic_fetch_add_64(worker->next_game, 1);
+
+	if (game >= (int64_t)worker->config->game_count)
+	{
+		lane->game = DIFFERENTIAL_NO_GAME;
+		return false;
+	}
+
+	uint64_t seed = get_game_seed(worker->config->seed, (uint64_t)game);
+
+	lane->game = (uint64_t)game;
+	lane->tick = 0;
+	seed_random(&lane->input_random, seed);
+	jump_random(&lane->input_random);
+
+	lane->path_length = 0;
+	lane->path_index = 0;
+
+	// Rules by game: a quarter play SRS, a quarter 20G, the rest what the batch engine plays.
+	// Games alternate randomizers and mostly start at low levels, so they last long enough
+	// to clear lines and level up:
+	bool any_level = random_below(&lane->input_random, DIFFERENTIAL_ANY_LEVEL_ODDS) == 0;
+
+	initialize_game_state(&lane->reference, seed, (enum Piece_Randomizer)(game & 1));
+	lane->reference.current_level = (uint8_t)random_below(&lane->input_random, any_level ? LEVEL_COUNT : DIFFERENTIAL_LOW_LEVEL_COUNT);
+	lane->reference.rotation_system = ((game & 3) == 2) ? ROTATION_SYSTEM_SRS : ROTATION_SYSTEM_SIMPLE;
+	lane->reference.fixed_gravity = ((game & 3) == 3) ? GRAVITY_20G : 0;
+	lane->in_batch = (game & 3) < 2;
+
+	fork_game_state(&lane->fast, &lane->reference);
+	lane->reference.use_reference_board = true;
+
+	for (int i = 0; i < 2; ++i)
+	{
+		load_batch_lane(&worker->batches[i], lane_index, &lane->fast);
+	}
+
+	worker->result.game_count++;
+
+	return true;
+}
+
+static uint32_t evaluate_placement(const Board* board, Tetromino tetromino)
+{
+	// Lower is better: holes, then height and bumps. Cleared lines lower the height:
+	Board placed = *board;
+
+	put_tetromino_cells(&placed, tetromino);
+	clear_full_board_rows(&placed);
+
+	uint32_t value = 32 * placed.hole_count;
+
+	for (int i = 0; i < BOARD_WIDTH; ++i)
+	{
+		value += 2 * placed.column_heights[i];
+		value += (i > 0) ? abs(placed.column_heights[i] - placed.column_heights[i - 1]) : 0;
+	}
+
+	return value;
+}
+
+static void plan_lane_placement(Differential_Worker* worker, Differential_Lane* lane)
+{
+	// Called on the tick the next piece spawns, its path starts with that tick:
+	Move_Generator* generator = worker->generator;
+	uint32_t placement_count = generate_game_placements(generator, &lane->fast);
+
+	lane->path_length = 0;
+	lane->path_index = 0;
+
+	if (placement_count == 0)
+	{
+		return;
+	}
+
+	uint32_t best = random_below(&lane->input_random, placement_count);
+
+	if (random_below(&lane->input_random, DIFFERENTIAL_RANDOM_PLACEMENT_ODDS) != 0)
+	{
+		uint32_t best_value = UINT32_MAX;
+
+		for (uint32_t i = 0; i < placement_count; ++i)
+		{
+			uint32_t value = evaluate_placement(&lane->fast.board, get_placement(generator, i));
+
+			if (value < best_value)
+			{
+				best = i;
+				best_value = value;
+			}
+		}
+	}
+
+	uint32_t length = min(get_placement_path(generator, best, lane->path, DIFFERENTIAL_MAX_PATH_LENGTH), DIFFERENTIAL_MAX_PATH_LENGTH);
+
+	// A placement rests where it is, the drops that end its path are left to the hard drop:
+	while (length > 0 && lane->path[length - 1] == INPUT_FLAG_DOWN)
+	{
+		length--;
+	}
+
+	lane->path_length = length;
+}
+
+static uint8_t get_lane_input(Differential_Worker* worker, Differential_Lane* lane)
+{
+	if (lane->fast.game_phase == GAME_PHASE_PLAYING && lane->fast.should_spawn_tetromino)
+	{
+		plan_lane_placement(worker, lane);
+	}
+
+	uint8_t input = (lane->path_index < lane->path_length) ? lane->path[lane->path_index++] : (uint8_t)INPUT_FLAG_SPACE;
+
+	// Random input now and then moves pieces off their paths, into walls and the stack:
+	if (random_below(&lane->input_random, DIFFERENTIAL_RANDOM_TICK_ODDS) == 0)
+	{
+		uint32_t choice = random_below(&lane->input_random, DIFFERENTIAL_INPUT_RANGE);
+
+		input = (choice < 5) ? (uint8_t)(1 << choice) : 0;
+	}
+
+	return input;
+}
+
+static void report_mismatch(Differential_Worker* worker, const Differential_Lane* lane, enum Differential_Engine engine, const char* field)
+{
+	Differential_Result* result = &worker->result;
+
+	if (result->mismatch_count++ == 0 || lane->game < result->mismatch_game)
+	{
+		result->mismatch_game = lane->game;
+		result->mismatch_tick = lane->tick;
+		result->mismatch_engine = DIFFERENTIAL_ENGINE_NAMES[engine];
+		result->mismatch_field = field;
+	}
+}
+
+static void run_differential_worker(void* argument)
+{
+	Differential_Worker* worker = (Differential_Worker*)argument;
+	uint32_t lane_count = worker->config->lane_count;
+	uint32_t active_count = 0;
+
+	for (uint32_t i = 0; i < lane_count; ++i)
+	{
+		active_count += start_lane_game(worker, i);
+	}
+
+	while (active_count > 0)
+	{
+		Input_State input_state;
+
+		for (uint32_t i = 0; i < lane_count; ++i)
+		{
+			Differential_Lane* lane = &worker->lanes[i];
+			uint8_t input = 0;
+
+			if (lane->game != DIFFERENTIAL_NO_GAME)
+			{
+				uint32_t line_count = lane->reference.line_count;
+				uint8_t level = lane->reference.current_level;
+
+				input = get_lane_input(worker, lane);
+				set_input_flags(&input_state, input);
+				step_game(&lane->reference, &input_state);
+				set_input_flags(&input_state, input);
+				step_game(&lane->fast, &input_state);
+				lane->tick++;
+
+				worker->result.line_count += lane->reference.line_count - line_count;
+				worker->result.level_up_count += lane->reference.current_level - level;
+			}
+
+			worker->inputs[i] = input;
+		}
+
+		step_batch_engine(&worker->batches[0], worker->inputs);
+		step_batch_engine(&worker->batches[1], worker->inputs);
+
+		for (uint32_t i = 0; i < lane_count; ++i)
+		{
+			Differential_Lane* lane = &worker->lanes[i];
+
+			if (lane->game == DIFFERENTIAL_NO_GAME)
+			{
+				continue;
+			}
+
+			const char* field = compare_game_states(&lane->reference, &lane->fast);
+			enum Differential_Engine engine = DIFFERENTIAL_ENGINE_FAST;
+
+			for (int j = 0; j < 2 && field == NULL && lane->in_batch; ++j)
+			{
+				field = compare_batch_lane(&worker->batches[j], i, &lane->reference);
+				engine = (enum Differential_Engine)(DIFFERENTIAL_ENGINE_BATCH_SIMD + j);
+			}
+
+			worker->result.tick_count++;
+
+			if (field != NULL)
+			{
+				report_mismatch(worker, lane, engine, field);
+			}
+
+			// A game that no longer matches has nothing more to show, the next one starts:
+			if (field != NULL || lane->reference.game_phase == GAME_PHASE_GAMEOVER || lane->tick >= DIFFERENTIAL_MAX_GAME_TICKS)
+			{
+				active_count -= !start_lane_game(worker, i);
+			}
+		}
+	}
+}
+
+bool run_differential_check(const Differential_Config* config, Differential_Result* result)
+{
+	Differential_Config worker_config = *config;
+	volatile int64_t next_game = 0;
+	bool success = true;
+
+	worker_config.thread_count = max(config->thread_count, 1);
+	worker_config.lane_count = max(config->lane_count, 1);
+
+	memset(result, 0, sizeof(*result));
+	result->mismatch_game = DIFFERENTIAL_NO_GAME;
+
+	Differential_Worker* workers = calloc(worker_config.thread_count, sizeof(Differential_Worker));
+
+	if (workers == NULL)
+	{
+		return false;
+	}
+
+	for (uint32_t i = 0; i < worker_config.thread_count && success; ++i)
+	{
+		Differential_Worker* worker = &workers[i];
+
+		worker->config = &worker_config;
+		worker->next_game = &next_game;
+		worker->lanes = allocate_aligned(CACHE_LINE_SIZE, worker_config.lane_count * sizeof(Differential_Lane));
+		worker->inputs = calloc(worker_config.lane_count, 1);
+		worker->generator = malloc(sizeof(Move_Generator));
+		success = worker->lanes != NULL && worker->inputs != NULL && worker->generator != NULL &&
+				  create_batch_engine(&worker->batches[0], worker_config.lane_count) &&
+				  create_batch_engine(&worker->batches[1], worker_config.lane_count);
+
+		// The same lanes once with the SIMD kernels and once without:
+		worker->batches[0].use_simd = true;
+		worker->batches[1].use_simd = false;
+	}
+
+	double start = get_time_in_seconds();
+	uint32_t started_count = 0;
+
+	for (; success && started_count < worker_config.thread_count; ++started_count)
+	{
+		if (!create_thread(&workers[started_count].thread, run_differential_worker, &workers[started_count]))
+		{
+			success = false;
+			break;
+		}
+	}
+
+	for (uint32_t i = 0; i < started_count; ++i)
+	{
+		join_thread(&workers[i].thread);
+	}
+
+	result->seconds = get_time_in_seconds() - start;
+
+	for (uint32_t i = 0; i < worker_config.thread_count; ++i)
+	{
+		Differential_Result* worker_result = &workers[i].result;
+
+		result->game_count += worker_result->game_count;
+		result->tick_count += worker_result->tick_count;
+		result->line_count += worker_result->line_count;
+		result->level_up_count += worker_result->level_up_count;
+		result->mismatch_count += worker_result->mismatch_count;
+
+		if (worker_result->mismatch_count > 0 && worker_result->mismatch_game < result->mismatch_game)
+		{
+			result->mismatch_game = worker_result->mismatch_game;
+			result->mismatch_tick = worker_result->mismatch_tick;
+			result->mismatch_engine = worker_result->mismatch_engine;
+			result->mismatch_field = worker_result->mismatch_field;
+		}
+
+		if (workers[i].batches[0].memory != NULL)
+		{
+			destroy_batch_engine(&workers[i].batches[0]);
+		}
+
+		if (workers[i].batches[1].memory != NULL)
+		{
+			destroy_batch_engine(&workers[i].batches[1]);
+		}
+
+		free_aligned(workers[i].lanes);
+		free(workers[i].inputs);
+		free(workers[i].generator);
+	}
+
+	free(workers);
+
+	return success;
+}
+
+static Tetromino rotate_with_gravity(Tetromino tetromino, enum Rotation_System rotation_system, uint32_t gravity)
+{
+	// One tick with up pressed, starting with no gravity gathered:
+	Game_State game_state;
+	Input_State input_state;
+
+	initialize_game_state(&game_state, 1, PIECE_RANDOMIZER_UNIFORM);
+	game_state.rotation_system = (uint8_t)rotation_system;
+	game_state.fixed_gravity = gravity;
+	game_state.should_spawn_tetromino = false;
+	game_state.current_tetromino = tetromino;
+	game_state.previous_tetromino_position = tetromino.pivot_position;
+	game_state.previous_tetromino_rotation = tetromino.rotation;
+
+	reset_input_state(&input_state);
+	input_state.pressed_up = true;
+	step_game(&game_state, &input_state);
+
+	return game_state.current_tetromino;
+}
+
+uint32_t check_kicks_under_gravity(enum Rotation_System rotation_system, uint32_t gravity, uint32_t* kick_count)
+{
+	// Every piece and rotation against both walls of an empty board is turned once on a tick where
+	// gravity does not fire and once where it does. Both must end in the same column and rotation:
+	uint32_t mismatch_count = 0;
+
+	*kick_count = 0;
+
+	for (int type = 0; type < TETROMINO_TYPE_COUNT; ++type)
+	{
+		for (uint8_t rotation = 0; rotation < TETROMINO_ROTATION_COUNT; ++rotation)
+		{
+			Tetromino tetromino = {.pivot_position = {.x = 0, .y = DIFFERENTIAL_KICK_Y}, .rotation = rotation, .type = (enum Tetromino_Type)type};
+			Extents extents = get_tetromino_shape(tetromino)->extents;
+			int16_t wall_positions[2] = {(int16_t)-extents.min_x, (int16_t)((BOARD_WIDTH - 1) - extents.max_x)};
+
+			for (int i = 0; i < 2; ++i)
+			{
+				tetromino.pivot_position.x = wall_positions[i];
+
+				// Gravity too small to fire on the first tick:
+				Tetromino still = rotate_with_gravity(tetromino, rotation_system, 1);
+				Tetromino falling = rotate_with_gravity(tetromino, rotation_system, gravity);
+
+				// Kicks counted where gravity fires, so none counted means none survived it:
+				*kick_count += (falling.rotation != tetromino.rotation && falling.pivot_position.x != tetromino.pivot_position.x);
+
+				if (still.pivot_position.x != falling.pivot_position.x || still.rotation != falling.rotation)
+				{
+					mismatch_count++;
+				}
+			}
+		}
+	}
+
+	return mismatch_count;
+}
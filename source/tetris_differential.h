@@ -0,0 +1,53 @@
+#ifndef TETRIS_DIFFERENTIAL_H
+#define TETRIS_DIFFERENTIAL_H
+
+// Plays the same games with the same input on every engine and compares them after every tick.
+// Input mostly plays the placement a small evaluator picks, so games clear lines and level up,
+// with random placements and random input mixed in. A Game_State with use_reference_board, which tests cells one by one, is the
+// reference; the fast Game_State and both kernels of the batch engine are checked against it.
+// Batch lanes only play the simple rotation system at the gravity of their level, so games with
+// other rules are only played by the two Game_State engines.
+
+#include "tetris_core.h"
+#include "tetris_rotation.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define DIFFERENTIAL_DEFAULT_LANE_COUNT 16
+// Keeps a game that plays well from running forever:
+#define DIFFERENTIAL_MAX_GAME_TICKS 200000
+// Longest placement path played, longer ones are cut and hard dropped:
+#define DIFFERENTIAL_MAX_PATH_LENGTH 256
+// Row the pieces of check_kicks_under_gravity turn on, high enough that one row of gravity keeps them falling:
+#define DIFFERENTIAL_KICK_Y 10
+
+typedef struct Differential_Config
+{
+	uint64_t game_count;
+	uint64_t seed;
+	uint32_t thread_count;
+	// Games every thread plays side by side, one batch lane each:
+	uint32_t lane_count;
+} Differential_Config;
+
+typedef struct Differential_Result
+{
+	uint64_t game_count;
+	uint64_t tick_count;
+	// Lines cleared and levels gained by the reference, what the line clear paths were checked on:
+	uint64_t line_count;
+	uint64_t level_up_count;
+	uint64_t mismatch_count;
+	// Lowest game that did not match, which engine and what differed first:
+	uint64_t mismatch_game;
+	uint64_t mismatch_tick;
+	const char* mismatch_engine;
+	const char* mismatch_field;
+	double seconds;
+} Differential_Result;
+
+const char* compare_game_states(const Game_State*, const Game_State*);
+bool run_differential_check(const Differential_Config*, Differential_Result*);
+uint32_t check_kicks_under_gravity(enum Rotation_System, uint32_t, uint32_t*);
+
+#endif
@@ -0,0 +1,389 @@
+/* ISMET BARAN SURUCU -- github.com/baransrc */
+#include "tetris_moves.h"
+#include <string.h>
+
+#define MOVE_INPUT_COUNT 11
+
+typedef struct Canonical_Rotation
+{
+	// Lowest rotation covering the same cells, and how far its pivot is moved:
+	uint8_t rotation;
+	int8_t offset_x;
+	int8_t offset_y;
+} Canonical_Rotation;
+
+// Every input of one tick that moves the piece. Left with right cancels out, so it is left out:
+static const uint8_t MOVE_INPUTS[MOVE_INPUT_COUNT] = {
+	INPUT_FLAG_LEFT,
+	INPUT_FLAG_RIGHT,
+	INPUT_FLAG_UP,
+	INPUT_FLAG_DOWN,
+	INPUT_FLAG_LEFT | INPUT_FLAG_UP,
+	INPUT_FLAG_RIGHT | INPUT_FLAG_UP,
+	INPUT_FLAG_LEFT | INPUT_FLAG_DOWN,
+	INPUT_FLAG_RIGHT | INPUT_FLAG_DOWN,
+	INPUT_FLAG_UP | INPUT_FLAG_DOWN,
+	INPUT_FLAG_LEFT | INPUT_FLAG_UP | INPUT_FLAG_DOWN,
+	INPUT_FLAG_RIGHT | INPUT_FLAG_UP | INPUT_FLAG_DOWN,
+};
+
+static Canonical_Rotation CANONICAL_ROTATIONS[TETROMINO_TYPE_COUNT][TETROMINO_ROTATION_COUNT];
+static bool move_tables_initialized = false;
+
+// Internal ---------------------
+static inline uint16_t get_state_index(int, int, int);
+static inline Tetromino get_state_tetromino(uint16_t, enum Tetromino_Type);
+static inline bool is_state_bit_set(const uint64_t*, uint16_t);
+static inline void set_state_bit(uint64_t*, uint16_t);
+static uint32_t get_normalized_cells(const Tetromino_Shape*, int*, int*);
+static uint32_t build_collision_column(const Board*, enum Tetromino_Type, int, int);
+static inline bool does_state_collide(Move_Generator*, Tetromino);
+static bool try_move(Move_Generator*, Tetromino, uint8_t, Tetromino*);
+static void add_placement(Move_Generator*, uint16_t, Tetromino);
+// ------------------------------
+
+static inline uint16_t get_state_index(int x, int y, int rotation)
+{
+	return (uint16_t)((((y - MOVE_MIN_Y) * MOVE_X_COUNT) + (x - MOVE_MIN_X)) * TETROMINO_ROTATION_COUNT + rotation);
+}
+
+static inline Tetromino get_state_tetromino(uint16_t state, enum Tetromino_Type type)
+{
+	Tetromino tetromino;
+
+	tetromino.rotation = state % TETROMINO_ROTATION_COUNT;
+	tetromino.pivot_position.x = (int16_t)((state / TETROMINO_ROTATION_COUNT) % MOVE_X_COUNT + MOVE_MIN_X);
+	tetromino.pivot_position.y = (int16_t)(state / (TETROMINO_ROTATION_COUNT * MOVE_X_COUNT) + MOVE_MIN_Y);
+	tetromino.type = type;
+
+	return tetromino;
+}
+
+static inline bool is_state_bit_set(const uint64_t* bits, uint16_t state)
+{
+	return (bits[state >> 6] >> (state & 63)) & 1;
+}
+
+static inline void set_state_bit(uint64_t* bits, uint16_t state)
+{
+	bits[state >> 6] |= 1ull << (state & 63);
+}
+
+static uint32_t get_normalized_cells(const Tetromino_Shape* shape, int* min_x, int* min_y)
+{
+	uint32_t cells = 0;
+
+	*min_x = shape->extents.min_x;
+	*min_y = shape->extents.min_y;
+
+	// Cells moved to the top left corner of the 5x5 definition, one bit each:
+	for (size_t i = 0; i < TETROMINO_CELL_COUNT; ++i)
+	{
+		int x = shape->cells[i].x - *min_x;
+		int y = shape->cells[i].y - *min_y;
+
+		cells |= 1u << (y * MAX_TETROMINO_WIDTH + x);
+	}
+
+	return cells;
+}
+
+void initialize_move_tables(void)
+{
+	if (move_tables_initialized)
+	{
+		return;
+	}
+
+	initialize_tetromino_shapes();
+
+	for (size_t type = 0; type < TETROMINO_TYPE_COUNT; ++type)
+	{
+		for (size_t rotation = 0; rotation < TETROMINO_ROTATION_COUNT; ++rotation)
+		{
+			int min_x, min_y;
+			uint32_t cells = get_normalized_cells(&TETROMINO_SHAPES[type][rotation], &min_x, &min_y);
+			Canonical_Rotation canonical = {.rotation = (uint8_t)rotation, .offset_x = 0, .offset_y = 0};
+
+			for (size_t other = 0; other < rotation; ++other)
+			{
+				int other_min_x, other_min_y;
+
+				if (get_normalized_cells(&TETROMINO_SHAPES[type][other], &other_min_x, &other_min_y) != cells)
+				{
+					continue;
+				}
+
+				// Same cells on the board: pivot.x + min_x matches, and pivot.y - min_y matches:
+				canonical.rotation = (uint8_t)other;
+				canonical.offset_x = (int8_t)(min_x - other_min_x);
+				canonical.offset_y = (int8_t)(other_min_y - min_y);
+				break;
+			}
+
+			CANONICAL_ROTATIONS[type][rotation] = canonical;
+		}
+	}
+
+	move_tables_initialized = true;
+}
+
+static uint32_t build_collision_column(const Board* board, enum Tetromino_Type type, int rotation, int x)
+{
+	const Tetromino_Shape* shape = &TETROMINO_SHAPES[type][rotation];
+	// Same shift as does_tetromino_collide:
+	int shift = x - TETROMINO_PIVOT_X + BOARD_ROW_WALL_BITS;
+	uint32_t column = 0;
+
+	for (int j = shape->extents.min_y + TETROMINO_PIVOT_Y; j <= shape->extents.max_y + TETROMINO_PIVOT_Y; ++j)
+	{
+		uint32_t mask = shape->row_masks[j];
+		uint32_t row_mask;
+
+		if (shift >= 0)
+		{
+			row_mask = mask << shift;
+		}
+		else
+		{
+			if (mask & ((1u << -shift) - 1))
+			{
+				return UINT32_MAX;
+			}
+
+			row_mask = mask >> -shift;
+		}
+
+		if (row_mask & ~(uint32_t)BOARD_ROW_FULL)
+		{
+			return UINT32_MAX;
+		}
+
+		// Bit board_y set if this row of the tetromino hits board row board_y, rows above the board always hit:
+		uint32_t hits = ~((1u << BOARD_HEIGHT) - 1);
+
+		for (int board_y = 0; board_y < BOARD_HEIGHT; ++board_y)
+		{
+			hits |= (uint32_t)((board->rows[board_y] & row_mask) != 0) << board_y;
+		}
+
+		// This row sits at board_y = y - (j - TETROMINO_PIVOT_Y), bit of pivot y is y - MOVE_MIN_Y.
+		// Positions putting it below the board hit too:
+		int offset = j - TETROMINO_PIVOT_Y - MOVE_MIN_Y;
+
+		column |= (hits << offset) | ((1u << offset) - 1);
+	}
+
+	return column;
+}
+
+static inline bool does_state_collide(Move_Generator* generator, Tetromino tetromino)
+{
+	int x = tetromino.pivot_position.x - MOVE_MIN_X;
+	int y = tetromino.pivot_position.y - MOVE_MIN_Y;
+
+	if (x < 0 || x >= MOVE_X_COUNT || y < 0 || y >= MOVE_Y_COUNT)
+	{
+		return true;
+	}
+
+	int column_index = tetromino.rotation * MOVE_X_COUNT + x;
+
+	if ((generator->columns_built & (1ull << column_index)) == 0)
+	{
+		generator->columns[tetromino.rotation][x] = build_collision_column(&generator->board, generator->type, tetromino.rotation, tetromino.pivot_position.x);
+		generator->columns_built |= 1ull << column_index;
+	}
+
+	return (generator->columns[tetromino.rotation][x] >> y) & 1;
+}
+
+static bool try_move(Move_Generator* generator, Tetromino from, uint8_t input, Tetromino* to)
+{
+	Tetromino candidate = from;
+
+	candidate.pivot_position.x += ((input & INPUT_FLAG_RIGHT) ? 1 : 0) - ((input & INPUT_FLAG_LEFT) ? 1 : 0);
+	candidate.pivot_position.y -= (input & INPUT_FLAG_DOWN) ? 1 : 0;
+	candidate.rotation = (candidate.rotation + ((input & INPUT_FLAG_UP) ? 1 : 0)) % TETROMINO_ROTATION_COUNT;
+
+	bool is_turn = (candidate.rotation != from.rotation);
+
+	// Same as kick_rotated_tetromino, with the collision columns of the search. SRS turns go
+	// through the tests of the table only, the SRS I moves even when the plain turn fits:
+	if (!is_turn || generator->rotation_system == ROTATION_SYSTEM_SIMPLE)
+	{
+		if (!does_state_collide(generator, candidate))
+		{
+			*to = candidate;
+			return true;
+		}
+
+		if (!is_turn || !push_tetromino_inside_walls(&candidate) || does_state_collide(generator, candidate))
+		{
+			return false;
+		}
+
+		*to = candidate;
+		return true;
+	}
+
+	const Kick_Table* kick_table = get_kick_table(generator->rotation_system, candidate.type, from.rotation);
+
+	for (size_t i = 0; i < kick_table->kick_count; ++i)
+	{
+		Tetromino kicked = candidate;
+
+		kicked.pivot_position.x += kick_table->kicks[i].x;
+		kicked.pivot_position.y += kick_table->kicks[i].y;
+
+		if (!does_state_collide(generator, kicked))
+		{
+			*to = kicked;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void add_placement(Move_Generator* generator, uint16_t state, Tetromino tetromino)
+{
+	Canonical_Rotation canonical = CANONICAL_ROTATIONS[tetromino.type][tetromino.rotation];
+	uint16_t canonical_state = get_state_index(tetromino.pivot_position.x + canonical.offset_x, tetromino.pivot_position.y + canonical.offset_y, canonical.rotation);
+
+	if (is_state_bit_set(generator->placed, canonical_state) || generator->placement_count >= MAX_PLACEMENT_COUNT)
+	{
+		return;
+	}
+
+	set_state_bit(generator->placed, canonical_state);
+	generator->placements[generator->placement_count++] = state;
+}
+
+uint32_t generate_placements(Move_Generator* generator, const Board* board, Tetromino start, enum Rotation_System rotation_system)
+{
+	initialize_move_tables();
+
+	generator->board = *board;
+	generator->type = start.type;
+	generator->rotation_system = rotation_system;
+	generator->path_starts_with_spawn = false;
+	generator->columns_built = 0;
+	generator->state_count = 0;
+	generator->placement_count = 0;
+
+	memset(generator->visited, 0, sizeof(generator->visited));
+	memset(generator->placed, 0, sizeof(generator->placed));
+
+	if (does_state_collide(generator, start))
+	{
+		return 0;
+	}
+
+	uint16_t start_state = get_state_index(start.pivot_position.x, start.pivot_position.y, start.rotation);
+
+	set_state_bit(generator->visited, start_state);
+	generator->parents[start_state] = MOVE_NO_PARENT;
+	generator->states[generator->state_count++] = start_state;
+
+	for (uint32_t i = 0; i < generator->state_count; ++i)
+	{
+		uint16_t state = generator->states[i];
+		Tetromino tetromino = get_state_tetromino(state, start.type);
+
+		// Resting on something, the next fall locks it here:
+		Tetromino below = tetromino;
+		below.pivot_position.y--;
+
+		if (does_state_collide(generator, below))
+		{
+			add_placement(generator, state, tetromino);
+		}
+
+		for (size_t j = 0; j < MOVE_INPUT_COUNT; ++j)
+		{
+			Tetromino next;
+
+			if (!try_move(generator, tetromino, MOVE_INPUTS[j], &next))
+			{
+				continue;
+			}
+
+			uint16_t next_state = get_state_index(next.pivot_position.x, next.pivot_position.y, next.rotation);
+
+			if (is_state_bit_set(generator->visited, next_state))
+			{
+				continue;
+			}
+
+			set_state_bit(generator->visited, next_state);
+			generator->parents[next_state] = state;
+			generator->parent_inputs[next_state] = MOVE_INPUTS[j];
+			generator->states[generator->state_count++] = next_state;
+		}
+	}
+
+	return generator->placement_count;
+}
+
+uint32_t generate_game_placements(Move_Generator* generator, const Game_State* game_state)
+{
+	if (game_state->game_phase != GAME_PHASE_PLAYING)
+	{
+		generator->placement_count = 0;
+		return 0;
+	}
+
+	if (game_state->should_spawn_tetromino)
+	{
+		// Next piece taken from a copy, so the game's queue is left alone:
+		Piece_Queue piece_queue = game_state->piece_queue;
+		Tetromino spawn = {
+			.pivot_position = {.x = SPAWN_POSITION_X, .y = SPAWN_POSITION_Y},
+			.rotation = 0,
+			.type = next_piece(&piece_queue),
+		};
+
+		uint32_t placement_count = generate_placements(generator, &game_state->board, spawn, (enum Rotation_System)game_state->rotation_system);
+		generator->path_starts_with_spawn = true;
+
+		return placement_count;
+	}
+
+	return generate_placements(generator, &game_state->board, game_state->current_tetromino, (enum Rotation_System)game_state->rotation_system);
+}
+
+Tetromino get_placement(const Move_Generator* generator, uint32_t index)
+{
+	return get_state_tetromino(generator->placements[index], generator->type);
+}
+
+uint32_t get_placement_path(const Move_Generator* generator, uint32_t index, uint8_t* inputs, uint32_t max_input_count)
+{
+	// Input flags of each tick from the start to the placement, returns the full length even if it did not fit:
+	uint32_t length = generator->path_starts_with_spawn ? 1 : 0;
+
+	for (uint16_t state = generator->placements[index]; generator->parents[state] != MOVE_NO_PARENT; state = generator->parents[state])
+	{
+		length++;
+	}
+
+	uint32_t i = length;
+
+	for (uint16_t state = generator->placements[index]; generator->parents[state] != MOVE_NO_PARENT; state = generator->parents[state])
+	{
+		--i;
+
+		if (i < max_input_count)
+		{
+			inputs[i] = generator->parent_inputs[state];
+		}
+	}
+
+	if (generator->path_starts_with_spawn && max_input_count > 0)
+	{
+		inputs[0] = 0;
+	}
+
+	return length;
+}
@@ -0,0 +1,55 @@
+#ifndef TETRIS_MOVES_H
+#define TETRIS_MOVES_H
+
+// Lists every resting placement the falling tetromino can reach, with the inputs that get it
+// there. Moves follow update_game_playing_phase on ticks without a fall: a candidate that
+// collides is reverted, rotations that collide first try the kicks of the rotation system.
+// Gravity is left out, paths assume the piece is not forced down before they are done.
+
+#include "tetris_board.h"
+#include "tetris_core.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// Pivot positions of states, wide enough for every position whose cells are on the board:
+#define MOVE_MIN_X (-3)
+#define MOVE_MIN_Y (-2)
+#define MOVE_X_COUNT 16
+#define MOVE_Y_COUNT 32
+#define MOVE_STATE_COUNT (MOVE_X_COUNT * MOVE_Y_COUNT * TETROMINO_ROTATION_COUNT)
+#define MOVE_NO_PARENT UINT16_MAX
+#define MAX_PLACEMENT_COUNT 512
+
+typedef struct Move_Generator
+{
+	// Board without the falling tetromino:
+	Board board;
+	enum Tetromino_Type type;
+	enum Rotation_System rotation_system;
+	// The piece spawns on the first tick of every path:
+	bool path_starts_with_spawn;
+
+	// Collisions of every pivot y of one rotation and x as bits, built the first time they are needed:
+	uint64_t columns_built;
+	uint32_t columns[TETROMINO_ROTATION_COUNT][MOVE_X_COUNT];
+
+	// Breadth first search over (x, y, rotation), the queue doubles as the list of reached states:
+	uint32_t state_count;
+	uint16_t states[MOVE_STATE_COUNT];
+	uint16_t parents[MOVE_STATE_COUNT];
+	uint8_t parent_inputs[MOVE_STATE_COUNT];
+	uint64_t visited[MOVE_STATE_COUNT / 64];
+	// Resting states by canonical state, so symmetric rotations count once:
+	uint64_t placed[MOVE_STATE_COUNT / 64];
+
+	uint32_t placement_count;
+	uint16_t placements[MAX_PLACEMENT_COUNT];
+} Move_Generator;
+
+void initialize_move_tables(void);
+uint32_t generate_placements(Move_Generator*, const Board*, Tetromino, enum Rotation_System);
+uint32_t generate_game_placements(Move_Generator*, const Game_State*);
+Tetromino get_placement(const Move_Generator*, uint32_t);
+uint32_t get_placement_path(const Move_Generator*, uint32_t, uint8_t*, uint32_t);
+
+#endif
@@ -0,0 +1,179 @@
+/* ISMET BARAN SURUCU -- github.com/baransrc */
+#include "tetris_perft.h"
+#include "tetris_platform.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct Perft_Worker
+{
+	// Index of the next root placement to count, shared by all workers:
+	volatile int64_t* next_root;
+	const Game_State* root;
+	const Move_Generator* root_generator;
+	uint32_t depth;
+	// One generator per remaining depth, so nothing is allocated during the search:
+	Move_Generator* generators;
+	Perft_Result result;
+	Thread thread;
+} Perft_Worker;
+
+// Internal ---------------------
+static void run_perft_worker(void*);
+// ------------------------------
+
+void count_perft(Game_State* game_state, uint32_t depth, Move_Generator* generators, Perft_Result* result)
+{
+	// The caller has counted this position already:
+	if (depth == 0)
+	{
+		result->leaf_count++;
+		return;
+	}
+
+	Move_Generator* generator = &generators[0];
+	uint32_t placement_count = generate_game_placements(generator, game_state);
+
+	// Children one level above the leaves are counted, not played:
+	if (depth == 1)
+	{
+		result->leaf_count += placement_count;
+		result->node_count += placement_count;
+		return;
+	}
+
+	Game_State child;
+
+	for (uint32_t i = 0; i < placement_count; ++i)
+	{
+		fork_game_state(&child, game_state);
+		place_tetromino(&child, get_placement(generator, i));
+
+		result->node_count++;
+
+		if (child.game_phase == GAME_PHASE_GAMEOVER)
+		{
+			result->game_over_count++;
+			continue;
+		}
+
+		count_perft(&child, depth - 1, generators + 1, result);
+	}
+}
+
+static void run_perft_worker(void* argument)
+{
+	Perft_Worker* worker = (Perft_Worker*)argument;
+	Game_State child;
+
+	// Root placements are handed out one at a time, faster threads take more of them:
+	for (;;)
+	{
+		int64_t i = atomic_fetch_add_64(worker->next_root, 1);
+
+		if (i >= worker->root_generator->placement_count)
+		{
+			break;
+		}
+
+		fork_game_state(&child, worker->root);
+		place_tetromino(&child, get_placement(worker->root_generator, (uint32_t)i));
+
+		worker->result.node_count++;
+
+		if (child.game_phase == GAME_PHASE_GAMEOVER)
+		{
+			worker->result.game_over_count++;
+			continue;
+		}
+
+		count_perft(&child, worker->depth - 1, worker->generators, &worker->result);
+	}
+}
+
+bool run_perft(uint64_t seed, enum Piece_Randomizer randomizer, uint32_t depth, uint32_t thread_count, Perft_Result* result)
+{
+	Game_State root;
+	Move_Generator* root_generator = malloc(sizeof(Move_Generator));
+	volatile int64_t next_root = 0;
+	bool success = true;
+
+	thread_count = max(thread_count, 1);
+	memset(result, 0, sizeof(*result));
+
+	if (root_generator == NULL || depth == 0 || depth > MAX_PERFT_DEPTH)
+	{
+		free(root_generator);
+		return false;
+	}
+
+	double time_start = get_time_in_seconds();
+
+	initialize_game_state(&root, seed, randomizer);
+	generate_game_placements(root_generator, &root);
+
+	if (depth == 1)
+	{
+		result->leaf_count = root_generator->placement_count;
+		result->node_count = root_generator->placement_count;
+		result->seconds = get_time_in_seconds() - time_start;
+		free(root_generator);
+		return true;
+	}
+
+	Perft_Worker* workers = calloc(thread_count, sizeof(Perft_Worker));
+
+	if (workers == NULL)
+	{
+		free(root_generator);
+		return false;
+	}
+
+	for (uint32_t i = 0; i < thread_count; ++i)
+	{
+		workers[i].next_root = &next_root;
+		workers[i].root = &root;
+		workers[i].root_generator = root_generator;
+		workers[i].depth = depth;
+		workers[i].generators = malloc(sizeof(Move_Generator) * (depth - 1));
+
+		success = success && (workers[i].generators != NULL);
+	}
+
+	if (success)
+	{
+		// Worker 0 runs on this thread, the others share the root placements with it:
+		for (uint32_t i = 1; i < thread_count; ++i)
+		{
+			if (!create_thread(&workers[i].thread, run_perft_worker, &workers[i]))
+			{
+				workers[i].thread.handle = NULL;
+			}
+		}
+
+		run_perft_worker(&workers[0]);
+
+		for (uint32_t i = 1; i < thread_count; ++i)
+		{
+			if (workers[i].thread.handle != NULL)
+			{
+				join_thread(&workers[i].thread);
+			}
+		}
+	}
+
+	for (uint32_t i = 0; i < thread_count; ++i)
+	{
+		result->leaf_count += workers[i].result.leaf_count;
+		result->node_count += workers[i].result.node_count;
+		result->game_over_count += workers[i].result.game_over_count;
+
+		free(workers[i].generators);
+	}
+
+	result->seconds = get_time_in_seconds() - time_start;
+
+	free(workers);
+	free(root_generator);
+
+	return success;
+}
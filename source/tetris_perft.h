@@ -0,0 +1,29 @@
+#ifndef TETRIS_PERFT_H
+#define TETRIS_PERFT_H
+
+// Perft for the move generator: counts every sequence of placements N pieces deep from a new
+// game, locking each one with the rules of update_game_playing_phase. Fixed seeds give fixed
+// counts, so any change in collision, line clear or move generation shows up as a new number.
+
+#include "tetris_core.h"
+#include "tetris_moves.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MAX_PERFT_DEPTH 16
+
+typedef struct Perft_Result
+{
+	// Positions at the full depth, like perft in chess:
+	uint64_t leaf_count;
+	// Every position reached on the way, leaves included:
+	uint64_t node_count;
+	// Placements that ended the game before the full depth:
+	uint64_t game_over_count;
+	double seconds;
+} Perft_Result;
+
+void count_perft(Game_State*, uint32_t, Move_Generator*, Perft_Result*);
+bool run_perft(uint64_t, enum Piece_Randomizer, uint32_t, uint32_t, Perft_Result*);
+
+#endif
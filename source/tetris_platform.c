@@ -0,0 +1,257 @@
+/* ISMET BARAN SURUCU -- github.com/baransrc */
+#ifndef _WIN32
+#define _GNU_SOURCE
+#endif
+
+#include "tetris_platform.h"
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <malloc.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// Internal ---------------------
+#ifdef _WIN32
+static DWORD WINAPI run_thread(LPVOID);
+#else
+static void* run_thread(void*);
+#endif
+// ------------------------------
+
+double get_time_in_seconds(void)
+{
+#ifdef _WIN32
+	LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+
+	return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+	struct timespec time_now;
+
+	clock_gettime(CLOCK_MONOTONIC, &time_now);
+
+	return (double)time_now.tv_sec + (double)time_now.tv_nsec * 1e-9;
+#endif
+}
+
+uint32_t get_cpu_count(void)
+{
+#ifdef _WIN32
+	SYSTEM_INFO system_info;
+
+	GetSystemInfo(&system_info);
+
+	return (uint32_t)system_info.dwNumberOfProcessors;
+#else
+	long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return (cpu_count > 0) ? (uint32_t)cpu_count : 1;
+#endif
+}
+
+#ifdef _WIN32
+static DWORD WINAPI run_thread(LPVOID argument)
+{
+	Thread* thread = (Thread*)argument;
+
+	thread->function(thread->argument);
+
+	return 0;
+}
+#else
+static void* run_thread(void* argument)
+{
+	Thread* thread = (Thread*)argument;
+
+	thread->function(thread->argument);
+
+	return NULL;
+}
+#endif
+
+bool create_thread(Thread* thread, Thread_Function function, void* argument)
+{
+	thread->function = function;
+	thread->argument = argument;
+
+#ifdef _WIN32
+	thread->handle = CreateThread(NULL, 0, run_thread, thread, 0, NULL);
+
+	return thread->handle != NULL;
+#else
+	pthread_t* handle = malloc(sizeof(pthread_t));
+
+	if (handle == NULL)
+	{
+		return false;
+	}
+
+	if (pthread_create(handle, NULL, run_thread, thread) != 0)
+	{
+		free(handle);
+		return false;
+	}
+
+	thread->handle = handle;
+
+	return true;
+#endif
+}
+
+void join_thread(Thread* thread)
+{
+#ifdef _WIN32
+	WaitForSingleObject(thread->handle, INFINITE);
+	CloseHandle(thread->handle);
+#else
+	pthread_join(*(pthread_t*)thread->handle, NULL);
+	free(thread->handle);
+#endif
+
+	thread->handle = NULL;
+}
+
+bool pin_current_thread_to_cpu(uint32_t cpu_index)
+{
+#ifdef _WIN32
+	return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << (cpu_index % (sizeof(DWORD_PTR) * 8))) != 0;
+#elif defined(__linux__)
+	cpu_set_t cpu_set;
+
+	CPU_ZERO(&cpu_set);
+	CPU_SET(cpu_index % CPU_SETSIZE, &cpu_set);
+
+	return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0;
+#else
+	// No affinity API here (MacOS), threads stay unpinned:
+	return false;
+#endif
+}
+
+void* allocate_aligned(size_t alignment, size_t size)
+{
+	// Rounded up, aligned_alloc wants a multiple of the alignment:
+	size = (size + alignment - 1) & ~(alignment - 1);
+
+#ifdef _WIN32
+	return _aligned_malloc(size, alignment);
+#else
+	return aligned_alloc(alignment, size);
+#endif
+}
+
+void free_aligned(void* memory)
+{
+#ifdef _WIN32
+	_aligned_free(memory);
+#else
+	free(memory);
+#endif
+}
+
+bool map_file(Mapped_File* mapped_file, const char* path)
+{
+	mapped_file->data = NULL;
+	mapped_file->size = 0;
+	mapped_file->file_handle = NULL;
+	mapped_file->mapping_handle = NULL;
+
+#ifdef _WIN32
+	LARGE_INTEGER file_size;
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	void* data = (mapping != NULL) ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+
+	if (data == NULL)
+	{
+		if (mapping != NULL)
+		{
+			CloseHandle(mapping);
+		}
+
+		CloseHandle(file);
+		return false;
+	}
+
+	mapped_file->data = data;
+	mapped_file->size = (size_t)file_size.QuadPart;
+	mapped_file->file_handle = file;
+	mapped_file->mapping_handle = mapping;
+
+	return true;
+#else
+	struct stat file_stat;
+	int file = open(path, O_RDONLY);
+
+	if (file < 0)
+	{
+		return false;
+	}
+
+	if (fstat(file, &file_stat) != 0 || file_stat.st_size == 0)
+	{
+		close(file);
+		return false;
+	}
+
+	// The mapping stays valid after the descriptor is closed:
+	void* data = mmap(NULL, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+
+	close(file);
+
+	if (data == MAP_FAILED)
+	{
+		return false;
+	}
+
+	mapped_file->data = data;
+	mapped_file->size = (size_t)file_stat.st_size;
+
+	return true;
+#endif
+}
+
+void unmap_file(Mapped_File* mapped_file)
+{
+	if (mapped_file->data == NULL)
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile(mapped_file->data);
+	CloseHandle(mapped_file->mapping_handle);
+	CloseHandle(mapped_file->file_handle);
+#else
+	munmap((void*)mapped_file->data, mapped_file->size);
+#endif
+
+	mapped_file->data = NULL;
+	mapped_file->size = 0;
+	mapped_file->file_handle = NULL;
+	mapped_file->mapping_handle = NULL;
+}
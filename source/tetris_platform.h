@@ -0,0 +1,80 @@
+#ifndef TETRIS_PLATFORM_H
+#define TETRIS_PLATFORM_H
+
+// Timers, threads, atomics and file mappings for the headless tools, Win32 or POSIX.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef _WIN32
+#include <intrin.h>
+#endif
+
+#define CACHE_LINE_SIZE 64
+
+typedef void (*Thread_Function)(void*);
+
+typedef struct Thread
+{
+	void* handle;
+	Thread_Function function;
+	void* argument;
+} Thread;
+
+// Read-only view of a whole file, pages are loaded as they are touched:
+typedef struct Mapped_File
+{
+	const uint8_t* data;
+	size_t size;
+	void* file_handle;
+	void* mapping_handle;
+} Mapped_File;
+
+double get_time_in_seconds(void);
+uint32_t get_cpu_count(void);
+bool create_thread(Thread*, Thread_Function, void*);
+void join_thread(Thread*);
+bool pin_current_thread_to_cpu(uint32_t);
+void* allocate_aligned(size_t, size_t);
+void free_aligned(void*);
+bool map_file(Mapped_File*, const char*);
+void unmap_file(Mapped_File*);
+
+static inline int64_t atomic_load_64(volatile int64_t* value)
+{
+#ifdef _WIN32
+	return _InterlockedCompareExchange64(value, 0, 0);
+#else
+	return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static inline void atomic_store_64(volatile int64_t* value, int64_t new_value)
+{
+#ifdef _WIN32
+	_InterlockedExchange64(value, new_value);
+#else
+	__atomic_store_n(value, new_value, __ATOMIC_RELEASE);
+#endif
+}
+
+static inline bool atomic_compare_exchange_64(volatile int64_t* value, int64_t expected, int64_t desired)
+{
+#ifdef _WIN32
+	return _InterlockedCompareExchange64(value, desired, expected) == expected;
+#else
+	return __atomic_compare_exchange_n(value, &expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static inline int64_t atomic_fetch_add_64(volatile int64_t* value, int64_t addend)
+{
+#ifdef _WIN32
+	return _InterlockedExchangeAdd64(value, addend);
+#else
+	return __atomic_fetch_add(value, addend, __ATOMIC_ACQ_REL);
+#endif
+}
+
+#endif
@@ -0,0 +1,166 @@
+/* ISMET BARAN SURUCU -- github.com/baransrc */
+#include "tetris_random.h"
+#include <string.h>
+
+// Internal ---------------------
+static inline uint64_t rotate_left(uint64_t, int);
+static inline uint64_t next_split_mix(uint64_t*);
+// ------------------------------
+
+static inline uint64_t rotate_left(uint64_t x, int k)
+{
+	return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t next_split_mix(uint64_t* state)
+{
+	uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+
+	return z ^ (z >> 31);
+}
+
+void seed_random(Random_State* random, uint64_t seed)
+{
+	// SplitMix64 spreads the seed over all 256 bits, the state is never all zero:
+	for (size_t i = 0; i < 4; ++i)
+	{
+		random->s[i] = next_split_mix(&seed);
+	}
+}
+
+uint64_t next_random(Random_State* random)
+{
+	uint64_t* s = random->s;
+	uint64_t result = rotate_left(s[1] * 5, 7) * 9;
+	uint64_t t = s[1] << 17;
+
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+
+	s[2] ^= t;
+	s[3] = rotate_left(s[3], 45);
+
+	return result;
+}
+
+uint32_t random_below(Random_State* random, uint32_t bound)
+{
+	// Lemire's multiply and reject, no modulo bias:
+	uint64_t product = (next_random(random) >> 32) * (uint64_t)bound;
+	uint32_t low = (uint32_t)product;
+
+	if (low < bound)
+	{
+		uint32_t threshold = (0u - bound) % bound;
+
+		while (low < threshold)
+		{
+			product = (next_random(random) >> 32) * (uint64_t)bound;
+			low = (uint32_t)product;
+		}
+	}
+
+	return (uint32_t)(product >> 32);
+}
+
+void jump_random(Random_State* random)
+{
+	// Same as 2^128 calls to next_random, gives 2^128 independent streams from one seed:
+	static const uint64_t JUMP[] = {0x180EC6D33CFD0ABAull, 0xD5A61266F0C9392Cull, 0xA9582618E03FC9AAull, 0x39ABDC4529B1661Cull};
+	uint64_t s[4] = {0, 0, 0, 0};
+
+	for (size_t i = 0; i < 4; ++i)
+	{
+		for (int b = 0; b < 64; ++b)
+		{
+			if (JUMP[i] & (1ull << b))
+			{
+				s[0] ^= random->s[0];
+				s[1] ^= random->s[1];
+				s[2] ^= random->s[2];
+				s[3] ^= random->s[3];
+			}
+
+			next_random(random);
+		}
+	}
+
+	memcpy(random->s, s, sizeof(s));
+}
+
+void generate_pieces(Random_State* random, enum Piece_Randomizer randomizer, uint8_t* pieces, size_t count)
+{
+	if (randomizer == PIECE_RANDOMIZER_BAG)
+	{
+		for (size_t i = 0; i < count; i += TETROMINO_TYPE_COUNT)
+		{
+			uint8_t bag[TETROMINO_TYPE_COUNT] = {0, 1, 2, 3, 4, 5, 6};
+
+			// Fisher-Yates shuffle:
+			for (uint32_t j = TETROMINO_TYPE_COUNT - 1; j > 0; --j)
+			{
+				uint32_t k = random_below(random, j + 1);
+				uint8_t swap = bag[j];
+
+				bag[j] = bag[k];
+				bag[k] = swap;
+			}
+
+			size_t remaining = count - i;
+			memcpy(pieces + i, bag, (remaining < TETROMINO_TYPE_COUNT) ? remaining : TETROMINO_TYPE_COUNT);
+		}
+
+		return;
+	}
+
+	size_t i = 0;
+
+	// 21 three-bit draws per call, dropping 7 leaves 0..6 uniform. Every draw is stored and
+	// only kept ones advance, so there is no branch to mispredict; needs 21 bytes of room:
+	while (i + 21 <= count)
+	{
+		uint64_t bits = next_random(random);
+
+		for (int b = 0; b < 21; ++b, bits >>= 3)
+		{
+			uint8_t piece = (uint8_t)(bits & 7);
+
+			pieces[i] = piece;
+			i += (piece < TETROMINO_TYPE_COUNT);
+		}
+	}
+
+	while (i < count)
+	{
+		uint64_t bits = next_random(random);
+
+		for (int b = 0; b < 21 && i < count; ++b, bits >>= 3)
+		{
+			uint8_t piece = (uint8_t)(bits & 7);
+
+			if (piece < TETROMINO_TYPE_COUNT)
+			{
+				pieces[i++] = piece;
+			}
+		}
+	}
+}
+
+void seed_piece_queue(Piece_Queue* piece_queue, uint64_t seed, enum Piece_Randomizer randomizer)
+{
+	seed_random(&piece_queue->random, seed);
+	piece_queue->randomizer = (uint8_t)randomizer;
+
+	refill_piece_queue(piece_queue);
+}
+
+void refill_piece_queue(Piece_Queue* piece_queue)
+{
+	generate_pieces(&piece_queue->random, (enum Piece_Randomizer)piece_queue->randomizer, piece_queue->pieces, PIECE_QUEUE_SIZE);
+	piece_queue->next = 0;
+}
@@ -0,0 +1,56 @@
+#ifndef TETRIS_RANDOM_H
+#define TETRIS_RANDOM_H
+
+// Seedable xoshiro256** generator and piece sequences built on it. Every game owns
+// its own state, so games can be replayed from a seed and run on any thread.
+
+#include "tetris_board.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Pieces generated per refill, four whole 7-bags:
+#define PIECE_QUEUE_SIZE (TETROMINO_TYPE_COUNT * 4)
+
+enum Piece_Randomizer
+{
+	// Every piece drawn independently, like random_range did:
+	PIECE_RANDOMIZER_UNIFORM,
+	// Every run of 7 pieces is a shuffle of all types:
+	PIECE_RANDOMIZER_BAG,
+};
+
+typedef struct Random_State
+{
+	uint64_t s[4];
+} Random_State;
+
+// Buffer of upcoming pieces, filled in bulk so spawning does not touch the generator.
+// 64 bytes, a single cache line:
+typedef struct Piece_Queue
+{
+	Random_State random;
+	uint8_t pieces[PIECE_QUEUE_SIZE];
+	uint8_t next;
+	uint8_t randomizer;
+} Piece_Queue;
+
+void seed_random(Random_State*, uint64_t);
+uint64_t next_random(Random_State*);
+uint32_t random_below(Random_State*, uint32_t);
+void jump_random(Random_State*);
+void generate_pieces(Random_State*, enum Piece_Randomizer, uint8_t*, size_t);
+void seed_piece_queue(Piece_Queue*, uint64_t, enum Piece_Randomizer);
+void refill_piece_queue(Piece_Queue*);
+
+static inline enum Tetromino_Type next_piece(Piece_Queue* piece_queue)
+{
+	if (piece_queue->next >= PIECE_QUEUE_SIZE)
+	{
+		refill_piece_queue(piece_queue);
+	}
+
+	return (enum Tetromino_Type)piece_queue->pieces[piece_queue->next++];
+}
+
+#endif
@@ -0,0 +1,394 @@
+/* ISMET BARAN SURUCU -- github.com/baransrc */
+#include "tetris_render.h"
+#include <stdlib.h>
+#include <string.h>
+
+// The board does not change between locks, the background never does:
+#define RENDER_BACKGROUND_KEY 1
+static const Color OVERLAY_COLOR = {.r = 0x00, .g = 0x00, .b = 0x00, .a = 0x80};
+
+// Internal ---------------------
+static Render_Command* push_render_command(Render_Command_Buffer*, enum Render_Command_Type, enum Render_Layer);
+static void get_cell_position(int, int, int*, int*);
+static int compare_sort_keys(const void*, const void*);
+static uint32_t pack_color(Color);
+static void blend_pixel(uint32_t*, uint32_t, uint8_t);
+// ------------------------------
+
+static Render_Command* push_render_command(Render_Command_Buffer* buffer, enum Render_Command_Type type, enum Render_Layer layer)
+{
+	// Sized for the largest frame, a full buffer drops what does not fit:
+	if (buffer->command_count == RENDER_COMMAND_CAPACITY)
+	{
+		return NULL;
+	}
+
+	Render_Command* command = &buffer->commands[buffer->command_count++];
+
+	memset(command, 0, sizeof(*command));
+	command->type = (uint8_t)type;
+	command->layer = (uint8_t)layer;
+
+	return command;
+}
+
+static void get_cell_position(int column, int row, int* x_position, int* y_position)
+{
+	*x_position = BOARD_OFFSET_X + (column * TETROMINO_SIZE);
+	*y_position = BOARD_OFFSET_Y + ((BOARD_HEIGHT - 1 - row) * TETROMINO_SIZE);
+}
+
+static int compare_sort_keys(const void* a, const void* b)
+{
+	uint64_t key_a = *(const uint64_t*)a;
+	uint64_t key_b = *(const uint64_t*)b;
+
+	return (key_a > key_b) - (key_a < key_b);
+}
+
+static uint32_t pack_color(Color color)
+{
+	return ((uint32_t)color.a << 24) | ((uint32_t)color.r << 16) | ((uint32_t)color.g << 8) | color.b;
+}
+
+static void blend_pixel(uint32_t* pixel, uint32_t color, uint8_t alpha)
+{
+	uint32_t result = 0xff000000;
+
+	for (int shift = 0; shift < 24; shift += 8)
+	{
+		uint32_t source = (color >> shift) & 0xff;
+		uint32_t destination = (*pixel >> shift) & 0xff;
+
+		result |= ((source * alpha + destination * (255 - alpha)) / 255) << shift;
+	}
+
+	*pixel = result;
+}
+
+void reset_render_commands(Render_Command_Buffer* buffer)
+{
+	buffer->command_count = 0;
+	buffer->cached_layers = 0;
+	memset(buffer->layer_keys, 0, sizeof(buffer->layer_keys));
+}
+
+void push_fill_command(Render_Command_Buffer* buffer, enum Render_Layer layer, int x_position, int y_position, int width, int height, Color color)
+{
+	Render_Command* command = push_render_command(buffer, RENDER_COMMAND_FILL, layer);
+
+	if (command != NULL)
+	{
+		command->color = color;
+		command->x = (int16_t)x_position;
+		command->y = (int16_t)y_position;
+		command->width = (int16_t)width;
+		command->height = (int16_t)height;
+	}
+}
+
+void push_tile_command(Render_Command_Buffer* buffer, enum Render_Layer layer, enum Tile tile, int x_position, int y_position)
+{
+	Render_Command* command = push_render_command(buffer, RENDER_COMMAND_TILE, layer);
+
+	if (command != NULL)
+	{
+		command->id = (uint8_t)tile;
+		command->x = (int16_t)x_position;
+		command->y = (int16_t)y_position;
+		command->width = TETROMINO_SIZE;
+		command->height = TETROMINO_SIZE;
+	}
+}
+
+void push_text_command(Render_Command_Buffer* buffer, enum Render_Text text, uint32_t value)
+{
+	Render_Command* command = push_render_command(buffer, RENDER_COMMAND_TEXT, RENDER_LAYER_TEXT);
+
+	if (command != NULL)
+	{
+		command->id = (uint8_t)text;
+		command->value = value;
+	}
+}
+
+bool build_game_cached_render_commands(const Game_State* game_state, Render_Command_Buffer* buffer)
+{
+	// The layers with a key, in a buffer of their own that is filled again only when a key
+	// changes. Returns whether it was, a buffer starts out reset so the first call fills it:
+	uint32_t cached_layers = (1u << RENDER_LAYER_BACKGROUND) | (1u << RENDER_LAYER_STACK);
+	int x_position;
+	int y_position;
+
+	// Locking and clearing lines are the only changes of the locked cells, and both change the
+	// board hash. Restarts and replay seeks change it as well:
+	if (buffer->cached_layers == cached_layers && buffer->layer_keys[RENDER_LAYER_STACK] == game_state->board_hash)
+	{
+		return false;
+	}
+
+	reset_render_commands(buffer);
+	buffer->cached_layers = cached_layers;
+	buffer->layer_keys[RENDER_LAYER_BACKGROUND] = RENDER_BACKGROUND_KEY;
+	buffer->layer_keys[RENDER_LAYER_STACK] = game_state->board_hash;
+
+	// Empty cells of the whole board, locked cells cover the ones under them:
+
+	for (int i = 0; i < BOARD_WIDTH; ++i)
+	{
+		for (int j = 0; j < BOARD_HEIGHT_RENDERED; ++j)
+		{
+			get_cell_position(i, j, &x_position, &y_position);
+			push_tile_command(buffer, RENDER_LAYER_BACKGROUND, TILE_EMPTY_CELL, x_position, y_position);
+		}
+	}
+
+	for (int i = 0; i < BOARD_WIDTH; ++i)
+	{
+		for (int j = 0; j < BOARD_HEIGHT; ++j)
+		{
+			uint8_t type = get_board_cell(&game_state->board, i, j);
+
+			if (type == EMPTY_CELL_TYPE)
+			{
+				continue;
+			}
+
+			get_cell_position(i, j, &x_position, &y_position);
+			push_tile_command(buffer, RENDER_LAYER_STACK, TILE_CELL + type, x_position, y_position);
+		}
+	}
+
+	sort_render_commands(buffer);
+
+	return true;
+}
+
+void build_game_render_commands(const Game_State* game_state, Render_Command_Buffer* buffer)
+{
+	// Only what moves between locks, the empty grid and locked cells come from
+	// build_game_cached_render_commands:
+	int x_position;
+	int y_position;
+
+	reset_render_commands(buffer);
+
+	// The final destination of the tetromino:
+	if (game_state->game_phase != GAME_PHASE_GAMEOVER)
+	{
+		Tetromino tetromino = game_state->current_tetromino;
+		const Tetromino_Shape* shape = get_tetromino_shape(tetromino);
+
+		for (size_t i = 0; i < TETROMINO_CELL_COUNT; ++i)
+		{
+			int board_x = game_state->current_destination.x + shape->cells[i].x;
+			int board_y = game_state->current_destination.y - shape->cells[i].y;
+
+			if (board_y >= BOARD_HEIGHT_RENDERED)
+			{
+				continue;
+			}
+
+			get_cell_position(board_x, board_y, &x_position, &y_position);
+			push_tile_command(buffer, RENDER_LAYER_DESTINATION, TILE_DESTINATION + tetromino.type, x_position, y_position);
+		}
+	}
+
+	// The falling tetromino is not part of the board, it goes on top:
+	if (is_tetromino_falling(game_state))
+	{
+		Tetromino tetromino = game_state->current_tetromino;
+		const Tetromino_Shape* shape = get_tetromino_shape(tetromino);
+
+		for (size_t i = 0; i < TETROMINO_CELL_COUNT; ++i)
+		{
+			get_cell_position(tetromino.pivot_position.x + shape->cells[i].x, tetromino.pivot_position.y - shape->cells[i].y, &x_position, &y_position);
+			push_tile_command(buffer, RENDER_LAYER_FALLING, TILE_CELL + tetromino.type, x_position, y_position);
+		}
+	}
+
+	// Cleared lines shrink by the ticks left of their animation:
+	for (int j = 0; j < BOARD_HEIGHT_RENDERED; ++j)
+	{
+		if (game_state->tetromino_lines[j] == 0)
+		{
+			continue;
+		}
+
+		float scale = (float)game_state->tetromino_lines[j] / LINE_ANIMATION_TICKS;
+		int size = (int)((float)TETROMINO_SIZE * scale);
+		int delta_half = (TETROMINO_SIZE - size) / 2;
+
+		for (int i = 0; i < BOARD_WIDTH; ++i)
+		{
+			get_cell_position(i, j, &x_position, &y_position);
+			push_fill_command(buffer, RENDER_LAYER_LINES, x_position + delta_half, y_position + delta_half, TETROMINO_SIZE - delta_half*2, TETROMINO_SIZE - delta_half*2, LINE_COLOR);
+		}
+	}
+
+	push_text_command(buffer, RENDER_TEXT_SCORE, game_state->score);
+	push_text_command(buffer, RENDER_TEXT_LINES, game_state->line_count);
+	push_text_command(buffer, RENDER_TEXT_LEVEL, game_state->current_level);
+
+	if (game_state->game_phase == GAME_PHASE_GAMEOVER)
+	{
+		push_fill_command(buffer, RENDER_LAYER_OVERLAY, 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, OVERLAY_COLOR);
+		push_text_command(buffer, RENDER_TEXT_GAME_OVER, 0);
+		push_text_command(buffer, RENDER_TEXT_PLAY_AGAIN, 0);
+	}
+}
+
+void sort_render_commands(Render_Command_Buffer* buffer)
+{
+	uint32_t count = buffer->command_count;
+
+	// Layer, type, tile or text and color from the top bits down, then the index keeps commands
+	// of the same state in the order they came:
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		const Render_Command* command = &buffer->commands[i];
+
+		buffer->sort_keys[i] = ((uint64_t)command->layer << 60) | ((uint64_t)(command->type & 0xf) << 56) | ((uint64_t)command->id << 48) |
+							   ((uint64_t)pack_color(command->color) << 16) | i;
+	}
+
+	qsort(buffer->sort_keys, count, sizeof(uint64_t), compare_sort_keys);
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		buffer->sorted_commands[i] = buffer->commands[buffer->sort_keys[i] & 0xffff];
+	}
+
+	memcpy(buffer->commands, buffer->sorted_commands, count * sizeof(Render_Command));
+}
+
+bool continues_draw_call(const Render_Command* previous, const Render_Command* command)
+{
+	// Fills of a color in a layer are one call for a list of rectangles. Tiles and texts are a
+	// copy each, sorting only keeps copies from the same texture together:
+	if (previous == NULL || previous->layer != command->layer || previous->type != command->type)
+	{
+		return false;
+	}
+
+	switch (command->type)
+	{
+	case RENDER_COMMAND_FILL:
+		return memcmp(&previous->color, &command->color, sizeof(Color)) == 0;
+
+	default:
+		return false;
+	}
+}
+
+uint32_t get_tile_rects(enum Tile tile, Tile_Rect* rects)
+{
+	Tile_Rect inner = {.x = CELL_BEVEL_SIZE, .y = CELL_BEVEL_SIZE, .width = TETROMINO_SIZE - 2 * CELL_BEVEL_SIZE, .height = TETROMINO_SIZE - 2 * CELL_BEVEL_SIZE};
+
+	if (tile < TILE_DESTINATION)
+	{
+		// Dark shadow, light bevel on top and right, mid fill:
+		const Color* colors = COLORS[tile - TILE_CELL];
+
+		rects[0] = (Tile_Rect){.x = 0, .y = 0, .width = TETROMINO_SIZE, .height = TETROMINO_SIZE, .color = colors[2]};
+		rects[1] = (Tile_Rect){.x = CELL_BEVEL_SIZE, .y = 0, .width = TETROMINO_SIZE - CELL_BEVEL_SIZE, .height = TETROMINO_SIZE - CELL_BEVEL_SIZE, .color = colors[0]};
+		rects[2] = inner;
+		rects[2].color = colors[1];
+
+		return 3;
+	}
+
+	// Ghost and empty cells leave their border transparent:
+	rects[0] = inner;
+	rects[0].color = (tile < TILE_EMPTY_CELL) ? COLORS[tile - TILE_DESTINATION][2] : EMPTY_CELL_COLOR;
+
+	return 1;
+}
+
+void submit_render_commands_null(const Render_Command_Buffer* buffer, Render_Stats* stats)
+{
+	const Render_Command* previous = NULL;
+
+	// Counts what a backend would draw, for benchmarks of everything but the drawing:
+	for (uint32_t i = 0; i < buffer->command_count; ++i)
+	{
+		const Render_Command* command = &buffer->commands[i];
+
+		stats->fill_count += (command->type == RENDER_COMMAND_FILL);
+		stats->tile_count += (command->type == RENDER_COMMAND_TILE);
+		stats->text_count += (command->type == RENDER_COMMAND_TEXT);
+		stats->draw_call_count += !continues_draw_call(previous, command);
+		previous = command;
+	}
+
+	stats->command_count += buffer->command_count;
+}
+
+void initialize_software_renderer(Software_Renderer* renderer, uint32_t* pixels, int width, int height)
+{
+	renderer->pixels = pixels;
+	renderer->width = width;
+	renderer->height = height;
+
+	for (int tile = 0; tile < TILE_COUNT; ++tile)
+	{
+		Tile_Rect rects[MAX_TILE_RECT_COUNT];
+		uint32_t rect_count = get_tile_rects((enum Tile)tile, rects);
+
+		memset(renderer->tiles[tile], 0, sizeof(renderer->tiles[tile]));
+
+		for (uint32_t r = 0; r < rect_count; ++r)
+		{
+			uint32_t color = pack_color(rects[r].color);
+
+			for (int y = rects[r].y; y < rects[r].y + rects[r].height; ++y)
+			{
+				for (int x = rects[r].x; x < rects[r].x + rects[r].width; ++x)
+				{
+					renderer->tiles[tile][y * TETROMINO_SIZE + x] = color;
+				}
+			}
+		}
+	}
+}
+
+void submit_render_commands_software(Software_Renderer* renderer, const Render_Command_Buffer* buffer, Render_Stats* stats)
+{
+	submit_render_commands_null(buffer, stats);
+
+	for (uint32_t i = 0; i < buffer->command_count; ++i)
+	{
+		const Render_Command* command = &buffer->commands[i];
+
+		if (command->type == RENDER_COMMAND_TEXT)
+		{
+			continue;
+		}
+
+		int min_x = max(command->x, 0);
+		int min_y = max(command->y, 0);
+		int max_x = min(command->x + command->width, renderer->width);
+		int max_y = min(command->y + command->height, renderer->height);
+
+		for (int y = min_y; y < max_y; ++y)
+		{
+			uint32_t* row = &renderer->pixels[y * renderer->width];
+
+			for (int x = min_x; x < max_x; ++x)
+			{
+				uint32_t color = (command->type == RENDER_COMMAND_FILL) ? pack_color(command->color) :
+								 renderer->tiles[command->id][(y - command->y) * TETROMINO_SIZE + (x - command->x)];
+				uint8_t alpha = (uint8_t)(color >> 24);
+
+				if (alpha == 0xff)
+				{
+					row[x] = color;
+				}
+				else if (alpha != 0)
+				{
+					blend_pixel(&row[x], color, alpha);
+				}
+			}
+		}
+	}
+}
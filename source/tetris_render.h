@@ -0,0 +1,146 @@
+#ifndef TETRIS_RENDER_H
+#define TETRIS_RENDER_H
+
+// What a frame of the game draws, as a list of commands with no renderer behind them. The game
+// fills a Render_Command_Buffer from a Game_State and a backend draws it: SDL in the game, the
+// software and null backends here for tools and benchmarks. Buffers are plain data, so they can
+// be sorted, kept for profiling or filled on another thread than the one that draws them.
+
+#include "tetris_util.h"
+#include "tetris_board.h"
+#include "tetris_core.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SCREEN_WIDTH 384
+#define SCREEN_HEIGHT 768
+#define TETROMINO_SIZE 32
+#define BOARD_OFFSET_X 32
+#define BOARD_OFFSET_Y 32
+// Border around the inner square of a cell, ghost and empty cells only draw the inner square:
+#define CELL_BEVEL_SIZE 3
+#define MAX_TILE_RECT_COUNT 3
+// Every cell of the board twice, the tetromino twice, lines, overlay and texts fit:
+#define RENDER_COMMAND_CAPACITY 1024
+
+// Layers are drawn in order. Commands of one layer may be drawn grouped by their state, so
+// those with different states in the same layer must not overlap. The layers with a key come
+// first, so drawing their buffer and then the one of the frame keeps the order:
+enum Render_Layer
+{
+	RENDER_LAYER_BACKGROUND,
+	RENDER_LAYER_STACK,
+	RENDER_LAYER_DESTINATION,
+	RENDER_LAYER_FALLING,
+	RENDER_LAYER_LINES,
+	RENDER_LAYER_OVERLAY,
+	RENDER_LAYER_TEXT,
+	RENDER_LAYER_COUNT,
+};
+
+enum Render_Command_Type
+{
+	RENDER_COMMAND_FILL,
+	RENDER_COMMAND_TILE,
+	RENDER_COMMAND_TEXT,
+};
+
+// Cell styles, a tetromino cell of each type, then the ghost of each type:
+enum Tile
+{
+	TILE_CELL = 0,
+	TILE_DESTINATION = TETROMINO_TYPE_COUNT,
+	TILE_EMPTY_CELL = 2 * TETROMINO_TYPE_COUNT,
+	TILE_COUNT,
+};
+
+// Texts a backend keeps laid out, commands only refer to them:
+enum Render_Text
+{
+	RENDER_TEXT_SCORE,
+	RENDER_TEXT_LINES,
+	RENDER_TEXT_LEVEL,
+	RENDER_TEXT_GAME_OVER,
+	RENDER_TEXT_PLAY_AGAIN,
+	RENDER_TEXT_COUNT,
+};
+
+// 20 bytes, tiles are TETROMINO_SIZE squares at x, y:
+typedef struct Render_Command
+{
+	uint8_t type;
+	uint8_t layer;
+	// enum Tile of tiles, enum Render_Text of texts:
+	uint8_t id;
+	uint8_t reserved;
+	Color color;
+	int16_t x;
+	int16_t y;
+	int16_t width;
+	int16_t height;
+	// Number a text shows:
+	uint32_t value;
+} Render_Command;
+
+typedef struct Render_Command_Buffer
+{
+	uint32_t command_count;
+	// Bit per layer that only changes when its key does, backends may keep such layers drawn:
+	uint32_t cached_layers;
+	uint64_t layer_keys[RENDER_LAYER_COUNT];
+	Render_Command commands[RENDER_COMMAND_CAPACITY];
+	// Scratch of sort_render_commands:
+	uint64_t sort_keys[RENDER_COMMAND_CAPACITY];
+	Render_Command sorted_commands[RENDER_COMMAND_CAPACITY];
+} Render_Command_Buffer;
+
+// A rectangle a tile is filled with, relative to its top left:
+typedef struct Tile_Rect
+{
+	int16_t x;
+	int16_t y;
+	int16_t width;
+	int16_t height;
+	Color color;
+} Tile_Rect;
+
+// Every backend counts draw calls the same way, a run of fills that continues_draw_call joins
+// counts once and every tile counts on its own. Texts count once, the SDL backend counts a copy per glyph:
+typedef struct Render_Stats
+{
+	uint64_t command_count;
+	uint64_t draw_call_count;
+	uint64_t fill_count;
+	uint64_t tile_count;
+	uint64_t text_count;
+} Render_Stats;
+
+// Draws into 32-bit ARGB pixels. It has no fonts, texts are counted and left out:
+typedef struct Software_Renderer
+{
+	uint32_t* pixels;
+	int width;
+	int height;
+	// Every tile drawn once, like the tile atlas of the SDL backend:
+	uint32_t tiles[TILE_COUNT][TETROMINO_SIZE * TETROMINO_SIZE];
+} Software_Renderer;
+
+// Commands ---------------------
+void reset_render_commands(Render_Command_Buffer*);
+void push_fill_command(Render_Command_Buffer*, enum Render_Layer, int, int, int, int, Color);
+void push_tile_command(Render_Command_Buffer*, enum Render_Layer, enum Tile, int, int);
+void push_text_command(Render_Command_Buffer*, enum Render_Text, uint32_t);
+bool build_game_cached_render_commands(const Game_State*, Render_Command_Buffer*);
+void build_game_render_commands(const Game_State*, Render_Command_Buffer*);
+void sort_render_commands(Render_Command_Buffer*);
+bool continues_draw_call(const Render_Command*, const Render_Command*);
+uint32_t get_tile_rects(enum Tile, Tile_Rect*);
+// ------------------------------
+
+// Backends ---------------------
+void submit_render_commands_null(const Render_Command_Buffer*, Render_Stats*);
+void initialize_software_renderer(Software_Renderer*, uint32_t*, int, int);
+void submit_render_commands_software(Software_Renderer*, const Render_Command_Buffer*, Render_Stats*);
+// ------------------------------
+
+#endif
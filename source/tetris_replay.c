@@ -0,0 +1,707 @@
+/* ISMET BARAN SURUCU -- github.com/baransrc */
+#include "tetris_replay.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+// File layout, little endian: magic, version, randomizer, rotation system, one spare byte,
+// seed (8), tick count (8), fixed gravity (4), event size (8), keyframe interval (4),
+// keyframe count (8), hash interval (4), hash count (8), then the events and the hashes (8 each).
+// Every keyframe follows them as tick (8), event offset (8), event tick (8) and the snapshot:
+// generator (32), pieces, next and randomizer (30), tick count and board hash (8 each), fall
+// progress, fixed gravity, line count and score (4 each), tetromino, destination and previous
+// positions (2 + 2 each), tetromino rotation and type, previous rotation, level, rotation system,
+// phase and spawn flag (1 each), then every board row (2) with its colors (5).
+// Version 1 files end with the events, version 2 files have no hashes, and the keyframes of
+// version 2 and 3 files, which kept Game_Snapshot as it was in memory, are skipped.
+#define REPLAY_FILE_MAGIC "TRPL"
+#define REPLAY_FILE_VERSION 4
+#define REPLAY_FILE_HEADER_SIZE 60
+#define REPLAY_FILE_VERSION_1_HEADER_SIZE 36
+#define REPLAY_FILE_VERSION_2_HEADER_SIZE 48
+#define REPLAY_FILE_SNAPSHOT_SIZE (62 + 32 + 12 + 7 + BOARD_HEIGHT * (2 + BOARD_COLOR_ROW_SIZE))
+#define REPLAY_FILE_KEYFRAME_SIZE (24 + REPLAY_FILE_SNAPSHOT_SIZE)
+#define REPLAY_INITIAL_EVENT_CAPACITY 256
+
+// Internal ---------------------
+static void write_u16(uint8_t*, uint16_t);
+static void write_u32(uint8_t*, uint32_t);
+static void write_u64(uint8_t*, uint64_t);
+static uint16_t read_u16(const uint8_t*);
+static uint32_t read_u32(const uint8_t*);
+static uint64_t read_u64(const uint8_t*);
+static void write_replay_snapshot(uint8_t*, const Game_Snapshot*);
+static bool is_tetromino_on_board(Tetromino);
+static bool read_replay_snapshot(const uint8_t*, Game_Snapshot*);
+static bool record_replay_keyframe(Replay*, const Game_State*);
+static bool record_replay_hash(Replay*, const Game_State*);
+static void read_next_replay_event(Replay_Reader*);
+// ------------------------------
+
+static void write_u32(uint8_t* bytes, uint32_t value)
+{
+	for (int i = 0; i < 4; ++i)
+	{
+		bytes[i] = (uint8_t)(value >> (i * 8));
+	}
+}
+
+static void write_u64(uint8_t* bytes, uint64_t value)
+{
+	for (int i = 0; i < 8; ++i)
+	{
+		bytes[i] = (uint8_t)(value >> (i * 8));
+	}
+}
+
+static uint32_t read_u32(const uint8_t* bytes)
+{
+	uint32_t value = 0;
+
+	for (int i = 0; i < 4; ++i)
+	{
+		value |= (uint32_t)bytes[i] << (i * 8);
+	}
+
+	return value;
+}
+
+static uint64_t read_u64(const uint8_t* bytes)
+{
+	uint64_t value = 0;
+
+	for (int i = 0; i < 8; ++i)
+	{
+		value |= (uint64_t)bytes[i] << (i * 8);
+	}
+
+	return value;
+}
+
+static void write_u16(uint8_t* bytes, uint16_t value)
+{
+	bytes[0] = (uint8_t)value;
+	bytes[1] = (uint8_t)(value >> 8);
+}
+
+static uint16_t read_u16(const uint8_t* bytes)
+{
+	return (uint16_t)(bytes[0] | (bytes[1] << 8));
+}
+
+static void write_replay_snapshot(uint8_t* bytes, const Game_Snapshot* snapshot)
+{
+	// Field by field in the order of REPLAY_FILE_SNAPSHOT_SIZE, so no layout of the struct is saved:
+	const Piece_Queue* piece_queue = &snapshot->piece_queue;
+	const Vector2 positions[3] = {snapshot->current_tetromino.pivot_position, snapshot->current_destination, snapshot->previous_tetromino_position};
+
+	for (int i = 0; i < 4; ++i)
+	{
+		write_u64(bytes, piece_queue->random.s[i]);
+		bytes += 8;
+	}
+
+	memcpy(bytes, piece_queue->pieces, PIECE_QUEUE_SIZE);
+	bytes += PIECE_QUEUE_SIZE;
+	*bytes++ = piece_queue->next;
+	*bytes++ = piece_queue->randomizer;
+
+	write_u64(bytes, snapshot->tick_count);
+	write_u64(bytes + 8, snapshot->board_hash);
+	write_u32(bytes + 16, snapshot->fall_progress);
+	write_u32(bytes + 20, snapshot->fixed_gravity);
+	write_u32(bytes + 24, snapshot->line_count);
+	write_u32(bytes + 28, snapshot->score);
+	bytes += 32;
+
+	for (int i = 0; i < 3; ++i)
+	{
+		write_u16(bytes, (uint16_t)positions[i].x);
+		write_u16(bytes + 2, (uint16_t)positions[i].y);
+		bytes += 4;
+	}
+
+	*bytes++ = snapshot->current_tetromino.rotation;
+	*bytes++ = (uint8_t)snapshot->current_tetromino.type;
+	*bytes++ = snapshot->previous_tetromino_rotation;
+	*bytes++ = snapshot->current_level;
+	*bytes++ = snapshot->rotation_system;
+	*bytes++ = snapshot->game_phase;
+	*bytes++ = snapshot->should_spawn_tetromino;
+
+	// Rows and colors only, the features of the board are counted again on load:
+	for (int j = 0; j < BOARD_HEIGHT; ++j)
+	{
+		write_u16(bytes, snapshot->board.rows[j]);
+		memcpy(bytes + 2, snapshot->board.colors[j], BOARD_COLOR_ROW_SIZE);
+		bytes += 2 + BOARD_COLOR_ROW_SIZE;
+	}
+}
+
+static bool is_tetromino_on_board(Tetromino tetromino)
+{
+	Extents extents = get_tetromino_shape(tetromino)->extents;
+	Vector2 position = tetromino.pivot_position;
+
+	return position.x + extents.min_x >= 0 && position.x + extents.max_x < BOARD_WIDTH &&
+		   position.y - extents.max_y >= 0 && position.y - extents.min_y < BOARD_HEIGHT;
+}
+
+static bool read_replay_snapshot(const uint8_t* bytes, Game_Snapshot* snapshot)
+{
+	// The reverse of write_replay_snapshot. Returns false for anything a game never holds, a
+	// snapshot that passes can be restored and played without reading out of any table:
+	Piece_Queue* piece_queue = &snapshot->piece_queue;
+	Vector2 positions[3];
+	bool valid = true;
+
+	memset(snapshot, 0, sizeof(*snapshot));
+
+	for (int i = 0; i < 4; ++i)
+	{
+		piece_queue->random.s[i] = read_u64(bytes);
+		bytes += 8;
+	}
+
+	memcpy(piece_queue->pieces, bytes, PIECE_QUEUE_SIZE);
+	bytes += PIECE_QUEUE_SIZE;
+	piece_queue->next = *bytes++;
+	piece_queue->randomizer = *bytes++;
+
+	for (int i = 0; i < PIECE_QUEUE_SIZE; ++i)
+	{
+		valid = valid && piece_queue->pieces[i] < TETROMINO_TYPE_COUNT;
+	}
+
+	valid = valid && piece_queue->next <= PIECE_QUEUE_SIZE && piece_queue->randomizer <= PIECE_RANDOMIZER_BAG;
+
+	snapshot->tick_count = read_u64(bytes);
+	snapshot->board_hash = read_u64(bytes + 8);
+	snapshot->fall_progress = read_u32(bytes + 16);
+	snapshot->fixed_gravity = read_u32(bytes + 20);
+	snapshot->line_count = read_u32(bytes + 24);
+	snapshot->score = read_u32(bytes + 28);
+	bytes += 32;
+
+	for (int i = 0; i < 3; ++i)
+	{
+		positions[i].x = (int16_t)read_u16(bytes);
+		positions[i].y = (int16_t)read_u16(bytes + 2);
+		bytes += 4;
+	}
+
+	snapshot->current_tetromino.pivot_position = positions[0];
+	snapshot->current_destination = positions[1];
+	snapshot->previous_tetromino_position = positions[2];
+	snapshot->current_tetromino.rotation = *bytes++;
+	uint8_t type = *bytes++;
+	snapshot->previous_tetromino_rotation = *bytes++;
+	snapshot->current_level = *bytes++;
+	snapshot->rotation_system = *bytes++;
+	snapshot->game_phase = *bytes++;
+	uint8_t should_spawn_tetromino = *bytes++;
+
+	valid = valid && type < TETROMINO_TYPE_COUNT && snapshot->current_tetromino.rotation < TETROMINO_ROTATION_COUNT &&
+			snapshot->previous_tetromino_rotation < TETROMINO_ROTATION_COUNT && snapshot->current_level < LEVEL_COUNT &&
+			snapshot->rotation_system < ROTATION_SYSTEM_COUNT && snapshot->game_phase <= GAME_PHASE_GAMEOVER && should_spawn_tetromino <= 1;
+
+	if (!valid)
+	{
+		return false;
+	}
+
+	snapshot->current_tetromino.type = (enum Tetromino_Type)type;
+	snapshot->should_spawn_tetromino = should_spawn_tetromino;
+
+	// The tetromino is on the board now and was the tick before. The destination is only worked
+	// out before it is used, so it may be left over from an older piece, but it is still a cell:
+	Tetromino previous = snapshot->current_tetromino;
+	Vector2 destination = snapshot->current_destination;
+
+	previous.pivot_position = snapshot->previous_tetromino_position;
+	previous.rotation = snapshot->previous_tetromino_rotation;
+
+	if (!is_tetromino_on_board(snapshot->current_tetromino) || !is_tetromino_on_board(previous) ||
+		destination.x < 0 || destination.x >= BOARD_WIDTH || destination.y < 0 || destination.y >= BOARD_HEIGHT)
+	{
+		return false;
+	}
+
+	// The board is built again cell by cell, its walls and colors have to agree with its rows:
+	clear_board(&snapshot->board);
+
+	for (int j = 0; j < BOARD_HEIGHT; ++j)
+	{
+		uint16_t row = read_u16(bytes);
+		uint8_t colors[BOARD_COLOR_ROW_SIZE];
+
+		memcpy(colors, bytes + 2, BOARD_COLOR_ROW_SIZE);
+		bytes += 2 + BOARD_COLOR_ROW_SIZE;
+
+		if ((row & BOARD_ROW_EMPTY) != BOARD_ROW_EMPTY)
+		{
+			return false;
+		}
+
+		for (int i = 0; i < BOARD_WIDTH; ++i)
+		{
+			uint8_t nibble = (colors[i / 2] >> ((i & 1) * 4)) & 0xf;
+			bool is_filled = (row & BOARD_ROW_BIT(i)) != 0;
+
+			if (is_filled != (nibble != BOARD_COLOR_EMPTY) || (is_filled && nibble >= TETROMINO_TYPE_COUNT))
+			{
+				return false;
+			}
+
+			if (is_filled)
+			{
+				set_board_cell(&snapshot->board, i, j, nibble);
+			}
+		}
+	}
+
+	return hash_board_rows(&snapshot->board, 0, BOARD_HEIGHT - 1) == snapshot->board_hash;
+}
+
+size_t write_varint(uint8_t* bytes, uint64_t value)
+{
+	// Seven bits per byte, lowest first, the high bit tells that more bytes follow:
+	size_t size = 0;
+
+	while (value >= 0x80)
+	{
+		bytes[size++] = (uint8_t)(value | 0x80);
+		value >>= 7;
+	}
+
+	bytes[size++] = (uint8_t)value;
+
+	return size;
+}
+
+size_t read_varint(const uint8_t* bytes, const uint8_t* end, uint64_t* value)
+{
+	// Returns the bytes read, 0 if the varint runs past end or is too long:
+	uint64_t result = 0;
+
+	for (size_t size = 0; size < REPLAY_MAX_VARINT_SIZE && bytes + size < end; ++size)
+	{
+		result |= (uint64_t)(bytes[size] & 0x7f) << (size * 7);
+
+		if ((bytes[size] & 0x80) == 0)
+		{
+			*value = result;
+			return size + 1;
+		}
+	}
+
+	return 0;
+}
+
+bool initialize_replay(Replay* replay, const Game_State* game_state, uint64_t seed, uint32_t keyframe_interval)
+{
+	// Rules are taken from a game that was just initialized with seed:
+	memset(replay, 0, sizeof(*replay));
+
+	replay->header.seed = seed;
+	replay->header.fixed_gravity = game_state->fixed_gravity;
+	replay->header.keyframe_interval = keyframe_interval;
+	replay->header.hash_interval = REPLAY_DEFAULT_HASH_INTERVAL;
+	replay->header.randomizer = game_state->piece_queue.randomizer;
+	replay->header.rotation_system = game_state->rotation_system;
+	replay->events = malloc(REPLAY_INITIAL_EVENT_CAPACITY);
+	replay->event_capacity = REPLAY_INITIAL_EVENT_CAPACITY;
+
+	return replay->events != NULL;
+}
+
+void free_replay(Replay* replay)
+{
+	free(replay->events);
+	free(replay->keyframes);
+	free(replay->hashes);
+
+	memset(replay, 0, sizeof(*replay));
+}
+
+static bool record_replay_keyframe(Replay* replay, const Game_State* game_state)
+{
+	if (replay->keyframe_count == replay->keyframe_capacity)
+	{
+		size_t capacity = max(replay->keyframe_capacity * 2, 16);
+		Replay_Keyframe* keyframes = realloc(replay->keyframes, capacity * sizeof(Replay_Keyframe));
+
+		if (keyframes == NULL)
+		{
+			return false;
+		}
+
+		replay->keyframes = keyframes;
+		replay->keyframe_capacity = capacity;
+	}
+
+	Replay_Keyframe* keyframe = &replay->keyframes[replay->keyframe_count++];
+
+	keyframe->tick = replay->header.tick_count;
+	keyframe->event_offset = replay->event_size;
+	keyframe->event_tick = replay->event_tick;
+	save_game_snapshot(game_state, &keyframe->snapshot);
+
+	return true;
+}
+
+static bool record_replay_hash(Replay* replay, const Game_State* game_state)
+{
+	if (replay->hash_count == replay->hash_capacity)
+	{
+		size_t capacity = max(replay->hash_capacity * 2, 64);
+		uint64_t* hashes = realloc(replay->hashes, capacity * sizeof(uint64_t));
+
+		if (hashes == NULL)
+		{
+			return false;
+		}
+
+		replay->hashes = hashes;
+		replay->hash_capacity = capacity;
+	}
+
+	replay->hashes[replay->hash_count++] = get_game_hash(game_state);
+
+	return true;
+}
+
+bool record_replay_tick(Replay* replay, const Game_State* game_state, uint8_t event)
+{
+	// Called once per tick, before play_replay_event plays it, ticks without events only count.
+	// Change header.hash_interval before the first tick to hash more or less often:
+	uint64_t tick = replay->header.tick_count;
+	uint32_t interval = replay->header.keyframe_interval;
+	uint32_t hash_interval = replay->header.hash_interval;
+
+	if (interval > 0 && tick > 0 && (tick % interval) == 0 && !record_replay_keyframe(replay, game_state))
+	{
+		return false;
+	}
+
+	if (hash_interval > 0 && tick > 0 && (tick % hash_interval) == 0 && !record_replay_hash(replay, game_state))
+	{
+		return false;
+	}
+
+	replay->header.tick_count++;
+
+	if (event == 0)
+	{
+		return true;
+	}
+
+	if (replay->event_size + REPLAY_MAX_VARINT_SIZE > replay->event_capacity)
+	{
+		size_t capacity = replay->event_capacity * 2;
+		uint8_t* events = realloc(replay->events, capacity);
+
+		if (events == NULL)
+		{
+			return false;
+		}
+
+		replay->events = events;
+		replay->event_capacity = capacity;
+	}
+
+	uint64_t value = ((tick - replay->event_tick) << REPLAY_EVENT_BITS) | event;
+
+	replay->event_size += write_varint(replay->events + replay->event_size, value);
+	replay->event_tick = tick;
+
+	return true;
+}
+
+bool save_replay(const Replay* replay, const char* path)
+{
+	uint8_t header[REPLAY_FILE_HEADER_SIZE] = {0};
+
+	memcpy(header, REPLAY_FILE_MAGIC, 4);
+	header[4] = REPLAY_FILE_VERSION;
+	header[5] = replay->header.randomizer;
+	header[6] = replay->header.rotation_system;
+	write_u64(header + 8, replay->header.seed);
+	write_u64(header + 16, replay->header.tick_count);
+	write_u32(header + 24, replay->header.fixed_gravity);
+	write_u64(header + 28, replay->event_size);
+	write_u32(header + 36, replay->header.keyframe_interval);
+	write_u64(header + 40, replay->keyframe_count);
+	write_u32(header + 48, replay->header.hash_interval);
+	write_u64(header + 52, replay->hash_count);
+
+	FILE* file = fopen(path, "wb");
+
+	if (file == NULL)
+	{
+		return false;
+	}
+
+	bool success = fwrite(header, 1, sizeof(header), file) == sizeof(header) &&
+				   fwrite(replay->events, 1, replay->event_size, file) == replay->event_size;
+
+	for (size_t i = 0; i < replay->hash_count && success; ++i)
+	{
+		uint8_t hash[8];
+
+		write_u64(hash, replay->hashes[i]);
+		success = fwrite(hash, 1, sizeof(hash), file) == sizeof(hash);
+	}
+
+	for (size_t i = 0; i < replay->keyframe_count && success; ++i)
+	{
+		const Replay_Keyframe* keyframe = &replay->keyframes[i];
+		uint8_t keyframe_bytes[REPLAY_FILE_KEYFRAME_SIZE];
+
+		write_u64(keyframe_bytes, keyframe->tick);
+		write_u64(keyframe_bytes + 8, keyframe->event_offset);
+		write_u64(keyframe_bytes + 16, keyframe->event_tick);
+		write_replay_snapshot(keyframe_bytes + 24, &keyframe->snapshot);
+
+		success = fwrite(keyframe_bytes, 1, sizeof(keyframe_bytes), file) == sizeof(keyframe_bytes);
+	}
+
+	return (fclose(file) == 0) && success;
+}
+
+bool load_replay(Replay* replay, const char* path)
+{
+	uint8_t header[REPLAY_FILE_HEADER_SIZE];
+	FILE* file = fopen(path, "rb");
+
+	memset(replay, 0, sizeof(*replay));
+
+	if (file == NULL)
+	{
+		return false;
+	}
+
+	memset(header, 0, sizeof(header));
+
+	bool valid = fread(header, 1, REPLAY_FILE_VERSION_1_HEADER_SIZE, file) == REPLAY_FILE_VERSION_1_HEADER_SIZE &&
+				 memcmp(header, REPLAY_FILE_MAGIC, 4) == 0 && header[4] >= 1 && header[4] <= REPLAY_FILE_VERSION;
+
+	if (valid && header[4] >= 2)
+	{
+		size_t header_size = (header[4] == 2) ? REPLAY_FILE_VERSION_2_HEADER_SIZE : REPLAY_FILE_HEADER_SIZE;
+		size_t rest_size = header_size - REPLAY_FILE_VERSION_1_HEADER_SIZE;
+
+		valid = fread(header + REPLAY_FILE_VERSION_1_HEADER_SIZE, 1, rest_size, file) == rest_size;
+	}
+
+	if (!valid)
+	{
+		fclose(file);
+		return false;
+	}
+
+	replay->header.randomizer = header[5];
+	replay->header.rotation_system = header[6];
+	replay->header.seed = read_u64(header + 8);
+	replay->header.tick_count = read_u64(header + 16);
+	replay->header.fixed_gravity = read_u32(header + 24);
+	replay->event_size = (size_t)read_u64(header + 28);
+	replay->header.keyframe_interval = read_u32(header + 36);
+	// Keyframes of versions 2 and 3 hold Game_Snapshot as some build had it in memory, they are left out:
+	replay->keyframe_count = (header[4] == REPLAY_FILE_VERSION) ? (size_t)read_u64(header + 40) : 0;
+	replay->header.hash_interval = read_u32(header + 48);
+	replay->hash_count = (size_t)read_u64(header + 52);
+	replay->hash_capacity = replay->hash_count;
+	replay->hashes = (replay->hash_count > 0) ? calloc(replay->hash_count, sizeof(uint64_t)) : NULL;
+	replay->event_capacity = max(replay->event_size, 1);
+	replay->events = malloc(replay->event_capacity);
+	replay->keyframe_capacity = replay->keyframe_count;
+	replay->keyframes = (replay->keyframe_count > 0) ? calloc(replay->keyframe_count, sizeof(Replay_Keyframe)) : NULL;
+
+	bool success = replay->events != NULL && (replay->keyframes != NULL || replay->keyframe_count == 0) &&
+				   (replay->hashes != NULL || replay->hash_count == 0) &&
+				   fread(replay->events, 1, replay->event_size, file) == replay->event_size;
+
+	for (size_t i = 0; i < replay->hash_count && success; ++i)
+	{
+		uint8_t hash[8];
+
+		success = fread(hash, 1, sizeof(hash), file) == sizeof(hash);
+		replay->hashes[i] = read_u64(hash);
+	}
+
+	for (size_t i = 0; i < replay->keyframe_count && success; ++i)
+	{
+		Replay_Keyframe* keyframe = &replay->keyframes[i];
+		uint8_t keyframe_bytes[REPLAY_FILE_KEYFRAME_SIZE];
+
+		success = fread(keyframe_bytes, 1, sizeof(keyframe_bytes), file) == sizeof(keyframe_bytes) &&
+				  read_replay_snapshot(keyframe_bytes + 24, &keyframe->snapshot);
+
+		keyframe->tick = read_u64(keyframe_bytes);
+		keyframe->event_offset = read_u64(keyframe_bytes + 8);
+		keyframe->event_tick = read_u64(keyframe_bytes + 16);
+
+		// Keyframes come in tick order, and each points inside the events:
+		success = success && keyframe->event_offset <= replay->event_size && keyframe->tick <= replay->header.tick_count &&
+				  (i == 0 || keyframe->tick > replay->keyframes[i - 1].tick);
+	}
+
+	fclose(file);
+
+	if (!success)
+	{
+		free_replay(replay);
+	}
+
+	return success;
+}
+
+static void read_next_replay_event(Replay_Reader* reader)
+{
+	// Decodes the event after the one at event_tick:
+	uint64_t value;
+	size_t size = read_varint(reader->next, reader->end, &value);
+
+	if (size == 0)
+	{
+		reader->event_tick = UINT64_MAX;
+		return;
+	}
+
+	reader->next += size;
+	reader->event_tick += value >> REPLAY_EVENT_BITS;
+	reader->event = (uint8_t)(value & ((1u << REPLAY_EVENT_BITS) - 1));
+}
+
+void start_replay_reader(Replay_Reader* reader, const uint8_t* events, size_t event_size, uint64_t tick_count)
+{
+	reader->next = events;
+	reader->end = events + event_size;
+	reader->tick = 0;
+	reader->tick_count = tick_count;
+	reader->event_tick = 0;
+	reader->event = 0;
+
+	// Deltas count from tick 0 for the first event:
+	read_next_replay_event(reader);
+}
+
+uint8_t read_replay_tick(Replay_Reader* reader)
+{
+	// Event of the next tick, 0 on ticks without one:
+	uint64_t tick = reader->tick++;
+
+	if (tick != reader->event_tick)
+	{
+		return 0;
+	}
+
+	uint8_t event = reader->event;
+
+	read_next_replay_event(reader);
+
+	return event;
+}
+
+void start_replay_game(Game_State* game_state, const Replay_Header* header)
+{
+	initialize_game_state(game_state, header->seed, (enum Piece_Randomizer)header->randomizer);
+
+	game_state->rotation_system = header->rotation_system;
+	game_state->fixed_gravity = header->fixed_gravity;
+}
+
+void play_replay_event(Game_State* game_state, uint8_t event)
+{
+	// One tick, the same way for live games and replays:
+	Input_State input_state;
+
+	if (event & REPLAY_EVENT_SWITCH_ROTATION_SYSTEM)
+	{
+		game_state->rotation_system = (game_state->rotation_system + 1) % ROTATION_SYSTEM_COUNT;
+	}
+
+	set_input_flags(&input_state, event);
+	step_game(game_state, &input_state);
+}
+
+uint64_t play_replay(Game_State* game_state, const Replay* replay)
+{
+	Replay_Reader reader;
+
+	start_replay_game(game_state, &replay->header);
+	start_replay_reader(&reader, replay->events, replay->event_size, replay->header.tick_count);
+
+	while (reader.tick < reader.tick_count)
+	{
+		play_replay_event(game_state, read_replay_tick(&reader));
+	}
+
+	return reader.tick_count;
+}
+
+uint64_t seek_replay(Game_State* game_state, Replay_Reader* reader, const Replay* replay, uint64_t tick)
+{
+	// Leaves the game and reader before the given tick is played, from the last keyframe at or
+	// before it. The reader has to be playing this replay into this game already, from
+	// start_replay_reader or an earlier seek. Returns how many ticks that took to play:
+	uint64_t played_count = 0;
+	const Replay_Keyframe* keyframe = NULL;
+
+	tick = min(tick, replay->header.tick_count);
+
+	if (replay->keyframe_count > 0 && replay->keyframes[0].tick <= tick)
+	{
+		// Keyframes are in tick order, usually every keyframe_interval ticks:
+		size_t low = 0;
+		size_t high = replay->keyframe_count;
+
+		while (high - low > 1)
+		{
+			size_t middle = low + (high - low) / 2;
+
+			if (replay->keyframes[middle].tick <= tick)
+			{
+				low = middle;
+			}
+			else
+			{
+				high = middle;
+			}
+		}
+
+		keyframe = &replay->keyframes[low];
+	}
+
+	// Going on from where the reader is costs less when it is between the keyframe and the tick:
+	bool go_on = reader->tick <= tick && (keyframe == NULL || reader->tick >= keyframe->tick);
+
+	if (!go_on && keyframe == NULL)
+	{
+		start_replay_game(game_state, &replay->header);
+		start_replay_reader(reader, replay->events, replay->event_size, replay->header.tick_count);
+	}
+	else if (!go_on)
+	{
+		start_replay_game(game_state, &replay->header);
+		restore_game_snapshot(game_state, &keyframe->snapshot);
+
+		reader->next = replay->events + keyframe->event_offset;
+		reader->end = replay->events + replay->event_size;
+		reader->tick = keyframe->tick;
+		reader->tick_count = replay->header.tick_count;
+		reader->event_tick = keyframe->event_tick;
+		reader->event = 0;
+
+		read_next_replay_event(reader);
+	}
+
+	while (reader->tick < tick)
+	{
+		play_replay_event(game_state, read_replay_tick(reader));
+		++played_count;
+	}
+
+	return played_count;
+}
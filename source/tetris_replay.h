@@ -0,0 +1,94 @@
+#ifndef TETRIS_REPLAY_H
+#define TETRIS_REPLAY_H
+
+// Recorded games: the seed and rules a game started with, then one event per tick that had
+// any input. Events are varints of (ticks since the last event << REPLAY_EVENT_BITS | event),
+// so an idle stretch costs nothing and a key press usually costs a byte or two.
+// Games go on through restarts, a replay of a session plays every game of it.
+// A replay can also keep a snapshot of the game every keyframe_interval ticks, so seeking to
+// any tick plays at most that many ticks from the keyframe before it, and get_game_hash every
+// hash_interval ticks, so a replay played by another build of the engine can be checked.
+
+#include "tetris_core.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Input flags of the tick, and rule changes the front-end makes between ticks:
+#define REPLAY_EVENT_SWITCH_ROTATION_SYSTEM (1 << 5)
+#define REPLAY_EVENT_BITS 6
+#define REPLAY_MAX_VARINT_SIZE 10
+// Ten seconds, a keyframe costs about as much as ten seconds of busy input:
+#define REPLAY_DEFAULT_KEYFRAME_INTERVAL (10 * TICKS_PER_SECOND)
+// Once a second, 8 bytes:
+#define REPLAY_DEFAULT_HASH_INTERVAL TICKS_PER_SECOND
+
+typedef struct Replay_Header
+{
+	uint64_t seed;
+	uint64_t tick_count;
+	uint32_t fixed_gravity;
+	// Ticks between keyframes, 0 for none:
+	uint32_t keyframe_interval;
+	// Ticks between hashes, 0 for none:
+	uint32_t hash_interval;
+	uint8_t randomizer;
+	uint8_t rotation_system;
+} Replay_Header;
+
+// The game before tick (n + 1) * keyframe_interval is played, and where the events go on from:
+typedef struct Replay_Keyframe
+{
+	uint64_t tick;
+	// Offset of the first event at or after tick, and the tick its delta counts from:
+	uint64_t event_offset;
+	uint64_t event_tick;
+	Game_Snapshot snapshot;
+} Replay_Keyframe;
+
+typedef struct Replay
+{
+	Replay_Header header;
+	// Tick of the last event, the next delta counts from it:
+	uint64_t event_tick;
+	uint8_t* events;
+	size_t event_size;
+	size_t event_capacity;
+	Replay_Keyframe* keyframes;
+	size_t keyframe_count;
+	size_t keyframe_capacity;
+	// Hash i is the game before tick (i + 1) * hash_interval is played:
+	uint64_t* hashes;
+	size_t hash_count;
+	size_t hash_capacity;
+} Replay;
+
+// Walks encoded events tick by tick, without decoding them up front:
+typedef struct Replay_Reader
+{
+	const uint8_t* next;
+	const uint8_t* end;
+	uint64_t tick;
+	uint64_t tick_count;
+	// Next event and its tick, UINT64_MAX once there are none left:
+	uint64_t event_tick;
+	uint8_t event;
+} Replay_Reader;
+
+size_t write_varint(uint8_t*, uint64_t);
+size_t read_varint(const uint8_t*, const uint8_t*, uint64_t*);
+
+bool initialize_replay(Replay*, const Game_State*, uint64_t, uint32_t);
+void free_replay(Replay*);
+bool record_replay_tick(Replay*, const Game_State*, uint8_t);
+bool save_replay(const Replay*, const char*);
+bool load_replay(Replay*, const char*);
+
+void start_replay_reader(Replay_Reader*, const uint8_t*, size_t, uint64_t);
+uint8_t read_replay_tick(Replay_Reader*);
+void start_replay_game(Game_State*, const Replay_Header*);
+void play_replay_event(Game_State*, uint8_t);
+uint64_t play_replay(Game_State*, const Replay*);
+uint64_t seek_replay(Game_State*, Replay_Reader*, const Replay*, uint64_t);
+
+#endif
@@ -0,0 +1,150 @@
+/* ISMET BARAN SURUCU -- github.com/baransrc */
+#include "tetris_rotation.h"
+
+// Clockwise SRS tests of every SRS state, (x, y) with y up:
+#define SRS_KICKS_0R {5, {{0, 0}, {-1, 0}, {-1, 1}, {0, -2}, {-1, -2}}}
+#define SRS_KICKS_R2 {5, {{0, 0}, {1, 0}, {1, -1}, {0, 2}, {1, 2}}}
+#define SRS_KICKS_2L {5, {{0, 0}, {1, 0}, {1, 1}, {0, -2}, {1, -2}}}
+#define SRS_KICKS_L0 {5, {{0, 0}, {-1, 0}, {-1, -1}, {0, 2}, {-1, 2}}}
+// The I states are the SRS states turned about a cell. Their tests are offset[from] - offset[to]
+// of the SRS offset table, the guideline kicks plus the move from that cell to the box centre:
+#define SRS_I_KICKS_0R {5, {{1, 0}, {-1, 0}, {2, 0}, {-1, -1}, {2, 2}}}
+#define SRS_I_KICKS_R2 {5, {{0, -1}, {-1, -1}, {2, -1}, {-1, 1}, {2, -2}}}
+#define SRS_I_KICKS_2L {5, {{-1, 0}, {1, 0}, {-2, 0}, {1, 1}, {-2, -2}}}
+#define SRS_I_KICKS_L0 {5, {{0, 1}, {1, 1}, {-2, 1}, {1, -1}, {-2, 2}}}
+#define NO_KICKS {0, {{0, 0}}}
+
+// Indexed by the rotation the piece turns from. Rotation 0 of T, S and Z is SRS state 2,
+// rotation 1 of J and rotation 3 of L are SRS state 0:
+static const Kick_Table KICK_TABLES[ROTATION_SYSTEM_COUNT][TETROMINO_TYPE_COUNT][TETROMINO_ROTATION_COUNT] =
+{
+	// Simple, walls are handled by push_tetromino_inside_walls:
+	{
+		{NO_KICKS, NO_KICKS, NO_KICKS, NO_KICKS},
+		{NO_KICKS, NO_KICKS, NO_KICKS, NO_KICKS},
+		{NO_KICKS, NO_KICKS, NO_KICKS, NO_KICKS},
+		{NO_KICKS, NO_KICKS, NO_KICKS, NO_KICKS},
+		{NO_KICKS, NO_KICKS, NO_KICKS, NO_KICKS},
+		{NO_KICKS, NO_KICKS, NO_KICKS, NO_KICKS},
+		{NO_KICKS, NO_KICKS, NO_KICKS, NO_KICKS},
+	},
+	// SRS:
+	{
+		{SRS_I_KICKS_0R, SRS_I_KICKS_R2, SRS_I_KICKS_2L, SRS_I_KICKS_L0},
+		{NO_KICKS, NO_KICKS, NO_KICKS, NO_KICKS},
+		{SRS_KICKS_2L, SRS_KICKS_L0, SRS_KICKS_0R, SRS_KICKS_R2},
+		{SRS_KICKS_L0, SRS_KICKS_0R, SRS_KICKS_R2, SRS_KICKS_2L},
+		{SRS_KICKS_R2, SRS_KICKS_2L, SRS_KICKS_L0, SRS_KICKS_0R},
+		{SRS_KICKS_2L, SRS_KICKS_L0, SRS_KICKS_0R, SRS_KICKS_R2},
+		{SRS_KICKS_2L, SRS_KICKS_L0, SRS_KICKS_0R, SRS_KICKS_R2},
+	},
+};
+
+const Kick_Table* get_kick_table(enum Rotation_System rotation_system, enum Tetromino_Type type, uint8_t from_rotation)
+{
+	return &KICK_TABLES[rotation_system][type][from_rotation];
+}
+
+bool push_tetromino_inside_walls(Tetromino* tetromino)
+{
+	// Clamps the pivot to the columns where no cell is beyond a wall, returns if it moved:
+	Extents extents = get_tetromino_shape(*tetromino)->extents;
+	int16_t min_x = -extents.min_x;
+	int16_t max_x = (BOARD_WIDTH - 1) - extents.max_x;
+	int16_t x = tetromino->pivot_position.x;
+
+	tetromino->pivot_position.x = max(min(x, max_x), min_x);
+
+	return tetromino->pivot_position.x != x;
+}
+
+bool kick_rotated_tetromino(const Board* board, Tetromino* tetromino, enum Rotation_System rotation_system)
+{
+	// The tetromino was just turned clockwise. Moves it to the first test of the profile that
+	// fits and returns true, or leaves it turned in place and returns false for the caller to revert:
+	if (rotation_system == ROTATION_SYSTEM_SIMPLE)
+	{
+		if (!does_tetromino_collide(board, *tetromino))
+		{
+			return true;
+		}
+
+		push_tetromino_inside_walls(tetromino);
+		return !does_tetromino_collide(board, *tetromino);
+	}
+
+	uint8_t from_rotation = (tetromino->rotation + TETROMINO_ROTATION_COUNT - 1) % TETROMINO_ROTATION_COUNT;
+	const Kick_Table* kick_table = get_kick_table(rotation_system, tetromino->type, from_rotation);
+
+	for (size_t i = 0; i < kick_table->kick_count; ++i)
+	{
+		Tetromino kicked = *tetromino;
+
+		kicked.pivot_position.x += kick_table->kicks[i].x;
+		kicked.pivot_position.y += kick_table->kicks[i].y;
+
+		if (!does_tetromino_collide(board, kicked))
+		{
+			*tetromino = kicked;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool kick_rotated_tetromino_reference(const Board* board, Tetromino* tetromino, enum Rotation_System rotation_system)
+{
+	// Same tests as kick_rotated_tetromino, a simple rotation that collides moves one column at
+	// a time until no cell is beyond a wall:
+	if (rotation_system == ROTATION_SYSTEM_SIMPLE)
+	{
+		if (!does_tetromino_collide_reference(board, *tetromino))
+		{
+			return true;
+		}
+
+		for (size_t i = 0; i < MAX_TETROMINO_WIDTH; ++i)
+		{
+			for (size_t j = 0; j < MAX_TETROMINO_HEIGHT; ++j)
+			{
+				if (TETROMINOES[tetromino->type][tetromino->rotation][j][i] == 0)
+				{
+					continue;
+				}
+
+				int board_x = tetromino->pivot_position.x + (int)i - TETROMINO_PIVOT_X;
+
+				if (board_x < 0)
+				{
+					tetromino->pivot_position.x -= (int16_t)board_x;
+				}
+				else if (board_x >= BOARD_WIDTH)
+				{
+					tetromino->pivot_position.x -= (int16_t)(board_x - (BOARD_WIDTH - 1));
+				}
+			}
+		}
+
+		return !does_tetromino_collide_reference(board, *tetromino);
+	}
+
+	uint8_t from_rotation = (tetromino->rotation + TETROMINO_ROTATION_COUNT - 1) % TETROMINO_ROTATION_COUNT;
+	const Kick_Table* kick_table = get_kick_table(rotation_system, tetromino->type, from_rotation);
+
+	for (size_t i = 0; i < kick_table->kick_count; ++i)
+	{
+		Tetromino kicked = *tetromino;
+
+		kicked.pivot_position.x += kick_table->kicks[i].x;
+		kicked.pivot_position.y += kick_table->kicks[i].y;
+
+		if (!does_tetromino_collide_reference(board, kicked))
+		{
+			*tetromino = kicked;
+			return true;
+		}
+	}
+
+	return false;
+}
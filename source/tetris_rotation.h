@@ -0,0 +1,44 @@
+#ifndef TETRIS_ROTATION_H
+#define TETRIS_ROTATION_H
+
+// Where a clockwise rotation ends. Every profile is a table of tests per piece and rotation,
+// tried in order until one fits, so a rotation costs a few row mask tests:
+// - ROTATION_SYSTEM_SIMPLE keeps the plain turn, or pushes the piece back inside the walls
+//   when it collides, as the game always did. The batch engine and perft reference counts
+//   follow this profile.
+// - ROTATION_SYSTEM_SRS tries the tests of the Super Rotation System. The pieces keep their
+//   own rotation states, tests are looked up by the SRS state each of them matches. The I
+//   turns about a cell instead of the centre of its box, so its tests are the differences of
+//   the SRS offsets of its states and move it even when the plain turn fits.
+
+#include "tetris_board.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Tests of a rotation, the most any profile has. The first one is the plain turn, (0, 0), for
+// every piece but the SRS I:
+#define MAX_KICK_COUNT 5
+
+enum Rotation_System
+{
+	ROTATION_SYSTEM_SIMPLE,
+	ROTATION_SYSTEM_SRS,
+	ROTATION_SYSTEM_COUNT
+};
+
+typedef struct Kick_Table
+{
+	uint8_t kick_count;
+	// Offsets of the pivot in board cells, y grows upwards as on the board:
+	Cell_Offset kicks[MAX_KICK_COUNT];
+} Kick_Table;
+
+const Kick_Table* get_kick_table(enum Rotation_System, enum Tetromino_Type, uint8_t);
+bool push_tetromino_inside_walls(Tetromino*);
+bool kick_rotated_tetromino(const Board*, Tetromino*, enum Rotation_System);
+
+// Reference implementation, testing kicks cell by cell:
+bool kick_rotated_tetromino_reference(const Board*, Tetromino*, enum Rotation_System);
+
+#endif
@@ -0,0 +1,303 @@
+/* ISMET BARAN SURUCU -- github.com/baransrc */
+#include "tetris_runner.h"
+#include "tetris_platform.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define RUNNER_IDLE_LANE UINT32_MAX
+
+// Queue of a worker, packed as (end << 32 | next) so it can be taken from and stolen with one CAS:
+#define RUNNER_QUEUE(next, end) ((int64_t)(((uint64_t)(end) << 32) | (uint32_t)(next)))
+#define RUNNER_QUEUE_NEXT(queue) ((uint32_t)((uint64_t)(queue) & 0xffffffffu))
+#define RUNNER_QUEUE_END(queue) ((uint32_t)((uint64_t)(queue) >> 32))
+
+typedef struct Runner_Worker
+{
+	// Written by thieves, kept on its own cache line:
+	volatile int64_t queue;
+	uint8_t queue_padding[CACHE_LINE_SIZE - sizeof(int64_t)];
+
+	// Only touched by the worker's own thread:
+	uint32_t index;
+	const Runner_Config* config;
+	union Runner_Worker_Slot* workers;
+	Batch_Engine batch;
+	uint32_t* lane_games;
+	uint32_t* input_random_state;
+	uint8_t* inputs;
+	Runner_Result result;
+	Thread thread;
+} Runner_Worker;
+
+// Rounded up to whole cache lines so neighbouring workers never share one:
+typedef union Runner_Worker_Slot
+{
+	Runner_Worker worker;
+	uint8_t padding[((sizeof(Runner_Worker) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE) * CACHE_LINE_SIZE];
+} Runner_Worker_Slot;
+
+// Internal ---------------------
+static bool take_game(Runner_Worker*, uint32_t*);
+static bool steal_games(Runner_Worker*);
+static uint8_t choose_random_input(uint32_t*);
+static void start_lane_game(Runner_Worker*, uint32_t);
+static void run_worker(void*);
+// ------------------------------
+
+uint64_t get_game_seed(uint64_t seed, uint64_t game_index)
+{
+	// SplitMix64 finalizer, neighbouring games get unrelated seeds:
+	uint64_t z = seed + (game_index + 1) * 0x9E3779B97F4A7C15ull;
+
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+
+	return z ^ (z >> 31);
+}
+
+static bool take_game(Runner_Worker* worker, uint32_t* game_index)
+{
+	for (;;)
+	{
+		int64_t queue = atomic_load_64(&worker->queue);
+		uint32_t next = RUNNER_QUEUE_NEXT(queue);
+		uint32_t end = RUNNER_QUEUE_END(queue);
+
+		if (next >= end)
+		{
+			return false;
+		}
+
+		if (atomic_compare_exchange_64(&worker->queue, queue, RUNNER_QUEUE(next + 1, end)))
+		{
+			*game_index = next;
+			return true;
+		}
+	}
+}
+
+static bool steal_games(Runner_Worker* worker)
+{
+	uint32_t thread_count = worker->config->thread_count;
+
+	// Start with the next worker so thieves spread over victims:
+	for (uint32_t i = 1; i < thread_count; ++i)
+	{
+		Runner_Worker* victim = &worker->workers[(worker->index + i) % thread_count].worker;
+
+		for (;;)
+		{
+			int64_t queue = atomic_load_64(&victim->queue);
+			uint32_t next = RUNNER_QUEUE_NEXT(queue);
+			uint32_t end = RUNNER_QUEUE_END(queue);
+
+			if (next >= end)
+			{
+				break;
+			}
+
+			// Take the back half, at least one game:
+			uint32_t split = end - (end - next + 1) / 2;
+
+			if (atomic_compare_exchange_64(&victim->queue, queue, RUNNER_QUEUE(next, split)))
+			{
+				// Own queue is empty, thieves leave it alone until this store:
+				atomic_store_64(&worker->queue, RUNNER_QUEUE(split, end));
+				worker->result.steal_count++;
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+static uint8_t choose_random_input(uint32_t* state)
+{
+	uint32_t x = *state;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+
+	*state = x;
+
+	// Busy random player, mostly pushing down:
+	switch (x % 8)
+	{
+		case 0: return INPUT_FLAG_LEFT;
+		case 1: return INPUT_FLAG_RIGHT;
+		case 2: return INPUT_FLAG_UP;
+		case 3:
+		case 4: return INPUT_FLAG_DOWN;
+		default: return 0;
+	}
+}
+
+static void start_lane_game(Runner_Worker* worker, uint32_t lane)
+{
+	uint32_t game_index;
+
+	if (!take_game(worker, &game_index) && !(steal_games(worker) && take_game(worker, &game_index)))
+	{
+		// Nothing left anywhere, lane stays in game over:
+		worker->lane_games[lane] = RUNNER_IDLE_LANE;
+		return;
+	}
+
+	uint64_t game_seed = get_game_seed(worker->config->seed, game_index);
+
+	reset_batch_lane(&worker->batch, lane, game_seed);
+	worker->input_random_state[lane] = (uint32_t)(game_seed >> 32) | 1u;
+	worker->lane_games[lane] = game_index;
+}
+
+static void run_worker(void* argument)
+{
+	Runner_Worker* worker = (Runner_Worker*)argument;
+	Batch_Engine* batch = &worker->batch;
+	uint32_t lane_count = batch->lane_count;
+
+	if (worker->config->pin_threads)
+	{
+		pin_current_thread_to_cpu(worker->index);
+	}
+
+	for (uint32_t lane = 0; lane < lane_count; ++lane)
+	{
+		start_lane_game(worker, lane);
+	}
+
+	for (;;)
+	{
+		uint32_t active_lane_count = 0;
+
+		for (uint32_t lane = 0; lane < lane_count; ++lane)
+		{
+			if (worker->lane_games[lane] == RUNNER_IDLE_LANE)
+			{
+				continue;
+			}
+
+			if (batch->game_phase[lane] == GAME_PHASE_GAMEOVER)
+			{
+				worker->result.game_count++;
+				worker->result.line_count += batch->line_count[lane];
+				worker->result.score += batch->score[lane];
+
+				start_lane_game(worker, lane);
+
+				if (worker->lane_games[lane] == RUNNER_IDLE_LANE)
+				{
+					continue;
+				}
+			}
+
+			worker->inputs[lane] = choose_random_input(&worker->input_random_state[lane]);
+			active_lane_count++;
+		}
+
+		if (active_lane_count == 0)
+		{
+			break;
+		}
+
+		step_batch_engine(batch, worker->inputs);
+		worker->result.tick_count += active_lane_count;
+	}
+}
+
+bool run_games(const Runner_Config* config, Runner_Result* result)
+{
+	uint32_t thread_count = max(config->thread_count, 1);
+	uint32_t lane_count = max(config->lane_count, 1);
+	Runner_Config worker_config = *config;
+	bool success = true;
+
+	worker_config.thread_count = thread_count;
+	worker_config.lane_count = lane_count;
+
+	memset(result, 0, sizeof(*result));
+
+	Runner_Worker_Slot* workers = allocate_aligned(CACHE_LINE_SIZE, sizeof(Runner_Worker_Slot) * thread_count);
+
+	if (workers == NULL)
+	{
+		return false;
+	}
+
+	memset(workers, 0, sizeof(Runner_Worker_Slot) * thread_count);
+
+	for (uint32_t i = 0; i < thread_count; ++i)
+	{
+		Runner_Worker* worker = &workers[i].worker;
+		// Even split to begin with, stealing evens out the rest:
+		uint64_t begin = (config->game_count * i) / thread_count;
+		uint64_t end = (config->game_count * (i + 1)) / thread_count;
+
+		worker->index = i;
+		worker->config = &worker_config;
+		worker->workers = workers;
+		worker->queue = RUNNER_QUEUE(begin, end);
+		worker->lane_games = malloc(sizeof(uint32_t) * lane_count);
+		worker->input_random_state = malloc(sizeof(uint32_t) * lane_count);
+		worker->inputs = malloc(lane_count);
+
+		if (worker->lane_games == NULL || worker->input_random_state == NULL || worker->inputs == NULL ||
+			!create_batch_engine(&worker->batch, lane_count))
+		{
+			success = false;
+		}
+	}
+
+	double time_start = get_time_in_seconds();
+
+	if (success)
+	{
+		// Worker 0 runs on this thread:
+		for (uint32_t i = 1; i < thread_count; ++i)
+		{
+			if (!create_thread(&workers[i].worker.thread, run_worker, &workers[i].worker))
+			{
+				// Its games get stolen by the others:
+				workers[i].worker.thread.handle = NULL;
+			}
+		}
+
+		run_worker(&workers[0].worker);
+
+		for (uint32_t i = 1; i < thread_count; ++i)
+		{
+			if (workers[i].worker.thread.handle != NULL)
+			{
+				join_thread(&workers[i].worker.thread);
+			}
+		}
+	}
+
+	result->seconds = get_time_in_seconds() - time_start;
+
+	for (uint32_t i = 0; i < thread_count; ++i)
+	{
+		Runner_Worker* worker = &workers[i].worker;
+
+		result->game_count += worker->result.game_count;
+		result->tick_count += worker->result.tick_count;
+		result->line_count += worker->result.line_count;
+		result->score += worker->result.score;
+		result->steal_count += worker->result.steal_count;
+
+		if (worker->batch.memory != NULL)
+		{
+			destroy_batch_engine(&worker->batch);
+		}
+
+		free(worker->lane_games);
+		free(worker->input_random_state);
+		free(worker->inputs);
+	}
+
+	free_aligned(workers);
+
+	return success;
+}
@@ -0,0 +1,38 @@
+#ifndef TETRIS_RUNNER_H
+#define TETRIS_RUNNER_H
+
+// Plays a number of games on several threads. Every thread owns a batch engine and a
+// queue of game indices, threads that run out of games steal half of another queue.
+// Game i always plays the same way, whichever thread or lane runs it.
+
+#include "tetris_batch.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define RUNNER_DEFAULT_LANE_COUNT 64
+
+typedef struct Runner_Config
+{
+	// At most 2^32 games, queues store 32-bit game indices:
+	uint64_t game_count;
+	uint64_t seed;
+	uint32_t thread_count;
+	// Lanes of the batch engine of every thread:
+	uint32_t lane_count;
+	bool pin_threads;
+} Runner_Config;
+
+typedef struct Runner_Result
+{
+	uint64_t game_count;
+	uint64_t tick_count;
+	uint64_t line_count;
+	uint64_t score;
+	uint64_t steal_count;
+	double seconds;
+} Runner_Result;
+
+uint64_t get_game_seed(uint64_t, uint64_t);
+bool run_games(const Runner_Config*, Runner_Result*);
+
+#endif
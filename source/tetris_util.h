@@ -1,10 +1,19 @@
 #ifndef TETRIS_UTIL_H
 #define TETRIS_UTIL_H
 
-typedef unsigned char uint8_t;
+#include <stdint.h>
 
 #define LEVEL_COUNT 30
 
+// MSVC provides these through stdlib.h, other compilers do not:
+#ifndef max
+#define max(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+
+#ifndef min
+#define min(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+
 typedef struct Color {
 	uint8_t r;
 	uint8_t g;
@@ -13,13 +22,13 @@ typedef struct Color {
 } Color;
 
 
-const Color EMPTY_CELL_COLOR = {.r = 0x16, .g = 0x16, .b = 0x16, .a = 0xff};
-const Color LINE_COLOR = {.r = 0xdb, .g = 0xdb, .b = 0xdb, .a = 0xff};
-const Color TRANSPARENT_COLOR = {.r = 0xff, .g = 0xff, .b = 0xff, .a = 0x00};
+static const Color EMPTY_CELL_COLOR = {.r = 0x16, .g = 0x16, .b = 0x16, .a = 0xff};
+static const Color LINE_COLOR = {.r = 0xdb, .g = 0xdb, .b = 0xdb, .a = 0xff};
+static const Color TRANSPARENT_COLOR = {.r = 0xff, .g = 0xff, .b = 0xff, .a = 0x00};
 
 // Colors By Tetromino Type:
 // Color 0 is light, 1 is mid, 2 is dark.
-const Color COLORS [7 /*type*/][3] =
+static const Color COLORS [7 /*type*/][3] =
 {
 // I
 	{
@@ -66,7 +75,7 @@ const Color COLORS [7 /*type*/][3] =
 };
 
 // Tetromino definitions:
-const uint8_t TETROMINOES [7 /*type*/ ][4 /*rotation*/ ][5/*column*/ ][5 /*row*/ ] =
+static const uint8_t TETROMINOES [7 /*type*/ ][4 /*rotation*/ ][5/*column*/ ][5 /*row*/ ] =
 {
 // I
 	{
@@ -292,7 +301,7 @@ const uint8_t TETROMINOES [7 /*type*/ ][4 /*rotation*/ ][5/*column*/ ][5 /*row*/
    	}
 };
 
-const double FALL_TIME_IN_SECS[LEVEL_COUNT] = {
+static const double FALL_TIME_IN_SECS[LEVEL_COUNT] = {
 	0.8,
 	0.72, 
 	0.635,
@@ -0,0 +1,261 @@
+/* ISMET BARAN SURUCU -- github.com/baransrc */
+#include "tetris_verify.h"
+#include "tetris_platform.h"
+#include <stdlib.h>
+#include <string.h>
+
+// First mismatch of a replay that has none:
+#define VERIFY_NO_MISMATCH INT64_MAX
+
+// The ticks of one replay from one keyframe to the next:
+typedef struct Verify_Segment
+{
+	uint32_t replay_index;
+	uint64_t first_tick;
+	uint64_t end_tick;
+	// Where the segment starts from and what it has to end on, NULL for tick 0 and the end:
+	const Replay_Keyframe* first_keyframe;
+	const Replay_Keyframe* end_keyframe;
+	// Written by the thread that played the segment:
+	uint64_t tick_count;
+	uint64_t checkpoint_count;
+} Verify_Segment;
+
+typedef struct Verify_Context
+{
+	const Replay* replays;
+	Verify_Segment* segments;
+	size_t segment_count;
+	volatile int64_t next_segment;
+	// Earliest mismatch found so far in every replay:
+	volatile int64_t* first_mismatches;
+} Verify_Context;
+
+typedef struct Verify_Worker
+{
+	Verify_Context* context;
+	Thread thread;
+} Verify_Worker;
+
+// Internal ---------------------
+static void report_mismatch(Verify_Context*, uint32_t, uint64_t);
+static void play_segment(Verify_Context*, Verify_Segment*);
+static void run_verify_worker(void*);
+static uint64_t find_last_checkpoint_before(const Replay*, uint64_t);
+// ------------------------------
+
+static void report_mismatch(Verify_Context* context, uint32_t replay_index, uint64_t tick)
+{
+	volatile int64_t* first_mismatch = &context->first_mismatches[replay_index];
+
+	for (;;)
+	{
+		int64_t known = atomic_load_64(first_mismatch);
+
+		if ((int64_t)tick >= known || atomic_compare_exchange_64(first_mismatch, known, (int64_t)tick))
+		{
+			return;
+		}
+	}
+}
+
+static void play_segment(Verify_Context* context, Verify_Segment* segment)
+{
+	const Replay* replay = &context->replays[segment->replay_index];
+	volatile int64_t* first_mismatch = &context->first_mismatches[segment->replay_index];
+	uint64_t hash_interval = replay->header.hash_interval;
+	Game_State game_state;
+	Replay_Reader reader;
+
+	start_replay_game(&game_state, &replay->header);
+	start_replay_reader(&reader, replay->events, replay->event_size, replay->header.tick_count);
+
+	if (segment->first_keyframe != NULL)
+	{
+		seek_replay(&game_state, &reader, replay, segment->first_keyframe->tick);
+	}
+
+	// Hash i is taken before tick (i + 1) * hash_interval, the first at or after the segment start:
+	uint64_t hash_index = (hash_interval == 0 || segment->first_tick == 0) ? 0 : (segment->first_tick + hash_interval - 1) / hash_interval - 1;
+
+	for (;;)
+	{
+		if ((int64_t)reader.tick >= atomic_load_64(first_mismatch))
+		{
+			// An earlier tick of this replay already failed, nothing after it is reported:
+			return;
+		}
+
+		if (hash_interval > 0 && hash_index < replay->hash_count && reader.tick == (hash_index + 1) * hash_interval)
+		{
+			++segment->checkpoint_count;
+
+			if (get_game_hash(&game_state) != replay->hashes[hash_index++])
+			{
+				report_mismatch(context, segment->replay_index, reader.tick);
+				return;
+			}
+		}
+
+		if (reader.tick >= segment->end_tick)
+		{
+			break;
+		}
+
+		play_replay_event(&game_state, read_replay_tick(&reader));
+		++segment->tick_count;
+	}
+
+	if (segment->end_keyframe != NULL)
+	{
+		// The game has to end where the next segment starts from:
+		Game_State keyframe_state;
+
+		start_replay_game(&keyframe_state, &replay->header);
+		restore_game_snapshot(&keyframe_state, &segment->end_keyframe->snapshot);
+		++segment->checkpoint_count;
+
+		if (get_game_hash(&game_state) != get_game_hash(&keyframe_state))
+		{
+			report_mismatch(context, segment->replay_index, reader.tick);
+		}
+	}
+}
+
+static void run_verify_worker(void* argument)
+{
+	Verify_Worker* worker = (Verify_Worker*)argument;
+	Verify_Context* context = worker->context;
+
+	for (;;)
+	{
+		int64_t segment_index = atomic_fetch_add_64(&context->next_segment, 1);
+
+		if (segment_index >= (int64_t)context->segment_count)
+		{
+			return;
+		}
+
+		play_segment(context, &context->segments[segment_index]);
+	}
+}
+
+static uint64_t find_last_checkpoint_before(const Replay* replay, uint64_t tick)
+{
+	// Latest hash or keyframe before tick, tick 0 matches by definition:
+	uint64_t last_tick = 0;
+	uint64_t hash_interval = replay->header.hash_interval;
+
+	if (hash_interval > 0 && tick > hash_interval)
+	{
+		last_tick = min(((tick - 1) / hash_interval) * hash_interval, replay->hash_count * hash_interval);
+	}
+
+	for (size_t i = 0; i < replay->keyframe_count && replay->keyframes[i].tick < tick; ++i)
+	{
+		last_tick = max(last_tick, replay->keyframes[i].tick);
+	}
+
+	return last_tick;
+}
+
+bool verify_replays(const Replay* replays, size_t replay_count, uint32_t thread_count, Replay_Check* checks)
+{
+	Verify_Context context;
+	size_t segment_count = 0;
+
+	thread_count = max(thread_count, 1);
+
+	for (size_t i = 0; i < replay_count; ++i)
+	{
+		segment_count += replays[i].keyframe_count + 1;
+	}
+
+	context.replays = replays;
+	context.segments = calloc(max(segment_count, 1), sizeof(Verify_Segment));
+	context.segment_count = segment_count;
+	context.next_segment = 0;
+	context.first_mismatches = calloc(max(replay_count, 1), sizeof(int64_t));
+
+	Verify_Worker* workers = calloc(thread_count, sizeof(Verify_Worker));
+
+	if (context.segments == NULL || context.first_mismatches == NULL || workers == NULL)
+	{
+		free(context.segments);
+		free((void*)context.first_mismatches);
+		free(workers);
+		return false;
+	}
+
+	// Segments in tick order, so early ticks of every replay are checked first:
+	Verify_Segment* segment = context.segments;
+
+	for (size_t i = 0; i < replay_count; ++i)
+	{
+		const Replay* replay = &replays[i];
+
+		context.first_mismatches[i] = VERIFY_NO_MISMATCH;
+
+		for (size_t j = 0; j <= replay->keyframe_count; ++j, ++segment)
+		{
+			segment->replay_index = (uint32_t)i;
+			segment->first_keyframe = (j > 0) ? &replay->keyframes[j - 1] : NULL;
+			segment->end_keyframe = (j < replay->keyframe_count) ? &replay->keyframes[j] : NULL;
+			segment->first_tick = (j > 0) ? replay->keyframes[j - 1].tick : 0;
+			segment->end_tick = (j < replay->keyframe_count) ? replay->keyframes[j].tick : replay->header.tick_count;
+		}
+	}
+
+	uint32_t started_count = 0;
+
+	for (; started_count < thread_count; ++started_count)
+	{
+		workers[started_count].context = &context;
+
+		if (!create_thread(&workers[started_count].thread, run_verify_worker, &workers[started_count]))
+		{
+			break;
+		}
+	}
+
+	// Without any thread the segments are played here:
+	if (started_count == 0)
+	{
+		workers[0].context = &context;
+		run_verify_worker(&workers[0]);
+	}
+
+	for (uint32_t i = 0; i < started_count; ++i)
+	{
+		join_thread(&workers[i].thread);
+	}
+
+	memset(checks, 0, replay_count * sizeof(Replay_Check));
+
+	for (size_t i = 0; i < segment_count; ++i)
+	{
+		Replay_Check* check = &checks[context.segments[i].replay_index];
+
+		check->tick_count += context.segments[i].tick_count;
+		check->checkpoint_count += context.segments[i].checkpoint_count;
+	}
+
+	for (size_t i = 0; i < replay_count; ++i)
+	{
+		int64_t first_mismatch = context.first_mismatches[i];
+
+		checks[i].diverged = first_mismatch != VERIFY_NO_MISMATCH;
+
+		if (checks[i].diverged)
+		{
+			checks[i].first_diverged_tick = (uint64_t)first_mismatch;
+			checks[i].last_matching_tick = find_last_checkpoint_before(&replays[i], (uint64_t)first_mismatch);
+		}
+	}
+
+	free(context.segments);
+	free((void*)context.first_mismatches);
+	free(workers);
+
+	return true;
+}
@@ -0,0 +1,29 @@
+#ifndef TETRIS_VERIFY_H
+#define TETRIS_VERIFY_H
+
+// Plays recorded games again and checks them against the hashes and keyframes they were
+// recorded with, to prove a change to the engine still plays every game the same. Replays are
+// cut at their keyframes and all pieces run on all threads at once, each from the keyframe it
+// starts at. A piece stops at its first mismatch, and pieces after the earliest mismatch found
+// in their replay are skipped, so the earliest mismatch of every replay is all that is left.
+
+#include "tetris_replay.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct Replay_Check
+{
+	bool diverged;
+	// The game still matched before last_matching_tick was played, and no longer did before
+	// first_diverged_tick. Hashes every tick narrow it down to the tick itself:
+	uint64_t last_matching_tick;
+	uint64_t first_diverged_tick;
+	// Hashes and keyframes compared:
+	uint64_t checkpoint_count;
+	uint64_t tick_count;
+} Replay_Check;
+
+bool verify_replays(const Replay*, size_t, uint32_t, Replay_Check*);
+
+#endif